@@ -45,7 +45,7 @@ client_static_t	cls;
 client_state_t	cl;
 // FIXME: put these on hunk?
 efrag_t			cl_efrags[MAX_EFRAGS];
-entity_t		cl_entities[MAX_EDICTS];
+entity_t		*cl_entities;
 entity_t		cl_static_entities[MAX_STATIC_ENTITIES];
 lightstyle_t	cl_lightstyle[MAX_LIGHTSTYLES];
 dlight_t		cl_dlights[MAX_DLIGHTS];
@@ -63,6 +63,9 @@ void CL_ClearState (void)
 {
 	int			i;
 
+#ifndef GLQUAKE
+	R_SyncView ();		// the render thread may still be drawing from cl
+#endif
 	if (!sv.active)
 		Host_ClearMemory ();
 
@@ -73,7 +76,7 @@ void CL_ClearState (void)
 
 // clear other arrays	
 	memset (cl_efrags, 0, sizeof(cl_efrags));
-	memset (cl_entities, 0, sizeof(cl_entities));
+	Hunk_Release ((byte *)cl_entities, MAX_EDICTS*sizeof(entity_t));
 	memset (cl_dlights, 0, sizeof(cl_dlights));
 	memset (cl_lightstyle, 0, sizeof(cl_lightstyle));
 	memset (cl_temp_entities, 0, sizeof(cl_temp_entities));
@@ -717,6 +720,7 @@ CL_Init
 void CL_Init (void)
 {	
 	SZ_Alloc (&cls.message, 1024);
+	cl_entities = Hunk_Reserve (MAX_EDICTS*sizeof(entity_t), "cl_entities");
 
 	CL_InitInput ();
 	CL_InitTEnts ();
@@ -120,13 +120,20 @@ void CL_ParseStartSoundPacket(void)
 	else
 		attenuation = DEFAULT_SOUND_PACKET_ATTENUATION;
 	
-	channel = MSG_ReadShort ();
+	if ((field_mask & SND_LARGEENTITY) && cl.protocol == PROTOCOL_LARGEENTITY)
+	{
+		ent = (unsigned short)MSG_ReadShort ();
+		channel = MSG_ReadByte ();
+	}
+	else
+	{
+		channel = MSG_ReadShort ();
+		ent = channel >> 3;
+		channel &= 7;
+	}
 	sound_num = MSG_ReadByte ();
 
-	ent = channel >> 3;
-	channel &= 7;
-
-	if (ent > MAX_EDICTS)
+	if (ent >= MAX_EDICTS)
 		Host_Error ("CL_ParseStartSoundPacket: ent = %i", ent);
 	
 	for (i=0 ; i<3 ; i++)
@@ -217,11 +224,12 @@ void CL_ParseServerInfo (void)
 
 // parse protocol version number
 	i = MSG_ReadLong ();
-	if (i != PROTOCOL_VERSION)
+	if (i != PROTOCOL_VERSION && i != PROTOCOL_LARGEENTITY)
 	{
 		Con_Printf ("Server returned version %i, not %i", i, PROTOCOL_VERSION);
 		return;
 	}
+	cl.protocol = i;
 
 // parse maxclients
 	cl.maxclients = MSG_ReadByte ();
@@ -284,6 +292,15 @@ void CL_ParseServerInfo (void)
 //
 // now we try to load everything else until a cache allocation fails
 //
+	if (nummodels > 1)
+		COM_TraceMap (model_precache[1]);
+
+// start reading everything that isn't in memory yet, so the reads overlap
+// with setting up what has already arrived
+	for (i=1 ; i<nummodels ; i++)
+		Mod_Prefetch (model_precache[i]);
+	for (i=1 ; i<numsounds ; i++)
+		S_PrefetchSound (sound_precache[i]);
 
 	for (i=1 ; i<nummodels ; i++)
 	{
@@ -782,7 +799,7 @@ void CL_ParseServerMessage (void)
 		
 		case svc_version:
 			i = MSG_ReadLong ();
-			if (i != PROTOCOL_VERSION)
+			if (i != PROTOCOL_VERSION && i != PROTOCOL_LARGEENTITY)
 				Host_Error ("CL_ParseServerMessage: Server is protocol %i instead of %i\n", i, PROTOCOL_VERSION);
 			break;
 			
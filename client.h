@@ -213,6 +213,7 @@ typedef struct
 	int			viewentity;		// cl_entitites[cl.viewentity] = player
 	int			maxclients;
 	int			gametype;
+	int			protocol;		// PROTOCOL_VERSION or PROTOCOL_LARGEENTITY
 
 // refresh related state
 	struct model_s	*worldmodel;	// cl_entitites[0].model
@@ -276,7 +277,7 @@ extern	client_state_t	cl;
 
 // FIXME, allocate dynamically
 extern	efrag_t			cl_efrags[MAX_EFRAGS];
-extern	entity_t		cl_entities[MAX_EDICTS];
+extern	entity_t		*cl_entities;		// MAX_EDICTS reserved in place
 extern	entity_t		cl_static_entities[MAX_STATIC_ENTITIES];
 extern	lightstyle_t	cl_lightstyle[MAX_LIGHTSTYLES];
 extern	dlight_t		cl_dlights[MAX_DLIGHTS];
@@ -21,6 +21,12 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 #include "quakedef.h"
 
+#ifdef USE_PTHREADS
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
 #define NUM_SAFE_ARGVS  7
 
 static char     *largv[MAX_NUM_ARGVS + NUM_SAFE_ARGVS + 1];
@@ -41,6 +47,7 @@ int             static_registered = 1;  // only for startup check, then set
 qboolean		msg_suppress_1 = 0;
 
 void COM_InitFilesystem (void);
+void Job_Init (void);
 
 // if a packfile directory differs from this, it is assumed to be hacked
 #define PAK0_COUNT              339
@@ -1051,6 +1058,7 @@ void COM_CheckRegistered (void)
 
 
 void COM_Path_f (void);
+void COM_PathStats_f (void);
 
 
 /*
@@ -1160,9 +1168,11 @@ void COM_Init (char *basedir)
 	Cvar_RegisterVariable (&registered);
 	Cvar_RegisterVariable (&cmdline);
 	Cmd_AddCommand ("path", COM_Path_f);
+	Cmd_AddCommand ("pathstats", COM_PathStats_f);
 
 	COM_InitFilesystem ();
 	COM_CheckRegistered ();
+	Job_Init ();
 }
 
 
@@ -1171,20 +1181,26 @@ void COM_Init (char *basedir)
 va
 
 does a varargs printf into a temp buffer, so I don't need to have
-varargs versions of all text functions.
+varargs versions of all text functions.  Each call gets its own copy in
+frame memory, so the result stays good until the end of the frame rather
+than the next va.
 FIXME: make this buffer size safe someday
 ============
 */
 char    *va(char *format, ...)
 {
 	va_list         argptr;
-	static char             string[1024];
+	char            string[1024];
+	char            *out;
+	int             len;
 	
 	va_start (argptr, format);
-	vsprintf (string, format,argptr);
+	len = vsprintf (string, format,argptr);
 	va_end (argptr);
 
-	return string;  
+	out = Frame_Alloc (len+1);
+	memcpy (out, string, len+1);
+	return out;  
 }
 
 
@@ -1218,14 +1234,19 @@ typedef struct
 {
 	char    name[MAX_QPATH];
 	int             filepos, filelen;
+	int             hashnext;       // next file in the same hash chain, -1 = end
 } packfile_t;
 
+#define PACK_HASH_SIZE          1024    // must be a power of two
+
 typedef struct pack_s
 {
 	char    filename[MAX_OSPATH];
 	int             handle;
 	int             numfiles;
 	packfile_t      *files;
+	int             *hashtable;     // PACK_HASH_SIZE chain heads into files
+	byte            *mapbase;       // whole pak mapped into memory, or NULL
 } pack_t;
 
 //
@@ -1258,6 +1279,157 @@ typedef struct searchpath_s
 
 searchpath_t    *com_searchpaths;
 
+//
+// names that were not found anywhere in the search path, so repeated
+// lookups of missing files don't walk every directory again.  This is
+// a direct mapped cache, a collision just throws the old name away.
+//
+#define FILE_MISS_SLOTS         256     // must be a power of two
+
+char    com_filemisses[FILE_MISS_SLOTS][MAX_QPATH];
+
+int             com_findcount;          // total COM_FindFile calls
+int             com_findpak;            // resolved inside a pak file
+int             com_finddir;            // resolved in a directory
+int             com_findfailed;         // not found anywhere
+int             com_findcached;         // not found, answered by com_filemisses
+double          com_findtime;           // seconds spent in COM_FindFile
+
+//
+// -filetrace records every file found to a trace file (or the system
+// console if it can't be written), for make_manifest.py to turn into a
+// prefetch order
+//
+qboolean        com_traceactive;
+FILE            *com_tracefile;
+char            com_tracemap[MAX_QPATH];        // map being loaded or played
+
+pack_t          *com_filepack;          // pak the last found file is in, or NULL
+int             com_filepos;            // offset of the last found file in com_filepack
+char            com_filepath[MAX_OSPATH];       // file the last found file is read from
+
+// background loads, see COM_LoadFileAsync
+qboolean        com_asyncload;          // cleared by -noasyncload
+int             com_loadissued, com_loadused, com_loadwaited;
+double          com_loadwaittime;
+qboolean        com_mappedpaks;         // true if any pak file is memory mapped
+
+/*
+============
+COM_HashFileName
+============
+*/
+unsigned COM_HashFileName (char *name)
+{
+	unsigned        hash;
+
+	hash = 0;
+	while (*name)
+		hash = hash * 31 + *(byte *)name++;
+	return hash;
+}
+
+/*
+============
+COM_FlushFileCache
+
+Forgets all cached failed lookups.  Must be called whenever the search
+path changes or a file that may later be opened through COM_FindFile
+is written.
+============
+*/
+void COM_FlushFileCache (void)
+{
+	memset (com_filemisses, 0, sizeof(com_filemisses));
+}
+
+/*
+============
+COM_TraceFile
+
+Writes one line of the access trace:
+time, map, path opened, name asked for, bytes
+============
+*/
+void COM_TraceFile (char *path, char *name, int len)
+{
+	char    line[MAX_OSPATH*2 + MAX_QPATH + 32];
+
+	if (!com_traceactive)
+		return;
+
+	// don't use va, the name being looked up may be in its buffer
+	sprintf (line, "%.3f\t%s\t%s\t%s\t%i\n", Sys_FloatTime (), com_tracemap,
+		path, name, len);
+	if (com_tracefile)
+	{
+		fputs (line, com_tracefile);
+		fflush (com_tracefile);
+	}
+	else
+		Sys_Printf ("FileTrace: %s", line);
+}
+
+/*
+============
+COM_TraceMap
+
+Files found from now on are attributed to mapname (the world model name)
+============
+*/
+void COM_TraceMap (char *mapname)
+{
+	strncpy (com_tracemap, mapname, sizeof(com_tracemap) - 1);
+}
+
+/*
+============
+COM_FindPackFile
+
+Returns the directory entry for filename inside pak, or NULL
+============
+*/
+packfile_t *COM_FindPackFile (pack_t *pak, char *filename)
+{
+	int             i;
+
+	for (i = pak->hashtable[COM_HashFileName (filename) & (PACK_HASH_SIZE-1)] ;
+		i != -1 ; i = pak->files[i].hashnext)
+	{
+		if (!strcmp (pak->files[i].name, filename))
+			return &pak->files[i];
+	}
+	return NULL;
+}
+
+/*
+============
+COM_PathStats_f
+
+============
+*/
+void COM_PathStats_f (void)
+{
+	if (Cmd_Argc () > 1 && !Q_strcasecmp (Cmd_Argv (1), "clear"))
+	{
+		com_findcount = com_findpak = com_finddir = 0;
+		com_findfailed = com_findcached = 0;
+		com_findtime = 0;
+		com_loadissued = com_loadused = com_loadwaited = 0;
+		com_loadwaittime = 0;
+		return;
+	}
+
+	Con_Printf ("%i file lookups, %.1f ms total", com_findcount, com_findtime * 1000);
+	if (com_findcount)
+		Con_Printf (", %.1f us each", com_findtime * 1000000 / com_findcount);
+	Con_Printf ("\n");
+	Con_Printf ("%i in pak files, %i in directories\n", com_findpak, com_finddir);
+	Con_Printf ("%i not found (%i from the miss cache)\n", com_findfailed, com_findcached);
+	Con_Printf ("%i background loads, %i used, %i waited for (%.1f ms)\n",
+		com_loadissued, com_loadused, com_loadwaited, com_loadwaittime * 1000);
+}
+
 /*
 ============
 COM_Path_f
@@ -1273,7 +1445,8 @@ void COM_Path_f (void)
 	{
 		if (s->pack)
 		{
-			Con_Printf ("%s (%i files)\n", s->pack->filename, s->pack->numfiles);
+			Con_Printf ("%s (%i files%s)\n", s->pack->filename, s->pack->numfiles,
+				s->pack->mapbase ? ", mapped" : "");
 		}
 		else
 			Con_Printf ("%s\n", s->filename);
@@ -1304,6 +1477,8 @@ void COM_WriteFile (char *filename, void *data, int len)
 	Sys_Printf ("COM_WriteFile: %s\n", name);
 	Sys_FileWrite (handle, data, len);
 	Sys_FileClose (handle);
+
+	COM_FlushFileCache ();
 }
 
 
@@ -1365,26 +1540,38 @@ void COM_CopyFile (char *netpath, char *cachepath)
 
 /*
 ===========
-COM_FindFile
+COM_FindFileInPath
 
-Finds the file in the search path.
-Sets com_filesize and one of handle or file
+Does the actual search for COM_FindFile
 ===========
 */
-int COM_FindFile (char *filename, int *handle, FILE **file)
+int COM_FindFileInPath (char *filename, int *handle, FILE **file)
 {
 	searchpath_t    *search;
 	char            netpath[MAX_OSPATH];
 	char            cachepath[MAX_OSPATH];
 	pack_t          *pak;
+	packfile_t      *pakfile;
 	int                     i;
 	int                     findtime, cachetime;
+	char            *miss;
+
+	com_filepack = NULL;
+
+//
+// don't bother walking the path again for a file we know isn't there
+//
+	miss = NULL;
+	if (strlen (filename) < MAX_QPATH)
+	{
+		miss = com_filemisses[COM_HashFileName (filename) & (FILE_MISS_SLOTS-1)];
+		if (!strcmp (miss, filename))
+		{
+			com_findcached++;
+			goto notfound;
+		}
+	}
 
-	if (file && handle)
-		Sys_Error ("COM_FindFile: both handle and file set");
-	if (!file && !handle)
-		Sys_Error ("COM_FindFile: neither handle or file set");
-		
 //
 // search through the path, one element at a time
 //
@@ -1400,26 +1587,32 @@ int COM_FindFile (char *filename, int *handle, FILE **file)
 	// is the element a pak file?
 		if (search->pack)
 		{
-		// look through all the pak file elements
+		// look up the file in the pak directory hash
 			pak = search->pack;
-			for (i=0 ; i<pak->numfiles ; i++)
-				if (!strcmp (pak->files[i].name, filename))
-				{       // found it!
-					Sys_Printf ("PackFile: %s : %s\n",pak->filename, filename);
-					if (handle)
-					{
-						*handle = pak->handle;
-						Sys_FileSeek (pak->handle, pak->files[i].filepos);
-					}
-					else
-					{       // open a new file on the pakfile
-						*file = fopen (pak->filename, "rb");
-						if (*file)
-							fseek (*file, pak->files[i].filepos, SEEK_SET);
-					}
-					com_filesize = pak->files[i].filelen;
-					return com_filesize;
-				}
+			pakfile = COM_FindPackFile (pak, filename);
+			if (!pakfile)
+				continue;
+
+			if (developer.value)
+				Sys_Printf ("PackFile: %s : %s\n",pak->filename, filename);
+			if (handle)
+			{
+				*handle = pak->handle;
+				Sys_FileSeek (pak->handle, pakfile->filepos);
+			}
+			else
+			{       // open a new file on the pakfile
+				*file = fopen (pak->filename, "rb");
+				if (*file)
+					fseek (*file, pakfile->filepos, SEEK_SET);
+			}
+			com_findpak++;
+			com_filepack = pak;
+			com_filepos = pakfile->filepos;
+			strcpy (com_filepath, pak->filename);
+			com_filesize = pakfile->filelen;
+			COM_TraceFile (pak->filename, filename, com_filesize);
+			return com_filesize;
 		}
 		else
 		{               
@@ -1451,7 +1644,8 @@ int COM_FindFile (char *filename, int *handle, FILE **file)
 				strcpy (netpath, cachepath);
 			}	
 
-			Sys_Printf ("FindFile: %s\n",netpath);
+			if (developer.value)
+				Sys_Printf ("FindFile: %s\n",netpath);
 			com_filesize = Sys_FileOpenRead (netpath, &i);
 			if (handle)
 				*handle = i;
@@ -1460,13 +1654,21 @@ int COM_FindFile (char *filename, int *handle, FILE **file)
 				Sys_FileClose (i);
 				*file = fopen (netpath, "rb");
 			}
+			com_finddir++;
+			com_filepos = 0;
+			strcpy (com_filepath, netpath);
+			COM_TraceFile (netpath, filename, com_filesize);
 			return com_filesize;
 		}
 		
 	}
 	
 	Sys_Printf ("FindFile: can't find %s\n", filename);
-	
+	if (miss)
+		strcpy (miss, filename);
+
+notfound:
+	com_findfailed++;
 	if (handle)
 		*handle = -1;
 	else
@@ -1475,6 +1677,32 @@ int COM_FindFile (char *filename, int *handle, FILE **file)
 	return -1;
 }
 
+/*
+===========
+COM_FindFile
+
+Finds the file in the search path.
+Sets com_filesize and one of handle or file
+===========
+*/
+int COM_FindFile (char *filename, int *handle, FILE **file)
+{
+	double          start;
+	int                     len;
+
+	if (file && handle)
+		Sys_Error ("COM_FindFile: both handle and file set");
+	if (!file && !handle)
+		Sys_Error ("COM_FindFile: neither handle or file set");
+
+	start = Sys_FloatTime ();
+	len = COM_FindFileInPath (filename, handle, file);
+	com_findtime += Sys_FloatTime () - start;
+	com_findcount++;
+
+	return len;
+}
+
 
 /*
 ===========
@@ -1522,6 +1750,605 @@ void COM_CloseFile (int h)
 }
 
 
+/*
+=============================================================================
+
+ASYNCHRONOUS LOADING
+
+COM_LoadFileAsync looks a file up on the main thread and hands the read to a
+pool of I/O threads, so a whole precache list can be read while the main
+thread decodes the files that have already arrived.  A later COM_LoadFile of
+the same path takes the data from the finished load, waiting for it if it is
+still being read.  Files in memory mapped paks aren't copied; the I/O threads
+just touch their pages so they are resident by the time COM_MapFile hands
+them out.
+
+Only the main thread uses the file system and the memory allocators; the I/O
+threads read with their own file descriptors into malloced buffers.  Platforms
+without pthreads load everything synchronously.
+
+=============================================================================
+*/
+
+#define MAX_ASYNC_LOADS         512
+#define ASYNC_LOAD_THREADS      2
+#define ASYNC_LOAD_BUDGET       (32*1024*1024)  // bytes read ahead but not yet used
+
+typedef enum {LOAD_FREE, LOAD_QUEUED, LOAD_READING, LOAD_DONE} loadstate_t;
+
+typedef struct
+{
+	loadstate_t     state;
+	int             sequence;               // I/O threads take the oldest load first
+	char            name[MAX_QPATH];
+	char            filepath[MAX_OSPATH];   // file to read it from
+	int             filepos;
+	int             filelen;
+	byte            *mapped;                // in a mapped pak, only touched
+	byte            *data;                  // NULL if the read failed
+} asyncload_t;
+
+#ifdef USE_PTHREADS
+asyncload_t     com_loads[MAX_ASYNC_LOADS];
+int             com_loadsequence;
+int             com_loadbytes;          // read (or being read) but not yet used
+qboolean        com_loadthreads;
+
+// everything above is guarded by com_loadlock
+pthread_mutex_t com_loadlock = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t  com_loadqueued = PTHREAD_COND_INITIALIZER;     // new work or budget
+pthread_cond_t  com_loaddone = PTHREAD_COND_INITIALIZER;
+
+/*
+============
+COM_ReadLoad
+
+Runs on an I/O thread.  Returns a malloced, 0 terminated copy of the file, or
+NULL if it couldn't be read.
+============
+*/
+byte *COM_ReadLoad (asyncload_t *load)
+{
+	int             fd, count, r;
+	byte    *data;
+
+	data = malloc (load->filelen + 1);
+	if (!data)
+		return NULL;
+	fd = open (load->filepath, O_RDONLY);
+	if (fd == -1)
+	{
+		free (data);
+		return NULL;
+	}
+	count = 0;
+	if (lseek (fd, load->filepos, SEEK_SET) == load->filepos)
+	{
+		for ( ; count < load->filelen ; count += r)
+		{
+			r = read (fd, data + count, load->filelen - count);
+			if (r <= 0)
+				break;
+		}
+	}
+	close (fd);
+	if (count < load->filelen)
+	{
+		free (data);
+		return NULL;
+	}
+	data[load->filelen] = 0;
+	return data;
+}
+
+/*
+============
+COM_LoadThread
+============
+*/
+void *COM_LoadThread (void *unused)
+{
+	asyncload_t     *load, *l;
+	int             i;
+	byte    *data;
+	volatile byte   touch;
+
+	pthread_mutex_lock (&com_loadlock);
+	while (1)
+	{
+	// take the oldest queued load, if it fits in the budget
+		load = NULL;
+		for (i=0, l=com_loads ; i<MAX_ASYNC_LOADS ; i++, l++)
+			if (l->state == LOAD_QUEUED && (!load || l->sequence < load->sequence))
+				load = l;
+		if (!load || (!load->mapped && com_loadbytes
+		&& com_loadbytes + load->filelen + 1 > ASYNC_LOAD_BUDGET))
+		{
+			pthread_cond_wait (&com_loadqueued, &com_loadlock);
+			continue;
+		}
+		load->state = LOAD_READING;
+		if (!load->mapped)
+			com_loadbytes += load->filelen + 1;
+		pthread_mutex_unlock (&com_loadlock);
+
+		data = NULL;
+		if (load->mapped)
+		{
+			for (i=0 ; i<load->filelen ; i+=4096)
+				touch = load->mapped[i];
+			(void)touch;
+		}
+		else
+			data = COM_ReadLoad (load);
+
+		pthread_mutex_lock (&com_loadlock);
+		if (load->mapped)
+		{
+		// nobody waits for these
+			load->state = LOAD_FREE;
+			continue;
+		}
+		if (!data)
+			com_loadbytes -= load->filelen + 1;
+		load->data = data;
+		load->state = LOAD_DONE;
+		pthread_cond_broadcast (&com_loaddone);
+	}
+	return NULL;
+}
+
+/*
+============
+COM_StartLoadThreads
+
+com_loadlock must be held
+============
+*/
+qboolean COM_StartLoadThreads (void)
+{
+	pthread_t       thread;
+	int             i;
+
+	if (com_loadthreads)
+		return true;
+	for (i=0 ; i<ASYNC_LOAD_THREADS ; i++)
+	{
+		if (pthread_create (&thread, NULL, COM_LoadThread, NULL))
+			break;
+		pthread_detach (thread);
+	}
+	if (!i)
+	{
+		Con_Printf ("Couldn't start file loading threads\n");
+		com_asyncload = false;
+		return false;
+	}
+	com_loadthreads = true;
+	return true;
+}
+
+/*
+============
+COM_FindLoad
+
+com_loadlock must be held
+============
+*/
+asyncload_t *COM_FindLoad (char *path)
+{
+	int             i;
+	asyncload_t     *load;
+
+	for (i=0, load=com_loads ; i<MAX_ASYNC_LOADS ; i++, load++)
+		if (load->state != LOAD_FREE && !strcmp (load->name, path))
+			return load;
+	return NULL;
+}
+#endif
+
+/*
+============
+COM_LoadFileAsync
+
+Starts reading path in the background.  Returns a handle for
+COM_LoadFileReady, or -1 if the file wasn't found or can't be loaded
+asynchronously, which is harmless: COM_LoadFile will just read it itself.
+============
+*/
+int COM_LoadFileAsync (char *path)
+{
+#ifdef USE_PTHREADS
+	int             h, i;
+	byte    *mapped;
+	asyncload_t     *load;
+
+	if (!com_asyncload || strlen (path) >= MAX_QPATH)
+		return -1;
+
+	pthread_mutex_lock (&com_loadlock);
+	load = COM_FindLoad (path);
+	pthread_mutex_unlock (&com_loadlock);
+	if (load)
+		return load - com_loads;
+
+// find the file here, the search path isn't thread safe
+	COM_OpenFile (path, &h);
+	if (h == -1)
+		return -1;
+	COM_CloseFile (h);
+	mapped = NULL;
+	if (com_filepack && com_filepack->mapbase)
+		mapped = com_filepack->mapbase + com_filepos;
+
+	pthread_mutex_lock (&com_loadlock);
+	for (i=0, load=com_loads ; i<MAX_ASYNC_LOADS ; i++, load++)
+		if (load->state == LOAD_FREE)
+			break;
+	if (i == MAX_ASYNC_LOADS || !COM_StartLoadThreads ())
+	{
+		pthread_mutex_unlock (&com_loadlock);
+		return -1;
+	}
+	strcpy (load->name, path);
+	strcpy (load->filepath, com_filepath);
+	load->filepos = com_filepos;
+	load->filelen = com_filesize;
+	load->mapped = mapped;
+	load->data = NULL;
+	load->sequence = com_loadsequence++;
+	load->state = LOAD_QUEUED;
+	pthread_cond_broadcast (&com_loadqueued);
+	pthread_mutex_unlock (&com_loadlock);
+
+	com_loadissued++;
+	return i;
+#else
+	return -1;
+#endif
+}
+
+/*
+============
+COM_LoadFileReady
+
+Returns true once the load has finished (or was used already)
+============
+*/
+qboolean COM_LoadFileReady (int handle)
+{
+#ifdef USE_PTHREADS
+	qboolean        ready;
+
+	if (handle < 0 || handle >= MAX_ASYNC_LOADS)
+		return true;
+	pthread_mutex_lock (&com_loadlock);
+	ready = com_loads[handle].state == LOAD_FREE || com_loads[handle].state == LOAD_DONE;
+	pthread_mutex_unlock (&com_loadlock);
+	return ready;
+#else
+	return true;
+#endif
+}
+
+/*
+============
+COM_TakeLoad
+
+Returns the data of an asynchronous load of path, waiting for it if it is
+still being read, and sets com_filesize.  Returns NULL if there is no such
+load or it failed, and the caller should read the file itself.  The data
+must be given back with COM_FreeLoad.
+============
+*/
+byte *COM_TakeLoad (char *path)
+{
+#ifdef USE_PTHREADS
+	asyncload_t     *load;
+	byte    *data;
+	double  start;
+
+	if (!com_loadthreads)
+		return NULL;
+
+	pthread_mutex_lock (&com_loadlock);
+	load = COM_FindLoad (path);
+	if (!load || load->mapped)
+	{
+		pthread_mutex_unlock (&com_loadlock);
+		return NULL;
+	}
+	if (load->state == LOAD_QUEUED)
+	{
+	// not started yet, so it's quicker to read it straight into place
+		load->state = LOAD_FREE;
+		pthread_mutex_unlock (&com_loadlock);
+		return NULL;
+	}
+	if (load->state == LOAD_READING)
+	{
+		start = Sys_FloatTime ();
+		while (load->state == LOAD_READING)
+			pthread_cond_wait (&com_loaddone, &com_loadlock);
+		com_loadwaittime += Sys_FloatTime () - start;
+		com_loadwaited++;
+	}
+	data = load->data;
+	if (data)
+	{
+		com_filesize = load->filelen;
+		com_loadused++;
+	}
+	load->state = LOAD_FREE;
+	pthread_mutex_unlock (&com_loadlock);
+	return data;
+#else
+	return NULL;
+#endif
+}
+
+/*
+============
+COM_FreeLoad
+============
+*/
+void COM_FreeLoad (byte *data, int len)
+{
+#ifdef USE_PTHREADS
+	free (data);
+	pthread_mutex_lock (&com_loadlock);
+	com_loadbytes -= len + 1;
+	pthread_cond_broadcast (&com_loadqueued);
+	pthread_mutex_unlock (&com_loadlock);
+#endif
+}
+
+/*
+============
+COM_FlushLoads
+
+Throws away every load that hasn't been used
+============
+*/
+void COM_FlushLoads (void)
+{
+#ifdef USE_PTHREADS
+	int             i;
+	asyncload_t     *load;
+
+	if (!com_loadthreads)
+		return;
+
+	pthread_mutex_lock (&com_loadlock);
+	for (i=0, load=com_loads ; i<MAX_ASYNC_LOADS ; i++, load++)
+	{
+		if (load->mapped || load->state == LOAD_FREE)
+			continue;
+		while (load->state == LOAD_READING)
+			pthread_cond_wait (&com_loaddone, &com_loadlock);
+		if (load->data)
+		{
+			free (load->data);
+			com_loadbytes -= load->filelen + 1;
+			load->data = NULL;
+		}
+		load->state = LOAD_FREE;
+	}
+	pthread_cond_broadcast (&com_loadqueued);
+	pthread_mutex_unlock (&com_loadlock);
+#endif
+}
+
+/*
+=============================================================================
+
+WORKER THREADS
+
+Splits CPU work across cores.  The main thread queues a batch of jobs with
+Job_Add, each one a function run over part of a range of items, and Job_Wait
+helps run them until the whole batch is done.  Jobs must not use the hunk,
+zone, cache, file system or console.  There is one batch at a time: a
+thread that starts one while the render thread has its own going waits in
+Job_Add for it to finish.
+
+With -threads 0, or without pthreads, Job_Add runs the jobs right away.
+
+=============================================================================
+*/
+
+#define MAX_JOBS                256
+#define MAX_JOB_THREADS         8
+
+typedef struct
+{
+	jobfunc_t       func;
+	void            *data;
+	int             first, count;
+} job_t;
+
+int             com_jobthreads;
+
+#ifdef USE_PTHREADS
+job_t           com_jobs[MAX_JOBS];
+int             com_numjobs;            // queued in this batch
+int             com_nextjob;            // next one to hand out
+int             com_jobsdone;
+
+// everything above is guarded by com_joblock
+pthread_mutex_t com_joblock = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t  com_jobqueued = PTHREAD_COND_INITIALIZER;
+pthread_cond_t  com_jobsfinished = PTHREAD_COND_INITIALIZER;
+
+// held from a thread's first Job_Add until its Job_Wait
+pthread_mutex_t com_batchlock = PTHREAD_MUTEX_INITIALIZER;
+__thread qboolean com_inbatch;
+
+/*
+============
+Job_RunOne
+
+Runs the next job of the batch.  com_joblock must be held; it is released
+while the job runs.
+============
+*/
+void Job_RunOne (void)
+{
+	job_t   job;
+
+	job = com_jobs[com_nextjob++];
+	pthread_mutex_unlock (&com_joblock);
+	job.func (job.data, job.first, job.count);
+	pthread_mutex_lock (&com_joblock);
+	if (++com_jobsdone == com_numjobs)
+		pthread_cond_broadcast (&com_jobsfinished);
+}
+
+/*
+============
+Job_Thread
+============
+*/
+void *Job_Thread (void *unused)
+{
+	Frame_InitThread ("job");
+
+	pthread_mutex_lock (&com_joblock);
+	while (1)
+	{
+		if (com_nextjob < com_numjobs)
+			Job_RunOne ();
+		else
+		{
+			Frame_Reset ();		// nothing a job returned can still be in use
+			pthread_cond_wait (&com_jobqueued, &com_joblock);
+		}
+	}
+	return NULL;
+}
+#endif
+
+/*
+============
+Job_Init
+============
+*/
+void Job_Init (void)
+{
+#ifdef USE_PTHREADS
+	pthread_t       thread;
+	int             i, want;
+
+//
+// -threads <count> sets the number of worker threads, 0 runs everything on
+// the main thread
+//
+	i = COM_CheckParm ("-threads");
+	if (i && i < com_argc-1)
+		want = Q_atoi (com_argv[i+1]);
+	else
+	{
+#ifdef _SC_NPROCESSORS_ONLN
+		want = sysconf (_SC_NPROCESSORS_ONLN) - 1;
+#else
+		want = 1;
+#endif
+	}
+	if (want > MAX_JOB_THREADS)
+		want = MAX_JOB_THREADS;
+
+	for (com_jobthreads=0 ; com_jobthreads<want ; com_jobthreads++)
+	{
+		if (pthread_create (&thread, NULL, Job_Thread, NULL))
+			break;
+		pthread_detach (thread);
+	}
+#endif
+	Con_Printf ("%i worker threads\n", com_jobthreads);
+}
+
+/*
+============
+Job_NumThreads
+
+Returns the number of worker threads, 0 if jobs run on the main thread
+============
+*/
+int Job_NumThreads (void)
+{
+	return com_jobthreads;
+}
+
+/*
+============
+Job_Add
+
+Queues func over items [0, count), split into jobs of at most chunk items
+============
+*/
+void Job_Add (jobfunc_t func, void *data, int count, int chunk)
+{
+	int             first, n;
+
+	if (chunk < 1)
+		chunk = count;
+	for (first=0 ; first<count ; first+=chunk)
+	{
+		n = count - first;
+		if (n > chunk)
+			n = chunk;
+#ifdef USE_PTHREADS
+		if (com_jobthreads)
+		{
+			if (!com_inbatch)
+			{
+				pthread_mutex_lock (&com_batchlock);
+				com_inbatch = true;
+			}
+			pthread_mutex_lock (&com_joblock);
+			if (com_numjobs < MAX_JOBS)
+			{
+				com_jobs[com_numjobs].func = func;
+				com_jobs[com_numjobs].data = data;
+				com_jobs[com_numjobs].first = first;
+				com_jobs[com_numjobs].count = n;
+				com_numjobs++;
+				pthread_cond_signal (&com_jobqueued);
+				pthread_mutex_unlock (&com_joblock);
+				continue;
+			}
+			pthread_mutex_unlock (&com_joblock);
+		}
+#endif
+		func (data, first, n);
+	}
+}
+
+/*
+============
+Job_Wait
+
+Helps run the batch, and returns once every job in it has finished
+============
+*/
+void Job_Wait (void)
+{
+#ifdef USE_PTHREADS
+	if (!com_inbatch)
+		return;
+
+	pthread_mutex_lock (&com_joblock);
+	while (com_nextjob < com_numjobs)
+		Job_RunOne ();
+	while (com_jobsdone < com_numjobs)
+		pthread_cond_wait (&com_jobsfinished, &com_joblock);
+	com_numjobs = com_nextjob = com_jobsdone = 0;
+	pthread_mutex_unlock (&com_joblock);
+
+	com_inbatch = false;
+	pthread_mutex_unlock (&com_batchlock);
+#endif
+}
+
 /*
 ============
 COM_LoadFile
@@ -1536,16 +2363,26 @@ int             loadsize;
 byte *COM_LoadFile (char *path, int usehunk)
 {
 	int             h;
-	byte    *buf;
+	byte    *buf, *data;
 	char    base[32];
 	int             len;
 
 	buf = NULL;     // quiet compiler warning
 
-// look for it in the filesystem or pack files
-	len = COM_OpenFile (path, &h);
-	if (h == -1)
-		return NULL;
+// use a background load of it if there is one
+	data = COM_TakeLoad (path);
+	if (data)
+	{
+		len = com_filesize;
+		h = -1;
+	}
+	else
+	{
+	// look for it in the filesystem or pack files
+		len = COM_OpenFile (path, &h);
+		if (h == -1)
+			return NULL;
+	}
 	
 // extract the filename base name for hunk tag
 	COM_FileBase (path, base);
@@ -1573,6 +2410,13 @@ byte *COM_LoadFile (char *path, int usehunk)
 		
 	((byte *)buf)[len] = 0;
 
+	if (data)
+	{
+		memcpy (buf, data, len);
+		COM_FreeLoad (data, len);
+		return buf;
+	}
+
 	Draw_BeginDisc ();
 	Sys_FileRead (h, buf, len);                     
 	COM_CloseFile (h);
@@ -1609,6 +2453,40 @@ byte *COM_LoadStackFile (char *path, void *buffer, int bufsize)
 	return buf;
 }
 
+/*
+============
+COM_MapFile
+
+If the file is inside a memory mapped pak file, returns a pointer straight
+into the mapping and sets com_filesize.  Returns NULL if the file isn't
+found or isn't mapped, and the caller should fall back to COM_LoadFile.
+
+The data is not 0 terminated, and it is read only: the mapping is shared by
+every load of the file, and writing to it faults.  A file is only handed
+out if it starts past the pak header, so there are always mapped bytes in
+front of it for the AVX2 colormap gathers in d_simd.c.
+============
+*/
+byte *COM_MapFile (char *path)
+{
+	int             h;
+
+	if (!com_mappedpaks)
+		return NULL;
+
+	COM_OpenFile (path, &h);
+	if (h == -1)
+		return NULL;
+	COM_CloseFile (h);
+
+	if (!com_filepack || !com_filepack->mapbase)
+		return NULL;
+	if (com_filepos < (int)sizeof(dpackheader_t))
+		return NULL;		// overlaps the header, a broken pak
+
+	return com_filepack->mapbase + com_filepos;
+}
+
 /*
 =================
 COM_LoadPackFile
@@ -1629,8 +2507,12 @@ pack_t *COM_LoadPackFile (char *packfile)
 	int                             packhandle;
 	dpackfile_t             info[MAX_FILES_IN_PACK];
 	unsigned short          crc;
+	int                             *hashtable;
+	int                             hash;
+	int                             packlen;
 
-	if (Sys_FileOpenRead (packfile, &packhandle) == -1)
+	packlen = Sys_FileOpenRead (packfile, &packhandle);
+	if (packlen == -1)
 	{
 //              Con_Printf ("Couldn't open %s\n", packfile);
 		return NULL;
@@ -1670,11 +2552,30 @@ pack_t *COM_LoadPackFile (char *packfile)
 		newfiles[i].filelen = LittleLong(info[i].filelen);
 	}
 
+// hash the directory, walking backwards so the first of any duplicate
+// names ends up at the head of its chain, like the old linear search
+	hashtable = Hunk_AllocName (PACK_HASH_SIZE * sizeof(int), "packhash");
+	for (i=0 ; i<PACK_HASH_SIZE ; i++)
+		hashtable[i] = -1;
+	for (i=numpackfiles-1 ; i>=0 ; i--)
+	{
+		hash = COM_HashFileName (newfiles[i].name) & (PACK_HASH_SIZE-1);
+		newfiles[i].hashnext = hashtable[hash];
+		hashtable[hash] = i;
+	}
+
 	pack = Hunk_Alloc (sizeof (pack_t));
 	strcpy (pack->filename, packfile);
 	pack->handle = packhandle;
 	pack->numfiles = numpackfiles;
 	pack->files = newfiles;
+	pack->hashtable = hashtable;
+
+// -nommap keeps reading lumps through the file handle
+	if (!COM_CheckParm ("-nommap"))
+		pack->mapbase = Sys_FileMap (packhandle, packlen);
+	if (pack->mapbase)
+		com_mappedpaks = true;
 	
 	Con_Printf ("Added packfile %s (%i files)\n", packfile, numpackfiles);
 	return pack;
@@ -1721,6 +2622,8 @@ void COM_AddGameDirectory (char *dir)
 		com_searchpaths = search;               
 	}
 
+	COM_FlushFileCache ();
+
 //
 // add the contents of the parms.txt file to the end of the command line
 //
@@ -1821,10 +2724,32 @@ void COM_InitFilesystem (void)
 			search->next = com_searchpaths;
 			com_searchpaths = search;
 		}
+		COM_FlushFileCache ();
 	}
 
 	if (COM_CheckParm ("-proghack"))
 		proghack = true;
+
+//
+// -filetrace [<file>]
+// Records every file found, see make_manifest.py
+//
+	i = COM_CheckParm ("-filetrace");
+	if (i)
+	{
+		com_traceactive = true;
+		if (i < com_argc-1 && com_argv[i+1][0] != '-' && com_argv[i+1][0] != '+')
+			com_tracefile = fopen (com_argv[i+1], "w");
+		else
+			com_tracefile = fopen (va("%s/filetrace.txt", com_gamedir), "w");
+		if (!com_tracefile)
+			Sys_Printf ("Couldn't open the file trace, tracing to the console\n");
+	}
+
+//
+// -noasyncload reads every file when it is asked for
+//
+	com_asyncload = !COM_CheckParm ("-noasyncload");
 }
 
 
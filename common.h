@@ -171,11 +171,26 @@ void COM_WriteFile (char *filename, void *data, int len);
 int COM_OpenFile (char *filename, int *hndl);
 int COM_FOpenFile (char *filename, FILE **file);
 void COM_CloseFile (int h);
+void COM_FlushFileCache (void);
+void COM_TraceMap (char *mapname);
 
 byte *COM_LoadStackFile (char *path, void *buffer, int bufsize);
 byte *COM_LoadTempFile (char *path);
 byte *COM_LoadHunkFile (char *path);
 void COM_LoadCacheFile (char *path, struct cache_user_s *cu);
+byte *COM_MapFile (char *path);
+
+// jobs are run over items [first, first+count) of a range, possibly on
+// another thread
+typedef void (*jobfunc_t) (void *data, int first, int count);
+
+int Job_NumThreads (void);
+void Job_Add (jobfunc_t func, void *data, int count, int chunk);
+void Job_Wait (void);
+
+int COM_LoadFileAsync (char *path);
+qboolean COM_LoadFileReady (int handle);
+void COM_FlushLoads (void);
 
 
 extern	struct cvar_s	registered;
@@ -385,6 +385,11 @@ void Con_Printf (char *fmt, ...)
 	va_start (argptr,fmt);
 	vsprintf (msg,fmt,argptr);
 	va_end (argptr);
+
+#ifndef GLQUAKE
+	if (R_DeferPrint (msg))
+		return;		// printed by the main thread once the view is done
+#endif
 	
 // also echo to debugging console
 	Sys_Printf ("%s", msg);	// also echo to debugging console
@@ -75,6 +75,16 @@ void CRC_ProcessByte(unsigned short *crcvalue, byte data)
 	*crcvalue = (*crcvalue << 8) ^ crctable[(*crcvalue >> 8) ^ data];
 }
 
+void CRC_Block(unsigned short *crcvalue, byte *data, int len)
+{
+	unsigned short	crc;
+
+	crc = *crcvalue;
+	while (len-- > 0)
+		crc = (crc << 8) ^ crctable[(crc >> 8) ^ *data++];
+	*crcvalue = crc;
+}
+
 unsigned short CRC_Value(unsigned short crcvalue)
 {
 	return crcvalue ^ CRC_XOR_VALUE;
@@ -21,4 +21,5 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 void CRC_Init(unsigned short *crcvalue);
 void CRC_ProcessByte(unsigned short *crcvalue, byte data);
+void CRC_Block(unsigned short *crcvalue, byte *data, int len);
 unsigned short CRC_Value(unsigned short crcvalue);
@@ -80,14 +80,14 @@ D_DrawSolidSurface
 
 // FIXME: clean this up
 
-void D_DrawSolidSurface (surf_t *surf, int color)
+void D_DrawSolidSpans (espan_t *pspans, int color)
 {
 	espan_t	*span;
 	byte	*pdest;
 	int		u, u2, pix;
 	
 	pix = (color<<24) | (color<<16) | (color<<8) | color;
-	for (span=surf->spans ; span ; span=span->pnext)
+	for (span=pspans ; span ; span=span->pnext)
 	{
 		pdest = (byte *)d_viewbuffer + screenwidth*span->v;
 		u = span->u;
@@ -114,6 +114,11 @@ void D_DrawSolidSurface (surf_t *surf, int color)
 	}
 }
 
+void D_DrawSolidSurface (surf_t *surf, int color)
+{
+	D_DrawSolidSpans (surf->spans, color);
+}
+
 
 /*
 ==============
@@ -168,10 +173,10 @@ void D_CalcGradients (msurface_t *pface)
 
 /*
 ==============
-D_DrawSurfaces
+D_DrawSurfacesSerial
 ==============
 */
-void D_DrawSurfaces (void)
+void D_DrawSurfacesSerial (void)
 {
 	surf_t			*s;
 	msurface_t		*pface;
@@ -196,7 +201,7 @@ void D_DrawSurfaces (void)
 			d_ziorigin = s->d_ziorigin;
 
 			D_DrawSolidSurface (s, (int)s->data & 0xFF);
-			D_DrawZSpans (s->spans);
+			(*d_drawzspans) (s->spans);
 		}
 	}
 	else
@@ -220,7 +225,7 @@ void D_DrawSurfaces (void)
 				}
 
 				D_DrawSkyScans8 (s->spans);
-				D_DrawZSpans (s->spans);
+				(*d_drawzspans) (s->spans);
 			}
 			else if (s->flags & SURF_DRAWBACKGROUND)
 			{
@@ -231,7 +236,7 @@ void D_DrawSurfaces (void)
 				d_ziorigin = -0.9;
 
 				D_DrawSolidSurface (s, (int)r_clearcolor.value & 0xFF);
-				D_DrawZSpans (s->spans);
+				(*d_drawzspans) (s->spans);
 			}
 			else if (s->flags & SURF_DRAWTURB)
 			{
@@ -257,8 +262,10 @@ void D_DrawSurfaces (void)
 				}
 
 				D_CalcGradients (pface);
-				Turbulent8 (s->spans);
-				D_DrawZSpans (s->spans);
+				(*d_drawturbulent) (s->spans);
+				if (d_spanrecord)
+					D_RecordSpans (s->spans, true);
+				(*d_drawzspans) (s->spans);
 
 				if (s->insubmodel)
 				{
@@ -305,8 +312,10 @@ void D_DrawSurfaces (void)
 				D_CalcGradients (pface);
 
 				(*d_drawspans) (s->spans);
+				if (d_spanrecord)
+					D_RecordSpans (s->spans, false);
 
-				D_DrawZSpans (s->spans);
+				(*d_drawzspans) (s->spans);
 
 				if (s->insubmodel)
 				{
@@ -329,3 +338,441 @@ void D_DrawSurfaces (void)
 	}
 }
 
+
+/*
+==============
+D_SaveDrawState
+==============
+*/
+void D_SaveDrawState (drawstate_t *st)
+{
+	st->d_zistepu = d_zistepu;
+	st->d_zistepv = d_zistepv;
+	st->d_ziorigin = d_ziorigin;
+	st->d_sdivzstepu = d_sdivzstepu;
+	st->d_sdivzstepv = d_sdivzstepv;
+	st->d_sdivzorigin = d_sdivzorigin;
+	st->d_tdivzstepu = d_tdivzstepu;
+	st->d_tdivzstepv = d_tdivzstepv;
+	st->d_tdivzorigin = d_tdivzorigin;
+	st->sadjust = sadjust;
+	st->tadjust = tadjust;
+	st->bbextents = bbextents;
+	st->bbextentt = bbextentt;
+	st->cacheblock = cacheblock;
+	st->cachewidth = cachewidth;
+}
+
+/*
+==============
+D_LoadDrawState
+==============
+*/
+void D_LoadDrawState (drawstate_t *st)
+{
+	d_zistepu = st->d_zistepu;
+	d_zistepv = st->d_zistepv;
+	d_ziorigin = st->d_ziorigin;
+	d_sdivzstepu = st->d_sdivzstepu;
+	d_sdivzstepv = st->d_sdivzstepv;
+	d_sdivzorigin = st->d_sdivzorigin;
+	d_tdivzstepu = st->d_tdivzstepu;
+	d_tdivzstepv = st->d_tdivzstepv;
+	d_tdivzorigin = st->d_tdivzorigin;
+	sadjust = st->sadjust;
+	tadjust = st->tadjust;
+	bbextents = st->bbextents;
+	bbextentt = st->bbextentt;
+	cacheblock = st->cacheblock;
+	cachewidth = st->cachewidth;
+}
+
+/*
+===============================================================================
+
+BANDED DRAWING
+
+The edge scan stays serial, but once every surface has its spans the surfaces
+no longer overlap on screen, so the drawing can be split into horizontal bands
+of the view and the bands handed to the job threads.  The main thread first
+walks the surfaces in the serial order and does everything that touches shared
+state (bmodel rotation, sky, surface cache allocation, gradients), saving the
+span drawers' inputs for each one; the span drawers' globals are per thread
+(D_THREADLOCAL), so each band loads them back before drawing.  The surface
+cache misses found on the way are queued rather than built, and are all built
+on the job threads before the bands are drawn (D_RunSurfaceBuilds).
+
+Building a surface can evict or rebuild in place a cache block an earlier
+surface in the same frame is still going to draw from.  Serially that is
+harmless, because the earlier surface has already been drawn; here it is
+checked for after the setup pass and the frame is redrawn serially instead.
+
+Banding is off unless d_bands is set, as the gain over the serial path, once
+the setup pass, the binning and the serial redraws are paid for, hasn't been
+measured yet.  bandstats shows how often the fallback is taken and how long
+the frames took either way, to compare with timedemo.
+
+===============================================================================
+*/
+
+#define	MAX_BANDS	32
+
+typedef enum {DS_SKY, DS_BACKGROUND, DS_TURB, DS_TEXTURED} drawkind_t;
+
+typedef struct
+{
+	drawkind_t	kind;
+	qboolean	insubmodel;
+	qboolean	rebuilt;		// D_CacheSurface drew into the cache
+	msurface_t	*pface;
+	int			miplevel;
+	surfcache_t	*cache;
+
+	drawstate_t	state;
+
+	espan_t		*spans[MAX_BANDS];
+} bandsurf_t;
+
+typedef struct
+{
+	bandsurf_t	*surfs;
+	int			numsurfs;
+} bandbatch_t;
+
+static byte	d_bandforv[MAXHEIGHT];
+
+// for bandstats
+static int		d_bandframes, d_bandfallbacks, d_serialframes;
+static double	d_bandtime, d_serialtime;
+
+/*
+==============
+D_NumBands
+==============
+*/
+static int D_NumBands (void)
+{
+	int		bands;
+
+#if defined(USE_PTHREADS) && !id386
+	if (!Job_NumThreads ())
+		return 1;
+
+	bands = (int)d_bands.value;
+	if (bands <= 0)
+		bands = 4 * (Job_NumThreads () + 1);	// a few per thread to even out
+	if (bands > MAX_BANDS)
+		bands = MAX_BANDS;
+	if (bands > r_refdef.vrect.height)
+		bands = r_refdef.vrect.height;
+	if (bands < 1)
+		bands = 1;
+#else
+	bands = 1;		// the assembly drawers keep their state in plain globals
+#endif
+
+	return bands;
+}
+
+/*
+==============
+D_SetupSurfaces
+
+Does the serial part of D_DrawSurfacesSerial for every surface, in the same
+order, without drawing anything.  Returns the number of surfaces with spans.
+==============
+*/
+static int D_SetupSurfaces (bandsurf_t *surfs)
+{
+	surf_t			*s;
+	msurface_t		*pface;
+	bandsurf_t		*ds;
+	int				oldc_surf;
+	vec3_t			world_transformed_modelorg;
+	vec3_t			local_modelorg;
+
+	currententity = &cl_entities[0];
+	TransformVector (modelorg, transformed_modelorg);
+	VectorCopy (transformed_modelorg, world_transformed_modelorg);
+
+	ds = surfs;
+	for (s = &surfaces[1] ; s<surface_p ; s++)
+	{
+		if (!s->spans)
+			continue;
+
+		r_drawnpolycount++;
+
+		ds->insubmodel = s->insubmodel;
+		ds->rebuilt = false;
+		ds->pface = NULL;
+		ds->cache = NULL;
+		ds->spans[0] = s->spans;
+
+		d_zistepu = s->d_zistepu;
+		d_zistepv = s->d_zistepv;
+		d_ziorigin = s->d_ziorigin;
+
+		if (s->flags & SURF_DRAWSKY)
+		{
+			if (!r_skymade)
+				R_MakeSky ();
+			ds->kind = DS_SKY;
+		}
+		else if (s->flags & SURF_DRAWBACKGROUND)
+		{
+			d_zistepu = 0;
+			d_zistepv = 0;
+			d_ziorigin = -0.9;
+			ds->kind = DS_BACKGROUND;
+		}
+		else
+		{
+			if (s->insubmodel)
+			{
+				currententity = s->entity;
+				VectorSubtract (r_origin, currententity->origin, local_modelorg);
+				TransformVector (local_modelorg, transformed_modelorg);
+				R_RotateBmodel ();
+			}
+
+			pface = s->data;
+			ds->pface = pface;
+			if (s->flags & SURF_DRAWTURB)
+			{
+				ds->kind = DS_TURB;
+				miplevel = 0;
+				cacheblock = (pixel_t *)
+						((byte *)pface->texinfo->texture +
+						pface->texinfo->texture->offsets[0]);
+				cachewidth = 64;
+			}
+			else
+			{
+				ds->kind = DS_TEXTURED;
+				miplevel = D_MipLevelForScale (s->nearzi * scale_for_mip
+				* pface->texinfo->mipadjust);
+
+				oldc_surf = c_surf;
+				ds->cache = D_CacheSurface (pface, miplevel);
+				ds->rebuilt = c_surf != oldc_surf;
+				cacheblock = (pixel_t *)ds->cache->data;
+				cachewidth = ds->cache->width;
+			}
+			ds->miplevel = miplevel;
+
+			D_CalcGradients (pface);
+
+			if (s->insubmodel)
+			{
+				currententity = &cl_entities[0];
+				VectorCopy (world_transformed_modelorg,
+							transformed_modelorg);
+				VectorCopy (base_vpn, vpn);
+				VectorCopy (base_vup, vup);
+				VectorCopy (base_vright, vright);
+				VectorCopy (base_modelorg, modelorg);
+				R_TransformFrustum ();
+			}
+		}
+
+		D_SaveDrawState (&ds->state);
+		ds++;
+	}
+
+	return ds - surfs;
+}
+
+/*
+==============
+D_CachesIntact
+
+False if building a later surface's cache threw out or redrew the cache
+block of an earlier one.  Only bmodel surfaces are drawn more than once a
+frame, so only they can find their own block already in the batch.
+==============
+*/
+static qboolean D_CachesIntact (bandsurf_t *surfs, int numsurfs)
+{
+	bandsurf_t	*ds, *prev;
+
+	for (ds = surfs ; ds < surfs + numsurfs ; ds++)
+	{
+		if (ds->kind != DS_TEXTURED)
+			continue;
+		if (ds->pface->cachespots[ds->miplevel] != ds->cache)
+			return false;
+		if (!ds->insubmodel || !ds->rebuilt)
+			continue;
+		for (prev = surfs ; prev < ds ; prev++)
+			if (prev->cache == ds->cache)
+				return false;
+	}
+
+	return true;
+}
+
+/*
+==============
+D_BinSpans
+
+Splits each surface's span list into one list per band, keeping the order
+==============
+*/
+static void D_BinSpans (bandsurf_t *surfs, int numsurfs, int numbands)
+{
+	bandsurf_t	*ds;
+	espan_t		*span, *next;
+	espan_t		**tail[MAX_BANDS];
+	int			i, band, top, height;
+
+	top = r_refdef.vrect.y;
+	height = r_refdef.vrect.height;
+	for (i=0 ; i<height ; i++)
+		d_bandforv[top + i] = i * numbands / height;
+
+	for (ds = surfs ; ds < surfs + numsurfs ; ds++)
+	{
+		span = ds->spans[0];
+		for (i=0 ; i<numbands ; i++)
+		{
+			ds->spans[i] = NULL;
+			tail[i] = &ds->spans[i];
+		}
+
+		for ( ; span ; span = next)
+		{
+			next = span->pnext;
+			band = d_bandforv[span->v];
+			span->pnext = NULL;
+			*tail[band] = span;
+			tail[band] = &span->pnext;
+		}
+	}
+}
+
+/*
+==============
+D_DrawBands
+
+Job function: draws bands [first, first+count) of every surface
+==============
+*/
+static void D_DrawBands (void *data, int first, int count)
+{
+	bandbatch_t	*batch;
+	bandsurf_t	*ds;
+	espan_t		*spans;
+	int			band;
+
+	batch = data;
+	for (band = first ; band < first + count ; band++)
+	{
+		for (ds = batch->surfs ; ds < batch->surfs + batch->numsurfs ; ds++)
+		{
+			spans = ds->spans[band];
+			if (!spans)
+				continue;
+
+			D_LoadDrawState (&ds->state);
+
+			switch (ds->kind)
+			{
+			case DS_SKY:
+				D_DrawSkyScans8 (spans);
+				break;
+			case DS_BACKGROUND:
+				D_DrawSolidSpans (spans, (int)r_clearcolor.value & 0xFF);
+				break;
+			case DS_TURB:
+				(*d_drawturbulent) (spans);
+				break;
+			case DS_TEXTURED:
+				(*d_drawspans) (spans);
+				break;
+			}
+
+			(*d_drawzspans) (spans);
+		}
+	}
+}
+
+/*
+==============
+D_DrawSurfaces
+==============
+*/
+void D_DrawSurfaces (void)
+{
+	bandbatch_t	batch;
+	int			numbands, oldpolycount;
+	qboolean	intact;
+	double		start;
+
+	if (d_spanrecord)
+	{
+		D_DrawSurfacesSerial ();
+		D_SpanBench ();
+		return;
+	}
+
+	start = Sys_FloatTime ();
+	numbands = D_NumBands ();
+	if (r_drawflat.value || numbands <= 1)
+	{
+		D_DrawSurfacesSerial ();
+		d_serialframes++;
+		d_serialtime += Sys_FloatTime () - start;
+		return;
+	}
+
+	oldpolycount = r_drawnpolycount;
+	batch.surfs = Frame_Alloc ((surface_p - surfaces) * sizeof(bandsurf_t));
+	D_DeferSurfaceBuilds (surface_p - surfaces);
+	batch.numsurfs = D_SetupSurfaces (batch.surfs);
+
+	intact = D_CachesIntact (batch.surfs, batch.numsurfs);
+	D_RunSurfaceBuilds (intact);
+
+	d_bandframes++;
+	if (!intact)
+	{
+		r_drawnpolycount = oldpolycount;
+		D_DrawSurfacesSerial ();
+		d_bandfallbacks++;
+		d_bandtime += Sys_FloatTime () - start;
+		return;
+	}
+
+	D_BinSpans (batch.surfs, batch.numsurfs, numbands);
+	Job_Add (D_DrawBands, &batch, numbands, 1);
+	Job_Wait ();
+	d_bandtime += Sys_FloatTime () - start;
+}
+
+/*
+==============
+D_BandStats_f
+
+bandstats [clear]
+==============
+*/
+void D_BandStats_f (void)
+{
+	R_SyncView ();		// the counts are kept on the render thread
+
+	if (Cmd_Argc () == 2 && !Q_strcmp (Cmd_Argv(1), "clear"))
+	{
+		d_bandframes = d_bandfallbacks = d_serialframes = 0;
+		d_bandtime = d_serialtime = 0;
+		return;
+	}
+
+	if (d_serialframes)
+		Con_Printf ("%i frames serial, %.2f ms average\n", d_serialframes,
+			d_serialtime * 1000 / d_serialframes);
+	if (d_bandframes)
+		Con_Printf ("%i frames banded, %.2f ms average, %i (%.0f%%) redrawn serially\n",
+			d_bandframes, d_bandtime * 1000 / d_bandframes, d_bandfallbacks,
+			100.0 * d_bandfallbacks / d_bandframes);
+}
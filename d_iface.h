@@ -127,7 +127,7 @@ extern qboolean	r_recursiveaffinetriangles;	// true if a driver wants to use
 extern float	r_aliasuvscale;		// scale-up factor for screen u and v
 									//  on Alias vertices passed to driver
 extern int		r_pixbytes;
-extern qboolean	r_dowarp;
+extern qboolean	r_dowarp, r_dodynres;
 
 extern affinetridesc_t	r_affinetridesc;
 extern spritedesc_t		r_spritedesc;
@@ -161,6 +161,7 @@ void D_SetupFrame (void);
 void D_StartParticles (void);
 void D_TurnZOn (void);
 void D_WarpScreen (void);
+void D_ScaleScreen (void);
 
 void D_FillRect (vrect_t *vrect, int color);
 void D_DrawRect (void);
@@ -201,8 +202,6 @@ typedef struct
 	int			surfheight;	// in mipmapped texels
 } drawsurf_t;
 
-extern drawsurf_t	r_drawsurf;
-
 void R_DrawSurface (void);
 void R_GenTile (msurface_t *psurf, void *pdest);
 
@@ -223,7 +222,10 @@ extern float	skyspeed, skyspeed2;
 extern float	skytime;
 
 extern int		c_surf;
+extern int		d_surfmisses, d_surfdeferred;	// surface builds this frame
+extern double	d_surfbuildtime;
 extern vrect_t	scr_vrect;
 
 extern byte		*r_warpbuffer;
+extern byte		*r_dynresbuffer;	// r_dodynres draws the view here
 
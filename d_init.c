@@ -27,6 +27,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 cvar_t	d_subdiv16 = {"d_subdiv16", "1"};
 cvar_t	d_mipcap = {"d_mipcap", "0"};
 cvar_t	d_mipscale = {"d_mipscale", "1"};
+cvar_t	d_bands = {"d_bands", "1"};	// 1 = serial, 0 = pick from the job threads
 
 surfcache_t		*d_initial_rover;
 qboolean		d_roverwrapped;
@@ -38,6 +39,8 @@ static float	basemip[NUM_MIPS-1] = {1.0, 0.5*0.8, 0.25*0.8};
 extern int			d_aflatcolor;
 
 void (*d_drawspans) (espan_t *pspan);
+void (*d_drawzspans) (espan_t *pspan);
+void (*d_drawturbulent) (espan_t *pspan);
 
 
 /*
@@ -53,6 +56,10 @@ void D_Init (void)
 	Cvar_RegisterVariable (&d_subdiv16);
 	Cvar_RegisterVariable (&d_mipcap);
 	Cvar_RegisterVariable (&d_mipscale);
+	Cvar_RegisterVariable (&d_bands);
+	Cmd_AddCommand ("bandstats", D_BandStats_f);
+	D_SCInit ();
+	D_SIMDInit ();
 
 	r_drawpolys = false;
 	r_worldpolysbacktofront = false;
@@ -125,17 +132,27 @@ void D_SetupFrame (void)
 
 	if (r_dowarp)
 		d_viewbuffer = r_warpbuffer;
+	else if (r_dodynres)
+		d_viewbuffer = r_dynresbuffer;
 	else
 		d_viewbuffer = (void *)(byte *)vid.buffer;
 
 	if (r_dowarp)
 		screenwidth = WARP_WIDTH;
+	else if (r_dodynres)
+		screenwidth = vid.width;
 	else
 		screenwidth = vid.rowbytes;
 
+	D_SCNewFrame ();	// may move the cache, so before the rover is noted
+
 	d_roverwrapped = false;
 	d_initial_rover = sc_rover;
 
+	d_surfmisses = 0;
+	d_surfdeferred = 0;
+	d_surfbuildtime = 0;
+
 	d_minmip = d_mipcap.value;
 	if (d_minmip > 3)
 		d_minmip = 3;
@@ -150,8 +167,10 @@ void D_SetupFrame (void)
 					d_drawspans = D_DrawSpans16;
 				else
 					d_drawspans = D_DrawSpans8;
+				d_drawzspans = D_DrawZSpans;
+				d_drawturbulent = Turbulent8;
 #else
-				d_drawspans = D_DrawSpans8;
+				D_SelectDrawers ();
 #endif
 
 	d_aflatcolor = 0;
@@ -45,6 +45,7 @@ typedef struct surfcache_s
 	unsigned			height;		// DEBUG only needed for debug
 	float				mipscale;
 	struct texture_s	*texture;	// checked for animating textures
+	int					framecount;	// last frame it was drawn from
 	byte				data[4];	// width*height elements
 } surfcache_t;
 
@@ -55,6 +56,9 @@ typedef struct sspan_s
 } sspan_t;
 
 extern cvar_t	d_subdiv16;
+extern cvar_t	d_bands;
+
+void D_BandStats_f (void);
 
 extern float	scale_for_mip;
 
@@ -62,13 +66,27 @@ extern qboolean		d_roverwrapped;
 extern surfcache_t	*sc_rover;
 extern surfcache_t	*d_initial_rover;
 
-extern float	d_sdivzstepu, d_tdivzstepu, d_zistepu;
-extern float	d_sdivzstepv, d_tdivzstepv, d_zistepv;
-extern float	d_sdivzorigin, d_tdivzorigin, d_ziorigin;
+extern D_THREADLOCAL float	d_sdivzstepu, d_tdivzstepu, d_zistepu;
+extern D_THREADLOCAL float	d_sdivzstepv, d_tdivzstepv, d_zistepv;
+extern D_THREADLOCAL float	d_sdivzorigin, d_tdivzorigin, d_ziorigin;
+
+extern D_THREADLOCAL fixed16_t	sadjust, tadjust;
+extern D_THREADLOCAL fixed16_t	bbextents, bbextentt;
+
 
-fixed16_t	sadjust, tadjust;
-fixed16_t	bbextents, bbextentt;
+// the span drawers' inputs for one surface
+typedef struct
+{
+	float		d_zistepu, d_zistepv, d_ziorigin;
+	float		d_sdivzstepu, d_sdivzstepv, d_sdivzorigin;
+	float		d_tdivzstepu, d_tdivzstepv, d_tdivzorigin;
+	fixed16_t	sadjust, tadjust, bbextents, bbextentt;
+	pixel_t		*cacheblock;
+	int			cachewidth;
+} drawstate_t;
 
+void D_SaveDrawState (drawstate_t *st);
+void D_LoadDrawState (drawstate_t *st);
 
 void D_DrawSpans8 (espan_t *pspans);
 void D_DrawSpans16 (espan_t *pspans);
@@ -82,6 +100,10 @@ void D_DrawSkyScans16 (espan_t *pspan);
 void R_ShowSubDiv (void);
 void (*prealspandrawer)(void);
 surfcache_t	*D_CacheSurface (msurface_t *surface, int miplevel);
+void D_DeferSurfaceBuilds (int maxbuilds);
+void D_RunSurfaceBuilds (qboolean parallel);
+void D_SCInit (void);
+void D_SCNewFrame (void);
 
 extern int D_MipLevelForScale (float scale);
 
@@ -108,4 +130,15 @@ extern int		d_minmip;
 extern float	d_scalemip[3];
 
 extern void (*d_drawspans) (espan_t *pspan);
+extern void (*d_drawzspans) (espan_t *pspan);
+extern void (*d_drawturbulent) (espan_t *pspan);
+
+// d_simd.c
+extern cvar_t	d_simd;
+extern qboolean	d_spanrecord;
+
+void D_SIMDInit (void);
+void D_SelectDrawers (void);
+void D_RecordSpans (espan_t *pspan, qboolean turbulent);
+void D_SpanBench (void);
 
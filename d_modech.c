@@ -62,6 +62,8 @@ void D_ViewChanged (void)
 
 	if (r_dowarp)
 		rowbytes = WARP_WIDTH;
+	else if (r_dodynres)
+		rowbytes = vid.width;
 	else
 		rowbytes = vid.rowbytes;
 
@@ -25,10 +25,10 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #include "r_local.h"
 #include "d_local.h"
 
-unsigned char	*r_turb_pbase, *r_turb_pdest;
-fixed16_t		r_turb_s, r_turb_t, r_turb_sstep, r_turb_tstep;
-int				*r_turb_turb;
-int				r_turb_spancount;
+D_THREADLOCAL unsigned char	*r_turb_pbase, *r_turb_pdest;
+D_THREADLOCAL fixed16_t		r_turb_s, r_turb_t, r_turb_sstep, r_turb_tstep;
+D_THREADLOCAL int			*r_turb_turb;
+D_THREADLOCAL int			r_turb_spancount;
 
 void D_DrawTurbulent8Span (void);
 
@@ -71,7 +71,7 @@ void D_WarpScreen (void)
 				(int)((float)u * wratio * w / (w + AMP2 * 2));
 	}
 
-	turb = intsintable + ((int)(cl.time*SPEED)&(CYCLE-1));
+	turb = intsintable + ((int)(r_frame.time*SPEED)&(CYCLE-1));
 	dest = vid.buffer + scr_vrect.y * vid.rowbytes + scr_vrect.x;
 
 	for (v=0 ; v<scr_vrect.height ; v++, dest += vid.rowbytes)
@@ -90,6 +90,156 @@ void D_WarpScreen (void)
 }
 
 
+/*
+=============
+D_BuildBlendTable
+
+d_blendtable[a*256+b] is the palette color nearest the average of a and b.
+Fullbright colors are only picked when one of the pair is fullbright.
+=============
+*/
+static byte	*d_blendtable;
+
+static void D_BuildBlendTable (void)
+{
+	int		a, b, i, best, bestdist, dist, dr, dg, db, colors;
+	int		r, g, bl;
+	byte	*pal;
+
+	d_blendtable = malloc (256*256);
+	if (!d_blendtable)
+		Sys_Error ("D_BuildBlendTable: out of memory");
+	pal = host_basepal;
+
+	for (a=0 ; a<256 ; a++)
+	{
+		d_blendtable[a*256+a] = a;
+		for (b=0 ; b<a ; b++)
+		{
+			r = (pal[a*3+0] + pal[b*3+0]) >> 1;
+			g = (pal[a*3+1] + pal[b*3+1]) >> 1;
+			bl = (pal[a*3+2] + pal[b*3+2]) >> 1;
+
+			colors = 256;
+			if (a < vid.fullbright && b < vid.fullbright)
+				colors = vid.fullbright;
+
+			best = 0;
+			bestdist = 0x7fffffff;
+			for (i=0 ; i<colors ; i++)
+			{
+				dr = pal[i*3+0] - r;
+				dg = pal[i*3+1] - g;
+				db = pal[i*3+2] - bl;
+				dist = dr*dr + dg*dg + db*db;
+				if (dist < bestdist)
+				{
+					bestdist = dist;
+					best = i;
+				}
+			}
+			d_blendtable[a*256+b] = best;
+			d_blendtable[b*256+a] = best;
+		}
+	}
+}
+
+
+/*
+=============
+D_ScaleSamples
+
+The source pixel under each of count output pixels across size source
+pixels, and the neighbour to blend it with: itself unless the output pixel
+falls in the outer quarter of the source pixel, on that side
+=============
+*/
+static void D_ScaleSamples (int *first, int *second, int count, int size,
+	qboolean blend)
+{
+	int			i, frac;
+	fixed16_t	step, pos;
+
+	step = (size << 16) / count;
+	pos = step / 2;
+	for (i=0 ; i<count ; i++, pos += step)
+	{
+		first[i] = second[i] = pos >> 16;
+		if (!blend)
+			continue;
+
+		frac = pos & 0xffff;
+		if (frac <= 0x4000 && first[i] > 0)
+			second[i] = first[i] - 1;
+		else if (frac >= 0xc000 && first[i] < size - 1)
+			second[i] = first[i] + 1;
+	}
+}
+
+
+/*
+=============
+D_ScaleScreen
+
+Stretches the view from r_dynresbuffer to scr_vrect.  With r_dynresfilter
+set, each output pixel is a 50/50 blend through d_blendtable of its source
+pixel and the neighbour it is closest to, in both directions, when it is
+closer to the neighbour than to the middle of its own.
+=============
+*/
+void D_ScaleScreen (void)
+{
+	int			u, v;
+	byte		*dest, *row, *row2, *row3, *blend;
+	int			column[MAXWIDTH], column2[MAXWIDTH];
+	int			line[MAXHEIGHT], line2[MAXHEIGHT];
+
+	if (r_refdef.vrect.width <= 0 || r_refdef.vrect.height <= 0)
+		return;
+
+	blend = NULL;
+	if (r_dynresfilter.value)
+	{
+		if (!d_blendtable)
+			D_BuildBlendTable ();
+		blend = d_blendtable;
+	}
+
+	D_ScaleSamples (column, column2, scr_vrect.width, r_refdef.vrect.width,
+					blend != NULL);
+	D_ScaleSamples (line, line2, scr_vrect.height, r_refdef.vrect.height,
+					blend != NULL);
+
+	dest = vid.buffer + scr_vrect.y * vid.rowbytes + scr_vrect.x;
+	row = d_viewbuffer + r_refdef.vrect.y * screenwidth + r_refdef.vrect.x;
+
+	for (v=0 ; v<scr_vrect.height ; v++, dest += vid.rowbytes)
+	{
+		if (!blend)
+		{
+			row2 = row + line[v] * screenwidth;
+			for (u=0 ; u<scr_vrect.width ; u++)
+				dest[u] = row2[column[u]];
+		}
+		else if (line[v] == line2[v])
+		{
+			row2 = row + line[v] * screenwidth;
+			for (u=0 ; u<scr_vrect.width ; u++)
+				dest[u] = blend[row2[column[u]]*256 + row2[column2[u]]];
+		}
+		else
+		{
+			row2 = row + line[v] * screenwidth;
+			row3 = row + line2[v] * screenwidth;
+			for (u=0 ; u<scr_vrect.width ; u++)
+				dest[u] = blend[
+						blend[row2[column[u]]*256 + row2[column2[u]]]*256 +
+						blend[row3[column[u]]*256 + row3[column2[u]]]];
+		}
+	}
+}
+
+
 #if	!id386
 
 /*
@@ -126,7 +276,7 @@ void Turbulent8 (espan_t *pspan)
 	float			sdivz, tdivz, zi, z, du, dv, spancountminus1;
 	float			sdivz16stepu, tdivz16stepu, zi16stepu;
 	
-	r_turb_turb = sintable + ((int)(cl.time*SPEED)&(CYCLE-1));
+	r_turb_turb = sintable + ((int)(r_frame.time*SPEED)&(CYCLE-1));
 
 	r_turb_sstep = 0;	// keep compiler happy
 	r_turb_tstep = 0;	// ditto
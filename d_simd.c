@@ -0,0 +1,1370 @@
+/*
+Copyright (C) 1996-1997 Id Software, Inc.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+// d_simd.c
+//
+// SSE2 and AVX2 versions of the portable span drawers in d_scan.c and the
+// surface block builders in r_surf.c, picked at run time from CPUID, and the
+// spanbench and surfbench commands that time them.
+//
+// They must draw exactly what the C drawers draw.  The perspective setup of
+// each 8 or 16 pixel run (the divide, the clamps, the step biasing) is shared
+// scalar code copied from d_scan.c operation for operation; only the stepping
+// across a run and the texel fetches are done several pixels at a time, in
+// integer arithmetic that wraps the same way the C loops do.
+
+#include "quakedef.h"
+#include "r_local.h"
+#include "d_local.h"
+
+// intrinsics can only be used under a target attribute, without -msse2 or
+// -mavx2 for the whole file, from gcc 4.9 on
+#if !id386 && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#if defined(__clang__) || __GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9)
+#define	D_SIMD	1
+#endif
+#endif
+
+#ifdef D_SIMD
+#include <immintrin.h>
+#include <cpuid.h>
+
+#define	D_TARGET_SSE2	__attribute__((target("sse2")))
+#define	D_TARGET_AVX2	__attribute__((target("avx2")))
+#endif
+
+#define	SIMD_NONE	0
+#define	SIMD_SSE2	1
+#define	SIMD_AVX2	2
+
+static char	*simdnames[] = {"C", "SSE2", "AVX2"};
+
+cvar_t	d_simd = {"d_simd", "1"};	// 0 = always use the C drawers
+
+static int	d_simdlevel;			// best the CPU and OS support
+
+qboolean	d_spanrecord;			// record the next frame's spans for spanbench
+
+
+#ifdef D_SIMD
+
+/*
+=============
+D_DetectSIMD
+=============
+*/
+static int D_DetectSIMD (void)
+{
+	unsigned	eax, ebx, ecx, edx;
+	unsigned	xcr0lo, xcr0hi;
+
+	if (!__get_cpuid (1, &eax, &ebx, &ecx, &edx))
+		return SIMD_NONE;
+	if (!(edx & bit_SSE2))
+		return SIMD_NONE;
+
+// AVX2 also needs the OS to save the ymm registers
+	if (!(ecx & bit_OSXSAVE) || !(ecx & bit_AVX))
+		return SIMD_SSE2;
+	__asm__ __volatile__ (".byte 0x0f, 0x01, 0xd0"	// xgetbv
+		: "=a" (xcr0lo), "=d" (xcr0hi) : "c" (0));
+	if ((xcr0lo & 6) != 6)
+		return SIMD_SSE2;
+
+	if (__get_cpuid_max (0, NULL) < 7)
+		return SIMD_SSE2;
+	__cpuid_count (7, 0, eax, ebx, ecx, edx);
+	if (!(ebx & (1<<5)))		// bit_AVX2, missing from older cpuid.h
+		return SIMD_SSE2;
+
+	return SIMD_AVX2;
+}
+
+
+/*
+===============================================================================
+
+RUN SETUP
+
+===============================================================================
+*/
+
+typedef struct
+{
+	fixed16_t	s, t, sstep, tstep;
+	int			count;
+} spanstep_t;
+
+/*
+=============
+D_SpanSteps
+
+The scalar half of D_DrawSpans8 (shift 3) and Turbulent8 (shift 4): splits
+a span into runs of 1<<shift pixels and works out s and t at the start of
+each and the steps across it.  This has to stay in step with d_scan.c.
+=============
+*/
+static int D_SpanSteps (espan_t *pspan, int shift, spanstep_t *steps)
+{
+	int				count, spancount, subdiv, numsteps;
+	fixed16_t		s, t, snext, tnext, sstep, tstep;
+	float			sdivz, tdivz, zi, z, du, dv, spancountminus1;
+	float			sdivzsubstepu, tdivzsubstepu, zisubstepu;
+
+	sstep = 0;	// keep compiler happy
+	tstep = 0;	// ditto
+
+	subdiv = 1 << shift;
+	sdivzsubstepu = d_sdivzstepu * subdiv;
+	tdivzsubstepu = d_tdivzstepu * subdiv;
+	zisubstepu = d_zistepu * subdiv;
+
+	count = pspan->count;
+
+// calculate the initial s/z, t/z, 1/z, s, and t and clamp
+	du = (float)pspan->u;
+	dv = (float)pspan->v;
+
+	sdivz = d_sdivzorigin + dv*d_sdivzstepv + du*d_sdivzstepu;
+	tdivz = d_tdivzorigin + dv*d_tdivzstepv + du*d_tdivzstepu;
+	zi = d_ziorigin + dv*d_zistepv + du*d_zistepu;
+	z = (float)0x10000 / zi;	// prescale to 16.16 fixed-point
+
+	s = (int)(sdivz * z) + sadjust;
+	if (s > bbextents)
+		s = bbextents;
+	else if (s < 0)
+		s = 0;
+
+	t = (int)(tdivz * z) + tadjust;
+	if (t > bbextentt)
+		t = bbextentt;
+	else if (t < 0)
+		t = 0;
+
+	numsteps = 0;
+	do
+	{
+		if (count >= subdiv)
+			spancount = subdiv;
+		else
+			spancount = count;
+
+		count -= spancount;
+
+		if (count)
+		{
+			sdivz += sdivzsubstepu;
+			tdivz += tdivzsubstepu;
+			zi += zisubstepu;
+			z = (float)0x10000 / zi;	// prescale to 16.16 fixed-point
+
+			snext = (int)(sdivz * z) + sadjust;
+			if (snext > bbextents)
+				snext = bbextents;
+			else if (snext < subdiv)
+				snext = subdiv;
+
+			tnext = (int)(tdivz * z) + tadjust;
+			if (tnext > bbextentt)
+				tnext = bbextentt;
+			else if (tnext < subdiv)
+				tnext = subdiv;
+
+			sstep = (snext - s) >> shift;
+			tstep = (tnext - t) >> shift;
+		}
+		else
+		{
+			spancountminus1 = (float)(spancount - 1);
+			sdivz += d_sdivzstepu * spancountminus1;
+			tdivz += d_tdivzstepu * spancountminus1;
+			zi += d_zistepu * spancountminus1;
+			z = (float)0x10000 / zi;	// prescale to 16.16 fixed-point
+			snext = (int)(sdivz * z) + sadjust;
+			if (snext > bbextents)
+				snext = bbextents;
+			else if (snext < subdiv)
+				snext = subdiv;
+
+			tnext = (int)(tdivz * z) + tadjust;
+			if (tnext > bbextentt)
+				tnext = bbextentt;
+			else if (tnext < subdiv)
+				tnext = subdiv;
+
+			if (spancount > 1)
+			{
+				sstep = (snext - s) / (spancount - 1);
+				tstep = (tnext - t) / (spancount - 1);
+			}
+		}
+
+		steps[numsteps].s = s;
+		steps[numsteps].t = t;
+		steps[numsteps].sstep = sstep;
+		steps[numsteps].tstep = tstep;
+		steps[numsteps].count = spancount;
+		numsteps++;
+
+		s = snext;
+		t = tnext;
+
+	} while (count > 0);
+
+	return numsteps;
+}
+
+
+/*
+===============================================================================
+
+SSE2
+
+===============================================================================
+*/
+
+/*
+=============
+D_DrawSpans8SSE2
+
+s and t are stepped four pixels at a time and the texel offsets formed with
+pmaddwd, which is exact while t>>16 and cachewidth fit in 16 bits; SSE2 has
+no gather, so the fetches stay scalar.
+=============
+*/
+D_TARGET_SSE2 static void D_DrawSpans8SSE2 (espan_t *pspan)
+{
+	spanstep_t		steps[MAXWIDTH/8 + 1], *st;
+	int				numsteps, i;
+	int				offsets[8];
+	unsigned char	*pbase, *pdest;
+	__m128i			width, s, t, sramp, tramp, s4, t4, off;
+
+	pbase = (unsigned char *)cacheblock;
+	width = _mm_set1_epi32 (cachewidth);
+
+	do
+	{
+		pdest = (unsigned char *)((byte *)d_viewbuffer +
+				(screenwidth * pspan->v) + pspan->u);
+
+		numsteps = D_SpanSteps (pspan, 3, steps);
+		for (st = steps ; st < steps + numsteps ; st++)
+		{
+			sramp = _mm_set_epi32 (3*st->sstep, 2*st->sstep, st->sstep, 0);
+			tramp = _mm_set_epi32 (3*st->tstep, 2*st->tstep, st->tstep, 0);
+			s = _mm_add_epi32 (_mm_set1_epi32 (st->s), sramp);
+			t = _mm_add_epi32 (_mm_set1_epi32 (st->t), tramp);
+
+			off = _mm_add_epi32 (_mm_srai_epi32 (s, 16),
+					_mm_madd_epi16 (_mm_srai_epi32 (t, 16), width));
+			_mm_storeu_si128 ((__m128i *)offsets, off);
+
+			if (st->count > 4)
+			{
+				s4 = _mm_set1_epi32 (4*st->sstep);
+				t4 = _mm_set1_epi32 (4*st->tstep);
+				s = _mm_add_epi32 (s, s4);
+				t = _mm_add_epi32 (t, t4);
+				off = _mm_add_epi32 (_mm_srai_epi32 (s, 16),
+						_mm_madd_epi16 (_mm_srai_epi32 (t, 16), width));
+				_mm_storeu_si128 ((__m128i *)(offsets + 4), off);
+			}
+
+			for (i=0 ; i<st->count ; i++)
+				pdest[i] = pbase[offsets[i]];
+			pdest += st->count;
+		}
+
+	} while ((pspan = pspan->pnext) != NULL);
+}
+
+
+/*
+=============
+D_ZPairsSSE2
+
+(izi >> 16) for each pixel, with the sign of the even pixel of each pair
+smeared into the odd one the way D_DrawZSpans builds its pairs
+=============
+*/
+D_TARGET_SSE2 static inline __m128i D_ZPairsSSE2 (__m128i izi, __m128i odd)
+{
+	return _mm_or_si128 (_mm_srai_epi32 (izi, 16),
+			_mm_and_si128 (_mm_slli_si128 (_mm_srai_epi32 (izi, 31), 4), odd));
+}
+
+/*
+=============
+D_DrawZSpansSSE2
+=============
+*/
+D_TARGET_SSE2 static void D_DrawZSpansSSE2 (espan_t *pspan)
+{
+	int				count, doublecount, izistep;
+	int				izi;
+	short			*pdest;
+	unsigned		ltemp;
+	double			zi;
+	float			du, dv;
+	__m128i			ramp, step4, odd, a, b;
+
+// we count on FP exceptions being turned off to avoid range problems
+	izistep = (int)(d_zistepu * 0x8000 * 0x10000);
+
+	ramp = _mm_set_epi32 (3*izistep, 2*izistep, izistep, 0);
+	step4 = _mm_set1_epi32 (4*izistep);
+	odd = _mm_set_epi32 (-1, 0, -1, 0);
+
+	do
+	{
+		pdest = d_pzbuffer + (d_zwidth * pspan->v) + pspan->u;
+
+		count = pspan->count;
+
+	// calculate the initial 1/z
+		du = (float)pspan->u;
+		dv = (float)pspan->v;
+
+		zi = d_ziorigin + dv*d_zistepv + du*d_zistepu;
+		izi = (int)(zi * 0x8000 * 0x10000);
+
+		if ((long)pdest & 0x02)
+		{
+			*pdest++ = (short)(izi >> 16);
+			izi += izistep;
+			count--;
+		}
+
+		for ( ; count >= 8 ; count -= 8)
+		{
+			a = _mm_add_epi32 (_mm_set1_epi32 (izi), ramp);
+			b = _mm_add_epi32 (a, step4);
+			_mm_storeu_si128 ((__m128i *)pdest,
+					_mm_packs_epi32 (D_ZPairsSSE2 (a, odd), D_ZPairsSSE2 (b, odd)));
+			pdest += 8;
+			izi = (int)((unsigned)izi + 8*(unsigned)izistep);
+		}
+
+		if ((doublecount = count >> 1) > 0)
+		{
+			do
+			{
+				ltemp = izi >> 16;
+				izi += izistep;
+				ltemp |= izi & 0xFFFF0000;
+				izi += izistep;
+				*(int *)pdest = ltemp;
+				pdest += 2;
+			} while (--doublecount > 0);
+		}
+
+		if (count & 1)
+			*pdest = (short)(izi >> 16);
+
+	} while ((pspan = pspan->pnext) != NULL);
+}
+
+
+/*
+===============================================================================
+
+AVX2
+
+The texel gathers load the dword ending at each texel, from pbase - 3, and
+keep its top byte, so they never read past the end of a cache block or
+texture; what lies before one is its header.
+
+===============================================================================
+*/
+
+/*
+=============
+D_PackTexelsAVX2
+
+Top bytes of the eight dwords, in order, in the low 8 bytes
+=============
+*/
+D_TARGET_AVX2 static inline __m128i D_PackTexelsAVX2 (__m256i tex)
+{
+	tex = _mm256_srli_epi32 (tex, 24);
+	tex = _mm256_packus_epi32 (tex, tex);
+	tex = _mm256_packus_epi16 (tex, tex);
+	return _mm_unpacklo_epi32 (_mm256_castsi256_si128 (tex),
+			_mm256_extracti128_si256 (tex, 1));
+}
+
+/*
+=============
+D_StoreTexelsAVX2
+=============
+*/
+D_TARGET_AVX2 static inline void D_StoreTexelsAVX2 (unsigned char *pdest,
+	__m128i pix, int count)
+{
+	unsigned char	buf[16];
+
+	if (count == 8)
+	{
+		_mm_storel_epi64 ((__m128i *)pdest, pix);
+		return;
+	}
+	_mm_storeu_si128 ((__m128i *)buf, pix);
+	memcpy (pdest, buf, count);
+}
+
+/*
+=============
+D_DrawSpans8AVX2
+=============
+*/
+D_TARGET_AVX2 static void D_DrawSpans8AVX2 (espan_t *pspan)
+{
+	spanstep_t		steps[MAXWIDTH/8 + 1], *st;
+	int				numsteps;
+	unsigned char	*pbase, *pdest;
+	__m256i			lanes, width, s, t, off, mask;
+
+	pbase = (unsigned char *)cacheblock;
+	width = _mm256_set1_epi32 (cachewidth);
+	lanes = _mm256_setr_epi32 (0, 1, 2, 3, 4, 5, 6, 7);
+
+	do
+	{
+		pdest = (unsigned char *)((byte *)d_viewbuffer +
+				(screenwidth * pspan->v) + pspan->u);
+
+		numsteps = D_SpanSteps (pspan, 3, steps);
+		for (st = steps ; st < steps + numsteps ; st++)
+		{
+			s = _mm256_add_epi32 (_mm256_set1_epi32 (st->s),
+					_mm256_mullo_epi32 (_mm256_set1_epi32 (st->sstep), lanes));
+			t = _mm256_add_epi32 (_mm256_set1_epi32 (st->t),
+					_mm256_mullo_epi32 (_mm256_set1_epi32 (st->tstep), lanes));
+			off = _mm256_add_epi32 (_mm256_srai_epi32 (s, 16),
+					_mm256_mullo_epi32 (_mm256_srai_epi32 (t, 16), width));
+			mask = _mm256_cmpgt_epi32 (_mm256_set1_epi32 (st->count), lanes);
+
+			D_StoreTexelsAVX2 (pdest, D_PackTexelsAVX2 (
+					_mm256_mask_i32gather_epi32 (_mm256_setzero_si256 (),
+					(int const *)(pbase - 3), off, mask, 1)), st->count);
+			pdest += st->count;
+		}
+
+	} while ((pspan = pspan->pnext) != NULL);
+}
+
+/*
+=============
+D_ZPairsAVX2
+=============
+*/
+D_TARGET_AVX2 static inline __m256i D_ZPairsAVX2 (__m256i izi, __m256i odd)
+{
+// the byte shift stays inside each 128 bit half, but only odd pixels take
+// the smeared sign and their even partner is always in the same half
+	return _mm256_or_si256 (_mm256_srai_epi32 (izi, 16),
+			_mm256_and_si256 (_mm256_slli_si256 (_mm256_srai_epi32 (izi, 31), 4), odd));
+}
+
+/*
+=============
+D_DrawZSpansAVX2
+=============
+*/
+D_TARGET_AVX2 static void D_DrawZSpansAVX2 (espan_t *pspan)
+{
+	int				count, doublecount, izistep;
+	int				izi;
+	short			*pdest;
+	unsigned		ltemp;
+	double			zi;
+	float			du, dv;
+	__m256i			ramp, step8, odd, a, b;
+
+// we count on FP exceptions being turned off to avoid range problems
+	izistep = (int)(d_zistepu * 0x8000 * 0x10000);
+
+	ramp = _mm256_mullo_epi32 (_mm256_set1_epi32 (izistep),
+			_mm256_setr_epi32 (0, 1, 2, 3, 4, 5, 6, 7));
+	step8 = _mm256_set1_epi32 (8*izistep);
+	odd = _mm256_setr_epi32 (0, -1, 0, -1, 0, -1, 0, -1);
+
+	do
+	{
+		pdest = d_pzbuffer + (d_zwidth * pspan->v) + pspan->u;
+
+		count = pspan->count;
+
+	// calculate the initial 1/z
+		du = (float)pspan->u;
+		dv = (float)pspan->v;
+
+		zi = d_ziorigin + dv*d_zistepv + du*d_zistepu;
+		izi = (int)(zi * 0x8000 * 0x10000);
+
+		if ((long)pdest & 0x02)
+		{
+			*pdest++ = (short)(izi >> 16);
+			izi += izistep;
+			count--;
+		}
+
+		for ( ; count >= 16 ; count -= 16)
+		{
+			a = _mm256_add_epi32 (_mm256_set1_epi32 (izi), ramp);
+			b = _mm256_add_epi32 (a, step8);
+			_mm256_storeu_si256 ((__m256i *)pdest, _mm256_permute4x64_epi64 (
+					_mm256_packs_epi32 (D_ZPairsAVX2 (a, odd), D_ZPairsAVX2 (b, odd)),
+					0xD8));
+			pdest += 16;
+			izi = (int)((unsigned)izi + 16*(unsigned)izistep);
+		}
+
+		if ((doublecount = count >> 1) > 0)
+		{
+			do
+			{
+				ltemp = izi >> 16;
+				izi += izistep;
+				ltemp |= izi & 0xFFFF0000;
+				izi += izistep;
+				*(int *)pdest = ltemp;
+				pdest += 2;
+			} while (--doublecount > 0);
+		}
+
+		if (count & 1)
+			*pdest = (short)(izi >> 16);
+
+	} while ((pspan = pspan->pnext) != NULL);
+}
+
+/*
+=============
+Turbulent8AVX2
+=============
+*/
+D_TARGET_AVX2 static void Turbulent8AVX2 (espan_t *pspan)
+{
+	spanstep_t		steps[MAXWIDTH/16 + 1], *st;
+	int				numsteps, half, count;
+	int				*turb;
+	unsigned char	*pbase, *pdest;
+	__m256i			lanes, cyclemask, texmask, s, t, ts, ss, off, mask;
+
+	turb = sintable + ((int)(r_frame.time*SPEED)&(CYCLE-1));
+	pbase = (unsigned char *)cacheblock;
+
+	cyclemask = _mm256_set1_epi32 (CYCLE-1);
+	texmask = _mm256_set1_epi32 (63);
+
+	do
+	{
+		pdest = (unsigned char *)((byte *)d_viewbuffer +
+				(screenwidth * pspan->v) + pspan->u);
+
+		numsteps = D_SpanSteps (pspan, 4, steps);
+		for (st = steps ; st < steps + numsteps ; st++)
+		{
+			st->s &= (CYCLE<<16)-1;
+			st->t &= (CYCLE<<16)-1;
+
+			for (half=0 ; half<2 ; half++)
+			{
+				count = st->count - half*8;
+				if (count <= 0)
+					break;
+				if (count > 8)
+					count = 8;
+
+				lanes = _mm256_setr_epi32 (half*8, half*8+1, half*8+2, half*8+3,
+						half*8+4, half*8+5, half*8+6, half*8+7);
+				s = _mm256_add_epi32 (_mm256_set1_epi32 (st->s),
+						_mm256_mullo_epi32 (_mm256_set1_epi32 (st->sstep), lanes));
+				t = _mm256_add_epi32 (_mm256_set1_epi32 (st->t),
+						_mm256_mullo_epi32 (_mm256_set1_epi32 (st->tstep), lanes));
+
+				ts = _mm256_i32gather_epi32 (turb,
+						_mm256_and_si256 (_mm256_srai_epi32 (t, 16), cyclemask), 4);
+				ss = _mm256_i32gather_epi32 (turb,
+						_mm256_and_si256 (_mm256_srai_epi32 (s, 16), cyclemask), 4);
+				off = _mm256_add_epi32 (
+						_mm256_slli_epi32 (_mm256_and_si256 (_mm256_srai_epi32 (
+						_mm256_add_epi32 (t, ss), 16), texmask), 6),
+						_mm256_and_si256 (_mm256_srai_epi32 (
+						_mm256_add_epi32 (s, ts), 16), texmask));
+				mask = _mm256_cmpgt_epi32 (_mm256_set1_epi32 (count),
+						_mm256_setr_epi32 (0, 1, 2, 3, 4, 5, 6, 7));
+
+				D_StoreTexelsAVX2 (pdest, D_PackTexelsAVX2 (
+						_mm256_mask_i32gather_epi32 (_mm256_setzero_si256 (),
+						(int const *)(pbase - 3), off, mask, 1)), count);
+				pdest += count;
+			}
+		}
+
+	} while ((pspan = pspan->pnext) != NULL);
+}
+
+
+
+/*
+===============================================================================
+
+SURFACE BLOCKS
+
+Versions of R_DrawSurfaceBlock8_mip0..3 for building the surface cache.
+Each row of a block interpolates the light from right to left and looks
+every texel up in its light's row of the colormap.  The light values are
+bounded by R_BuildLightMap to 0..(255*256)>>2, so the interpolation is done
+exactly in 16 bit lanes for SSE2; AVX2 gathers the colormap lookups, the
+same way the span drawers gather texels.  Each gather loads from three
+bytes before the colormap: loaded onto the hunk, those are the hunk header;
+mapped by COM_MapFile, they are the end of the pak header or of the lump
+before it, as it only maps files that start past the header.
+
+===============================================================================
+*/
+
+/*
+=============
+R_LightRowSSE2
+
+Lights eight texels, or four for each of two rows when pdest2 is given
+=============
+*/
+D_TARGET_SSE2 static inline void R_LightRowSSE2 (unsigned char *pdest,
+	unsigned char *pdest2, __m128i pix, __m128i light, unsigned char *colormap)
+{
+	unsigned short	index[8];
+	int				b;
+
+	_mm_storeu_si128 ((__m128i *)index, _mm_add_epi16 (pix,
+			_mm_and_si128 (light, _mm_set1_epi16 ((short)0xFF00))));
+	if (pdest2)
+	{
+		for (b=0 ; b<4 ; b++)
+		{
+			pdest[b] = colormap[index[b]];
+			pdest2[b] = colormap[index[b+4]];
+		}
+		return;
+	}
+	for (b=0 ; b<8 ; b++)
+		pdest[b] = colormap[index[b]];
+}
+
+/*
+=============
+R_LoadRowSSE2
+
+Zero extends eight texels, or four from each of two rows, to 16 bits
+=============
+*/
+D_TARGET_SSE2 static inline __m128i R_LoadRowSSE2 (unsigned char *psource,
+	unsigned char *psource2)
+{
+	int		a, b;
+	__m128i	pix;
+
+	if (psource2)
+	{
+		memcpy (&a, psource, 4);
+		memcpy (&b, psource2, 4);
+		pix = _mm_unpacklo_epi32 (_mm_cvtsi32_si128 (a), _mm_cvtsi32_si128 (b));
+	}
+	else
+		pix = _mm_loadl_epi64 ((__m128i *)psource);
+	return _mm_unpacklo_epi8 (pix, _mm_setzero_si128 ());
+}
+
+/*
+=============
+R_DrawSurfaceBlockSSE2
+
+The mip0 to mip2 blocks are 16, 8 and 4 texels wide; a mip2 vector holds
+two rows.  The mip3 rows are two texels wide and stay in C.
+=============
+*/
+D_TARGET_SSE2 static inline void R_DrawSurfaceBlockSSE2 (int shift)
+{
+	int				v, i, rows, blocksize;
+	int				lightleft, lightright, lightleftstep, lightrightstep;
+	int				lightstep, lightstep2, lightright2;
+	unsigned		*lightptr;
+	unsigned char	*psource, *prowdest, *colormap;
+	__m128i			ramp, light;
+
+	blocksize = 1 << shift;
+	colormap = (unsigned char *)vid.colormap;
+	if (blocksize == 4)
+		ramp = _mm_setr_epi16 (3, 2, 1, 0, 3, 2, 1, 0);
+	else
+		ramp = _mm_setr_epi16 (7, 6, 5, 4, 3, 2, 1, 0);
+
+	psource = pbasesource;
+	prowdest = prowdestbase;
+	lightptr = r_lightptr;
+
+	for (v=0 ; v<r_numvblocks ; v++)
+	{
+		lightleft = lightptr[0];
+		lightright = lightptr[1];
+		lightptr += r_lightwidth;
+		lightleftstep = (lightptr[0] - lightleft) >> shift;
+		lightrightstep = (lightptr[1] - lightright) >> shift;
+
+		for (i=0 ; i<blocksize ; i+=rows)
+		{
+			lightstep = (lightleft - lightright) >> shift;
+
+			if (blocksize == 4)
+			{
+			// this row and the next
+				rows = 2;
+				lightright2 = lightright + lightrightstep;
+				lightstep2 = ((lightleft + lightleftstep) - lightright2) >> shift;
+				light = _mm_add_epi16 (_mm_setr_epi16 (lightright, lightright,
+						lightright, lightright, lightright2, lightright2,
+						lightright2, lightright2), _mm_mullo_epi16 (ramp,
+						_mm_setr_epi16 (lightstep, lightstep, lightstep, lightstep,
+						lightstep2, lightstep2, lightstep2, lightstep2)));
+				R_LightRowSSE2 (prowdest, prowdest + surfrowbytes,
+						R_LoadRowSSE2 (psource, psource + sourcetstep),
+						light, colormap);
+			}
+			else
+			{
+				rows = 1;
+				light = _mm_add_epi16 (_mm_set1_epi16 (lightright),
+						_mm_mullo_epi16 (_mm_set1_epi16 (lightstep), ramp));
+				if (blocksize == 16)
+				{
+				// the right half is lit first
+					R_LightRowSSE2 (prowdest + 8, NULL,
+							R_LoadRowSSE2 (psource + 8, NULL), light, colormap);
+					light = _mm_add_epi16 (light,
+							_mm_set1_epi16 (lightstep * 8));
+				}
+				R_LightRowSSE2 (prowdest, NULL, R_LoadRowSSE2 (psource, NULL),
+						light, colormap);
+			}
+
+			psource += sourcetstep * rows;
+			lightright += lightrightstep * rows;
+			lightleft += lightleftstep * rows;
+			prowdest += surfrowbytes * rows;
+		}
+
+		if (psource >= r_sourcemax)
+			psource -= r_stepback;
+	}
+}
+
+D_TARGET_SSE2 static void R_DrawSurfaceBlock8_mip0SSE2 (void)
+{
+	R_DrawSurfaceBlockSSE2 (4);
+}
+
+D_TARGET_SSE2 static void R_DrawSurfaceBlock8_mip1SSE2 (void)
+{
+	R_DrawSurfaceBlockSSE2 (3);
+}
+
+D_TARGET_SSE2 static void R_DrawSurfaceBlock8_mip2SSE2 (void)
+{
+	R_DrawSurfaceBlockSSE2 (2);
+}
+
+/*
+=============
+R_LightRowAVX2
+
+Gathers the colormap entries for eight texels, or four for each of two rows
+when pdest2 is given
+=============
+*/
+D_TARGET_AVX2 static inline void R_LightRowAVX2 (unsigned char *pdest,
+	unsigned char *pdest2, __m256i pix, __m256i light, unsigned char *colormap)
+{
+	__m128i		texels;
+	int			a;
+
+	texels = D_PackTexelsAVX2 (_mm256_i32gather_epi32 ((int const *)(colormap - 3),
+			_mm256_add_epi32 (pix, _mm256_and_si256 (light,
+			_mm256_set1_epi32 (0xFF00))), 1));
+	if (pdest2)
+	{
+		a = _mm_cvtsi128_si32 (texels);
+		memcpy (pdest, &a, 4);
+		a = _mm_cvtsi128_si32 (_mm_srli_si128 (texels, 4));
+		memcpy (pdest2, &a, 4);
+		return;
+	}
+	_mm_storel_epi64 ((__m128i *)pdest, texels);
+}
+
+/*
+=============
+R_LoadRowAVX2
+=============
+*/
+D_TARGET_AVX2 static inline __m256i R_LoadRowAVX2 (unsigned char *psource,
+	unsigned char *psource2)
+{
+	int		a, b;
+	__m128i	pix;
+
+	if (psource2)
+	{
+		memcpy (&a, psource, 4);
+		memcpy (&b, psource2, 4);
+		pix = _mm_unpacklo_epi32 (_mm_cvtsi32_si128 (a), _mm_cvtsi32_si128 (b));
+	}
+	else
+		pix = _mm_loadl_epi64 ((__m128i *)psource);
+	return _mm256_cvtepu8_epi32 (pix);
+}
+
+/*
+=============
+R_DrawSurfaceBlockAVX2
+
+As R_DrawSurfaceBlockSSE2, with the lookups gathered
+=============
+*/
+D_TARGET_AVX2 static inline void R_DrawSurfaceBlockAVX2 (int shift)
+{
+	int				v, i, rows, blocksize;
+	int				lightleft, lightright, lightleftstep, lightrightstep;
+	int				lightstep, lightstep2, lightright2;
+	unsigned		*lightptr;
+	unsigned char	*psource, *prowdest, *colormap;
+	__m256i			ramp, light;
+
+	blocksize = 1 << shift;
+	colormap = (unsigned char *)vid.colormap;
+	if (blocksize == 4)
+		ramp = _mm256_setr_epi32 (3, 2, 1, 0, 3, 2, 1, 0);
+	else
+		ramp = _mm256_setr_epi32 (7, 6, 5, 4, 3, 2, 1, 0);
+
+	psource = pbasesource;
+	prowdest = prowdestbase;
+	lightptr = r_lightptr;
+
+	for (v=0 ; v<r_numvblocks ; v++)
+	{
+		lightleft = lightptr[0];
+		lightright = lightptr[1];
+		lightptr += r_lightwidth;
+		lightleftstep = (lightptr[0] - lightleft) >> shift;
+		lightrightstep = (lightptr[1] - lightright) >> shift;
+
+		for (i=0 ; i<blocksize ; i+=rows)
+		{
+			lightstep = (lightleft - lightright) >> shift;
+
+			if (blocksize == 4)
+			{
+				rows = 2;
+				lightright2 = lightright + lightrightstep;
+				lightstep2 = ((lightleft + lightleftstep) - lightright2) >> shift;
+				light = _mm256_add_epi32 (_mm256_setr_epi32 (lightright, lightright,
+						lightright, lightright, lightright2, lightright2,
+						lightright2, lightright2), _mm256_mullo_epi32 (ramp,
+						_mm256_setr_epi32 (lightstep, lightstep, lightstep, lightstep,
+						lightstep2, lightstep2, lightstep2, lightstep2)));
+				R_LightRowAVX2 (prowdest, prowdest + surfrowbytes,
+						R_LoadRowAVX2 (psource, psource + sourcetstep),
+						light, colormap);
+			}
+			else
+			{
+				rows = 1;
+				light = _mm256_add_epi32 (_mm256_set1_epi32 (lightright),
+						_mm256_mullo_epi32 (_mm256_set1_epi32 (lightstep), ramp));
+				if (blocksize == 16)
+				{
+					R_LightRowAVX2 (prowdest + 8, NULL,
+							R_LoadRowAVX2 (psource + 8, NULL), light, colormap);
+					light = _mm256_add_epi32 (light,
+							_mm256_set1_epi32 (lightstep * 8));
+				}
+				R_LightRowAVX2 (prowdest, NULL, R_LoadRowAVX2 (psource, NULL),
+						light, colormap);
+			}
+
+			psource += sourcetstep * rows;
+			lightright += lightrightstep * rows;
+			lightleft += lightleftstep * rows;
+			prowdest += surfrowbytes * rows;
+		}
+
+		if (psource >= r_sourcemax)
+			psource -= r_stepback;
+	}
+}
+
+D_TARGET_AVX2 static void R_DrawSurfaceBlock8_mip0AVX2 (void)
+{
+	R_DrawSurfaceBlockAVX2 (4);
+}
+
+D_TARGET_AVX2 static void R_DrawSurfaceBlock8_mip1AVX2 (void)
+{
+	R_DrawSurfaceBlockAVX2 (3);
+}
+
+D_TARGET_AVX2 static void R_DrawSurfaceBlock8_mip2AVX2 (void)
+{
+	R_DrawSurfaceBlockAVX2 (2);
+}
+
+#endif	// D_SIMD
+
+
+/*
+=============
+D_SelectSurfaceBlocks
+
+Points R_DrawSurface at the block builders for a SIMD level
+=============
+*/
+static void D_SelectSurfaceBlocks (int level)
+{
+	surfmiptable[0] = R_DrawSurfaceBlock8_mip0;
+	surfmiptable[1] = R_DrawSurfaceBlock8_mip1;
+	surfmiptable[2] = R_DrawSurfaceBlock8_mip2;
+	surfmiptable[3] = R_DrawSurfaceBlock8_mip3;
+
+#ifdef D_SIMD
+	if (level == SIMD_SSE2)
+	{
+		surfmiptable[0] = R_DrawSurfaceBlock8_mip0SSE2;
+		surfmiptable[1] = R_DrawSurfaceBlock8_mip1SSE2;
+		surfmiptable[2] = R_DrawSurfaceBlock8_mip2SSE2;
+	}
+	else if (level >= SIMD_AVX2)
+	{
+		surfmiptable[0] = R_DrawSurfaceBlock8_mip0AVX2;
+		surfmiptable[1] = R_DrawSurfaceBlock8_mip1AVX2;
+		surfmiptable[2] = R_DrawSurfaceBlock8_mip2AVX2;
+	}
+#endif
+}
+
+/*
+=============
+D_SelectDrawers
+
+Called every frame from D_SetupFrame, so d_simd takes effect at once
+=============
+*/
+void D_SelectDrawers (void)
+{
+	int		level;
+
+	d_drawspans = D_DrawSpans8;
+	d_drawzspans = D_DrawZSpans;
+	d_drawturbulent = Turbulent8;
+
+	level = d_simd.value ? d_simdlevel : SIMD_NONE;
+
+#ifdef D_SIMD
+	if (level >= SIMD_SSE2)
+	{
+		d_drawspans = D_DrawSpans8SSE2;
+		d_drawzspans = D_DrawZSpansSSE2;
+	}
+	if (level >= SIMD_AVX2)
+	{
+		d_drawspans = D_DrawSpans8AVX2;
+		d_drawzspans = D_DrawZSpansAVX2;
+		d_drawturbulent = Turbulent8AVX2;
+	}
+#endif
+
+	D_SelectSurfaceBlocks (level);
+}
+
+
+/*
+===============================================================================
+
+SPAN BENCHMARK
+
+spanbench records the spans of the next frame's textured and turbulent
+surfaces, with the drawing state for each, then replays them through every
+span drawer the CPU can run into a scratch view and z buffer, checking each
+against the C drawer's output.
+
+===============================================================================
+*/
+
+#define	SPANBENCH_REPS	20
+
+#define	SK_SPANS		0
+#define	SK_ZSPANS		1
+#define	SK_TURBULENT	2
+
+typedef struct spanrecord_s
+{
+	struct spanrecord_s	*next;
+	drawstate_t			state;
+	qboolean			turbulent;
+	espan_t				*spans;
+	int					pixels;
+} spanrecord_t;
+
+typedef struct
+{
+	char	*name;
+	void	(*func) (espan_t *pspan);
+	int		kind;
+	int		level;
+} spankernel_t;
+
+static spankernel_t	spankernels[] =
+{
+	{"spans8 C", D_DrawSpans8, SK_SPANS, SIMD_NONE},
+#ifdef D_SIMD
+	{"spans8 SSE2", D_DrawSpans8SSE2, SK_SPANS, SIMD_SSE2},
+	{"spans8 AVX2", D_DrawSpans8AVX2, SK_SPANS, SIMD_AVX2},
+#endif
+	{"zspans C", D_DrawZSpans, SK_ZSPANS, SIMD_NONE},
+#ifdef D_SIMD
+	{"zspans SSE2", D_DrawZSpansSSE2, SK_ZSPANS, SIMD_SSE2},
+	{"zspans AVX2", D_DrawZSpansAVX2, SK_ZSPANS, SIMD_AVX2},
+#endif
+	{"turbulent8 C", Turbulent8, SK_TURBULENT, SIMD_NONE},
+#ifdef D_SIMD
+	{"turbulent8 AVX2", Turbulent8AVX2, SK_TURBULENT, SIMD_AVX2},
+#endif
+	{NULL}
+};
+
+static spanrecord_t	*spanrecords;
+
+/*
+=============
+D_RecordSpans
+
+Copies a surface's spans and the current drawing state; the copies live in
+the frame arena, which outlives the frame's drawing
+=============
+*/
+void D_RecordSpans (espan_t *pspan, qboolean turbulent)
+{
+	spanrecord_t	*rec;
+	espan_t			**link;
+
+	rec = Frame_Alloc (sizeof(*rec));
+	D_SaveDrawState (&rec->state);
+	rec->turbulent = turbulent;
+	rec->pixels = 0;
+
+	link = &rec->spans;
+	for ( ; pspan ; pspan = pspan->pnext)
+	{
+		*link = Frame_Alloc (sizeof(espan_t));
+		**link = *pspan;
+		rec->pixels += pspan->count;
+		link = &(*link)->pnext;
+	}
+	*link = NULL;
+
+	rec->next = spanrecords;
+	spanrecords = rec;
+}
+
+/*
+=============
+D_RunKernel
+
+Draws every recorded surface the kernel handles once, returning the pixels
+=============
+*/
+static int D_RunKernel (spankernel_t *k)
+{
+	spanrecord_t	*rec;
+	int				pixels;
+
+	pixels = 0;
+	for (rec = spanrecords ; rec ; rec = rec->next)
+	{
+		if (k->kind != SK_ZSPANS && (k->kind == SK_TURBULENT) != rec->turbulent)
+			continue;
+		D_LoadDrawState (&rec->state);
+		k->func (rec->spans);
+		pixels += rec->pixels;
+	}
+	return pixels;
+}
+
+/*
+=============
+D_SpanBench
+
+Called by D_DrawSurfaces once the recorded frame has been drawn
+=============
+*/
+void D_SpanBench (void)
+{
+	spankernel_t	*k;
+	pixel_t			*viewbuffer, *view, *refview;
+	short			*zbuffer, *z, *refz;
+	int				viewsize, zsize, pixels, rep, refkind;
+	double			start, time;
+	drawstate_t		saved;
+	qboolean		same;
+
+	d_spanrecord = false;
+	if (!spanrecords)
+	{
+		Con_Printf ("spanbench: no spans were drawn\n");
+		return;
+	}
+
+	viewbuffer = d_viewbuffer;
+	zbuffer = d_pzbuffer;
+	D_SaveDrawState (&saved);
+
+	viewsize = screenwidth * r_refdef.vrectbottom;
+	zsize = d_zwidth * r_refdef.vrectbottom * sizeof(short);
+	view = malloc (viewsize);
+	refview = malloc (viewsize);
+	z = malloc (zsize);
+	refz = malloc (zsize);
+	if (!view || !refview || !z || !refz)
+		Sys_Error ("D_SpanBench: out of memory");
+	d_viewbuffer = view;
+	d_pzbuffer = z;
+
+	Con_Printf ("spanbench: %s span drawers\n", simdnames[d_simdlevel]);
+	refkind = -1;
+	for (k = spankernels ; k->name ; k++)
+	{
+		if (k->level > d_simdlevel)
+			continue;
+
+	// one pass to check against the C drawer, which comes first
+		memset (view, 0, viewsize);
+		memset (z, 0, zsize);
+		D_RunKernel (k);
+		if (k->kind != refkind)
+		{
+			memcpy (refview, view, viewsize);
+			memcpy (refz, z, zsize);
+			refkind = k->kind;
+		}
+		if (k->kind == SK_ZSPANS)
+			same = !memcmp (z, refz, zsize);
+		else
+			same = !memcmp (view, refview, viewsize);
+
+		pixels = 0;
+		start = Sys_FloatTime ();
+		for (rep=0 ; rep<SPANBENCH_REPS ; rep++)
+			pixels += D_RunKernel (k);
+		time = Sys_FloatTime () - start;
+
+		if (!pixels)
+			Con_Printf ("%-16s no pixels\n", k->name);
+		else
+			Con_Printf ("%-16s %7.1f Mpixels/s%s\n", k->name,
+					time > 0 ? pixels / time / 1000000 : 0,
+					same ? "" : "  MISMATCH");
+	}
+
+	free (view);
+	free (refview);
+	free (z);
+	free (refz);
+	d_viewbuffer = viewbuffer;
+	d_pzbuffer = zbuffer;
+	D_LoadDrawState (&saved);
+	spanrecords = NULL;
+}
+
+/*
+=============
+D_SpanBench_f
+=============
+*/
+static void D_SpanBench_f (void)
+{
+	if (cls.state != ca_connected)
+	{
+		Con_Printf ("spanbench: not connected to a server\n");
+		return;
+	}
+	spanrecords = NULL;
+	d_spanrecord = true;
+}
+
+
+/*
+===============================================================================
+
+SURFACE BLOCK BENCHMARK
+
+surfbench builds every surface of the current map at every mip level, with
+its real lightmaps, once with each set of block builders the CPU can run,
+and checks the results against the C builders'.
+
+===============================================================================
+*/
+
+#define	SURFBENCH_SIZE	(512*512)		// bigger than any surface at mip 0
+
+/*
+=============
+D_BuildSurfaces
+
+Builds every lit world surface at one mip level into scratch, which holds
+them one after another; returns the texels built
+=============
+*/
+static int D_BuildSurfaces (int miplevel, byte *scratch, int *scratchsize)
+{
+	msurface_t	*surf;
+	int			i, texels, size;
+	byte		*pdest;
+
+	texels = 0;
+	pdest = scratch;
+	surf = cl.worldmodel->surfaces;
+	for (i=0 ; i<cl.worldmodel->numsurfaces ; i++, surf++)
+	{
+		if (surf->flags & (SURF_DRAWSKY | SURF_DRAWTURB))
+			continue;
+		if (!surf->texinfo->texture)
+			continue;
+
+		r_drawsurf.texture = surf->texinfo->texture;
+		r_drawsurf.lightadj[0] = d_lightstylevalue[surf->styles[0]];
+		r_drawsurf.lightadj[1] = d_lightstylevalue[surf->styles[1]];
+		r_drawsurf.lightadj[2] = d_lightstylevalue[surf->styles[2]];
+		r_drawsurf.lightadj[3] = d_lightstylevalue[surf->styles[3]];
+		r_drawsurf.surfmip = miplevel;
+		r_drawsurf.surfwidth = surf->extents[0] >> miplevel;
+		r_drawsurf.rowbytes = r_drawsurf.surfwidth;
+		r_drawsurf.surfheight = surf->extents[1] >> miplevel;
+		r_drawsurf.surf = surf;
+
+		size = r_drawsurf.surfwidth * r_drawsurf.surfheight;
+		if (pdest + size > scratch + *scratchsize)
+			pdest = scratch;		// only the last lap is compared
+		r_drawsurf.surfdat = pdest;
+		R_DrawSurface ();
+		pdest += size;
+		texels += size;
+	}
+
+	*scratchsize = pdest - scratch;
+	return texels;
+}
+
+/*
+=============
+D_SurfBench_f
+=============
+*/
+static void D_SurfBench_f (void)
+{
+	int			level, miplevel, texels, rep, size, refsize;
+	byte		*scratch, *ref;
+	double		start, time;
+	qboolean	same;
+	drawsurf_t	saved;
+
+	if (cls.state != ca_connected || !cl.worldmodel)
+	{
+		Con_Printf ("surfbench: no map loaded\n");
+		return;
+	}
+
+	R_SyncView ();		// the drawers are switched under the render thread
+
+	scratch = malloc (SURFBENCH_SIZE * 16);
+	ref = malloc (SURFBENCH_SIZE * 16);
+	if (!scratch || !ref)
+		Sys_Error ("D_SurfBench_f: out of memory");
+	saved = r_drawsurf;
+	refsize = 0;
+
+	for (miplevel=0 ; miplevel<4 ; miplevel++)
+	{
+		for (level=SIMD_NONE ; level<=d_simdlevel ; level++)
+		{
+			D_SelectSurfaceBlocks (level);
+
+			size = SURFBENCH_SIZE * 16;
+			memset (scratch, 0, size);
+			D_BuildSurfaces (miplevel, scratch, &size);
+			if (level == SIMD_NONE)
+			{
+				memcpy (ref, scratch, size);
+				refsize = size;
+			}
+			same = size == refsize && !memcmp (scratch, ref, size);
+
+			texels = 0;
+			start = Sys_FloatTime ();
+			for (rep=0 ; rep<SPANBENCH_REPS ; rep++)
+			{
+				size = SURFBENCH_SIZE * 16;
+				texels += D_BuildSurfaces (miplevel, scratch, &size);
+			}
+			time = Sys_FloatTime () - start;
+
+			Con_Printf ("mip%i %-5s %7.1f Mtexels/s%s\n", miplevel,
+					simdnames[level], time > 0 ? texels / time / 1000000 : 0,
+					same ? "" : "  MISMATCH");
+		}
+	}
+
+	r_drawsurf = saved;
+	D_SelectSurfaceBlocks (d_simd.value ? d_simdlevel : SIMD_NONE);
+	free (scratch);
+	free (ref);
+}
+
+
+/*
+=============
+D_SIMDInit
+=============
+*/
+void D_SIMDInit (void)
+{
+	Cvar_RegisterVariable (&d_simd);
+	Cmd_AddCommand ("spanbench", D_SpanBench_f);
+	Cmd_AddCommand ("surfbench", D_SurfBench_f);
+
+#ifdef D_SIMD
+	d_simdlevel = D_DetectSIMD ();
+#else
+	d_simdlevel = SIMD_NONE;
+#endif
+	Con_Printf ("%s span drawers\n", simdnames[d_simdlevel]);
+}
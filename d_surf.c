@@ -26,11 +26,46 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 float           surfscale;
 qboolean        r_cache_thrash;         // set if surface cache is thrashing
 
+int				d_surfmisses;			// surfaces built this frame
+int				d_surfdeferred;			// of those, built by D_RunSurfaceBuilds
+double			d_surfbuildtime;		// seconds spent building, if reported
+
+typedef struct
+{
+	drawsurf_t	drawsurf;			// R_DrawSurface's input
+	surfcache_t	*cache;
+	int			miplevel;
+} surfbuild_t;
+
+static qboolean		d_deferbuilds;
+static surfbuild_t	*d_builds;
+static int			d_numbuilds, d_maxbuilds;
+
 int                                     sc_size;
 surfcache_t                     *sc_rover, *sc_base;
 
 #define GUARDSIZE       4
 
+cvar_t	d_surfcachegrow = {"d_surfcachegrow", "0"};	// grow when it thrashes
+cvar_t	d_surfcachemax = {"d_surfcachemax", "16384"};	// KB it may grow to
+
+#define SC_GROWAFTER	3		// frames in a row that must thrash
+
+typedef struct
+{
+	int		frames;
+	int		allocs;
+	int		evictions;				// of blocks drawn from last frame or this
+	int		thrashed;				// frames
+	int		builds[MIPLEVELS];
+	double	bytes[MIPLEVELS];		// built; totals outgrow an int
+} scstats_t;
+
+static scstats_t	sc_frame, sc_last, sc_total;
+static int			sc_thrashrun;	// frames in a row that thrashed
+static int			sc_grows;
+static void			*sc_grown;		// malloced buffer D_SCGrow moved into
+
 
 int     D_SurfaceCacheForRes (int width, int height)
 {
@@ -86,6 +121,12 @@ void D_InitCaches (void *buffer, int size)
 	if (!msg_suppress_1)
 		Con_Printf ("%ik surface cache\n", size/1024);
 
+	if (sc_grown && buffer != sc_grown)
+	{
+		free (sc_grown);
+		sc_grown = NULL;
+	}
+
 	sc_size = size - GUARDSIZE;
 	sc_base = (surfcache_t *)buffer;
 	sc_rover = sc_base;
@@ -122,6 +163,18 @@ void D_FlushCaches (void)
 	sc_base->size = sc_size;
 }
 
+/*
+=================
+D_SCEvict
+=================
+*/
+static void D_SCEvict (surfcache_t *cache)
+{
+	*cache->owner = NULL;
+	if (cache->framecount >= r_framecount - 1)
+		sc_frame.evictions++;		// will most likely be built again
+}
+
 /*
 =================
 D_SCAlloc
@@ -158,7 +211,7 @@ surfcache_t     *D_SCAlloc (int width, int size)
 // colect and free surfcache_t blocks until the rover block is large enough
 	new = sc_rover;
 	if (sc_rover->owner)
-		*sc_rover->owner = NULL;
+		D_SCEvict (sc_rover);
 	
 	while (new->size < size)
 	{
@@ -167,7 +220,7 @@ surfcache_t     *D_SCAlloc (int width, int size)
 		if (!sc_rover)
 			Sys_Error ("D_SCAlloc: hit the end of memory");
 		if (sc_rover->owner)
-			*sc_rover->owner = NULL;
+			D_SCEvict (sc_rover);
 			
 		new->size += sc_rover->size;
 		new->next = sc_rover->next;
@@ -194,10 +247,15 @@ surfcache_t     *D_SCAlloc (int width, int size)
 
 	new->owner = NULL;              // should be set properly after return
 
+	sc_frame.allocs++;
+
 	if (d_roverwrapped)
 	{
 		if (wrapped_this_time || (sc_rover >= d_initial_rover))
+		{
 			r_cache_thrash = true;
+			sc_frame.thrashed = 1;
+		}
 	}
 	else if (wrapped_this_time)
 	{       
@@ -209,6 +267,29 @@ D_CheckCacheGuard ();   // DEBUG
 }
 
 
+/*
+=================
+D_SCStats
+
+Bytes in blocks that still belong to a surface, for memstats
+=================
+*/
+void D_SCStats (int *used, int *size, int *blocks)
+{
+	surfcache_t             *test;
+
+	*used = 0;
+	*blocks = 0;
+	*size = sc_size;
+	for (test = sc_base ; test ; test = test->next)
+		if (test->owner)
+		{
+			*used += test->size;
+			(*blocks)++;
+		}
+}
+
+
 /*
 =================
 D_SCDump
@@ -226,6 +307,285 @@ void D_SCDump (void)
 	}
 }
 
+/*
+===============================================================================
+
+DEFERRED SURFACE BUILDS
+
+While the banded drawer sets up its surfaces, D_CacheSurface still picks and
+allocates the cache block for every miss and fills in the block's header, but
+only queues the texture build; D_RunSurfaceBuilds then does all the builds at
+once on the job threads, before any span is drawn.
+
+A block allocated this frame is only ever thrown out once the allocator has
+gone all the way round the cache (r_cache_thrash), so while that hasn't
+happened every queued block is still where it was put.  The first allocation
+that thrashes builds everything queued so far, in order, skipping blocks that
+allocation just took back, and the rest of the frame builds inline as before.
+
+===============================================================================
+*/
+
+/*
+================
+D_DeferSurfaceBuilds
+
+Queues up to maxbuilds builds; more than that are built inline
+================
+*/
+void D_DeferSurfaceBuilds (int maxbuilds)
+{
+	d_numbuilds = 0;
+	d_maxbuilds = maxbuilds;
+	d_builds = Frame_Alloc (maxbuilds * sizeof(*d_builds));
+	d_deferbuilds = !r_cache_thrash;
+}
+
+/*
+================
+D_BuildSurface
+
+Builds the surface in r_drawsurf, timing it if r_reportsurfcache is set
+================
+*/
+static void D_BuildSurface (void)
+{
+	double	start;
+
+	if (!r_reportsurfcache.value)
+	{
+		R_DrawSurface ();
+		return;
+	}
+
+	start = Sys_FloatTime ();
+	R_DrawSurface ();
+	d_surfbuildtime += Sys_FloatTime () - start;
+}
+
+/*
+================
+D_BuildQueued
+
+Job function: builds queued surfaces [first, first+count)
+================
+*/
+static void D_BuildQueued (void *data, int first, int count)
+{
+	surfbuild_t	*build;
+
+	for (build = d_builds + first ; build < d_builds + first + count ; build++)
+	{
+		r_drawsurf = build->drawsurf;
+		R_DrawSurface ();
+	}
+}
+
+/*
+================
+D_RunSurfaceBuilds
+
+Builds everything queued since D_DeferSurfaceBuilds and stops deferring.
+The queue is built on the job threads if parallel is set, which the caller
+only does when no cache block appears in it twice; otherwise it is built in
+order on this thread.
+================
+*/
+void D_RunSurfaceBuilds (qboolean parallel)
+{
+	surfbuild_t	*build;
+	drawsurf_t	saved;
+	double		start;
+
+	d_deferbuilds = false;
+	if (!d_numbuilds)
+		return;
+
+	start = Sys_FloatTime ();
+
+	if (parallel && Job_NumThreads ())
+	{
+		Job_Add (D_BuildQueued, NULL, d_numbuilds, 1);
+		Job_Wait ();
+	}
+	else
+	{
+		saved = r_drawsurf;
+		for (build = d_builds ; build < d_builds + d_numbuilds ; build++)
+		{
+		// skip blocks that were taken back after being queued
+			if (build->drawsurf.surf->cachespots[build->miplevel]
+				!= build->cache)
+				continue;
+			r_drawsurf = build->drawsurf;
+			R_DrawSurface ();
+		}
+		r_drawsurf = saved;
+	}
+
+	d_surfdeferred += d_numbuilds;
+	d_surfbuildtime += Sys_FloatTime () - start;
+	d_numbuilds = 0;
+}
+
+/*
+===============================================================================
+
+CACHE STATISTICS AND GROWTH
+
+D_SurfaceCacheForRes only goes by the resolution, and a cache too small for
+the view thrashes: surfaces get thrown out and rebuilt every frame.  The
+counters below are kept per frame and totalled, and the surfcache command
+reports them.  With d_surfcachegrow set, a cache that thrashes SC_GROWAFTER
+frames in a row is moved into a half again bigger malloced buffer, up to
+d_surfcachemax KB.  The buffer the video code gave D_InitCaches is left
+unused until the next mode change, which frees the grown one.
+
+===============================================================================
+*/
+
+/*
+=================
+D_SCGrow
+=================
+*/
+static void D_SCGrow (void)
+{
+	int		size, max;
+	void	*buffer;
+
+	max = (int)d_surfcachemax.value * 1024;
+	size = sc_size + GUARDSIZE;
+	if (size >= max)
+		return;
+
+	size += size / 2;
+	if (size > max)
+		size = max;
+
+	buffer = malloc (size);
+	if (!buffer)
+		return;
+
+	D_FlushCaches ();
+	D_InitCaches (buffer, size);
+	sc_grown = buffer;
+	sc_grows++;
+}
+
+/*
+=================
+D_SCNewFrame
+
+Totals up the last frame's counters, and grows the cache if it keeps
+thrashing.  Called before anything is allocated for the new frame.
+=================
+*/
+void D_SCNewFrame (void)
+{
+	int		i;
+
+	sc_last = sc_frame;
+
+	sc_total.frames++;
+	sc_total.allocs += sc_frame.allocs;
+	sc_total.evictions += sc_frame.evictions;
+	sc_total.thrashed += sc_frame.thrashed;
+	for (i=0 ; i<MIPLEVELS ; i++)
+	{
+		sc_total.builds[i] += sc_frame.builds[i];
+		sc_total.bytes[i] += sc_frame.bytes[i];
+	}
+
+	if (sc_frame.thrashed)
+		sc_thrashrun++;
+	else
+		sc_thrashrun = 0;
+
+	memset (&sc_frame, 0, sizeof(sc_frame));
+
+	if (d_surfcachegrow.value && sc_thrashrun >= SC_GROWAFTER)
+	{
+		sc_thrashrun = 0;
+		D_SCGrow ();
+	}
+}
+
+/*
+=================
+D_SCReport_f
+
+surfcache [clear]
+=================
+*/
+void D_SCReport_f (void)
+{
+	surfcache_t	*test;
+	int			i, live;
+	double		bytes;
+
+	R_SyncView ();
+
+	if (Cmd_Argc () == 2 && !Q_strcmp (Cmd_Argv(1), "clear"))
+	{
+		memset (&sc_total, 0, sizeof(sc_total));
+		sc_grows = 0;
+		return;
+	}
+
+	if (!sc_base)
+		return;
+
+	live = 0;
+	for (test = sc_base ; test ; test = test->next)
+		if (test->owner && test->framecount >= r_framecount - 1)
+			live += test->size;
+
+	Con_Printf ("%ik surface cache at %ix%i (%ik by default), %ik drawn from\n",
+		(sc_size + GUARDSIZE)/1024, vid.width, vid.height,
+		D_SurfaceCacheForRes (vid.width, vid.height)/1024, live/1024);
+	if (d_surfcachegrow.value || sc_grows)
+		Con_Printf ("grown %i times, up to %ik\n", sc_grows,
+			(int)d_surfcachemax.value);
+
+	bytes = 0;
+	for (i=0 ; i<MIPLEVELS ; i++)
+		bytes += sc_last.bytes[i];
+	Con_Printf ("last frame: %i allocs, %i evictions, %.1fk built%s\n",
+		sc_last.allocs, sc_last.evictions, bytes / 1024,
+		sc_last.thrashed ? ", thrashed" : "");
+
+	if (!sc_total.frames)
+		return;
+
+	Con_Printf ("%i frames: %.1f allocs, %.1f evictions per frame, "
+		"%i thrashed\n", sc_total.frames,
+		(float)sc_total.allocs / sc_total.frames,
+		(float)sc_total.evictions / sc_total.frames, sc_total.thrashed);
+
+	bytes = 0;
+	for (i=0 ; i<MIPLEVELS ; i++)
+	{
+		bytes += sc_total.bytes[i];
+		if (sc_total.builds[i])
+			Con_Printf ("mip %i: %i built, %i bytes average\n", i,
+				sc_total.builds[i], (int)(sc_total.bytes[i] / sc_total.builds[i]));
+	}
+	Con_Printf ("%.1fk built per frame\n", bytes / 1024 / sc_total.frames);
+}
+
+/*
+=================
+D_SCInit
+=================
+*/
+void D_SCInit (void)
+{
+	Cvar_RegisterVariable (&d_surfcachegrow);
+	Cvar_RegisterVariable (&d_surfcachemax);
+	Cmd_AddCommand ("surfcache", D_SCReport_f);
+}
+
 //=============================================================================
 
 // if the num is not a power of 2, assume it will not repeat
@@ -285,7 +645,10 @@ surfcache_t *D_CacheSurface (msurface_t *surface, int miplevel)
 			&& cache->lightadj[1] == r_drawsurf.lightadj[1]
 			&& cache->lightadj[2] == r_drawsurf.lightadj[2]
 			&& cache->lightadj[3] == r_drawsurf.lightadj[3] )
+	{
+		cache->framecount = r_framecount;
 		return cache;
+	}
 
 //
 // determine shape of surface
@@ -306,6 +669,11 @@ surfcache_t *D_CacheSurface (msurface_t *surface, int miplevel)
 		surface->cachespots[miplevel] = cache;
 		cache->owner = &surface->cachespots[miplevel];
 		cache->mipscale = surfscale;
+
+	// once the allocator has started throwing out this frame's blocks,
+	// queued builds can no longer trust their block
+		if (d_deferbuilds && r_cache_thrash)
+			D_RunSurfaceBuilds (false);
 	}
 	
 	if (surface->dlightframe == r_framecount)
@@ -315,6 +683,7 @@ surfcache_t *D_CacheSurface (msurface_t *surface, int miplevel)
 
 	r_drawsurf.surfdat = (pixel_t *)cache->data;
 	
+	cache->framecount = r_framecount;
 	cache->texture = r_drawsurf.texture;
 	cache->lightadj[0] = r_drawsurf.lightadj[0];
 	cache->lightadj[1] = r_drawsurf.lightadj[1];
@@ -327,7 +696,19 @@ surfcache_t *D_CacheSurface (msurface_t *surface, int miplevel)
 	r_drawsurf.surf = surface;
 
 	c_surf++;
-	R_DrawSurface ();
+	d_surfmisses++;
+	sc_frame.builds[miplevel]++;
+	sc_frame.bytes[miplevel] += r_drawsurf.surfwidth * r_drawsurf.surfheight;
+
+	if (d_deferbuilds && d_numbuilds < d_maxbuilds)
+	{
+		d_builds[d_numbuilds].drawsurf = r_drawsurf;
+		d_builds[d_numbuilds].cache = cache;
+		d_builds[d_numbuilds].miplevel = miplevel;
+		d_numbuilds++;
+	}
+	else
+		D_BuildSurface ();
 
 	return surface->cachespots[miplevel];
 }
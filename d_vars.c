@@ -20,6 +20,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 // r_vars.c: global refresh variables
 
 #include	"quakedef.h"
+#include	"d_local.h"
 
 #if	!id386
 
@@ -33,14 +34,14 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 // FIXME: make into one big structure, like cl or sv
 // FIXME: do separately for refresh engine and driver
 
-float	d_sdivzstepu, d_tdivzstepu, d_zistepu;
-float	d_sdivzstepv, d_tdivzstepv, d_zistepv;
-float	d_sdivzorigin, d_tdivzorigin, d_ziorigin;
+D_THREADLOCAL float	d_sdivzstepu, d_tdivzstepu, d_zistepu;
+D_THREADLOCAL float	d_sdivzstepv, d_tdivzstepv, d_zistepv;
+D_THREADLOCAL float	d_sdivzorigin, d_tdivzorigin, d_ziorigin;
 
-fixed16_t	sadjust, tadjust, bbextents, bbextentt;
+D_THREADLOCAL fixed16_t	sadjust, tadjust, bbextents, bbextentt;
 
-pixel_t			*cacheblock;
-int				cachewidth;
+D_THREADLOCAL pixel_t	*cacheblock;
+D_THREADLOCAL int		cachewidth;
 pixel_t			*d_viewbuffer;
 short			*d_pzbuffer;
 unsigned int	d_zrowbytes;
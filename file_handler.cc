@@ -130,6 +130,70 @@ namespace {
     int64_t offset_;
     pp::CompletionCallbackFactory<WriteInProgress> callback_factory_;
   };
+
+  class RangeWriteInProgress {
+   public:
+    RangeWriteInProgress(pp::FileIO* file, int64_t length,
+                         const std::vector<FileHandler::WriteRange>& ranges,
+                         std::tr1::function<void (int32_t)> progress_callback,
+                         std::tr1::function<void ()> finished_callback)
+        : file_(file), ranges_(ranges), progress_callback_(progress_callback),
+          finished_callback_(finished_callback), range_(0), offset_(0),
+          callback_factory_(this) {
+      if (length >= 0) {
+        file_->SetLength(
+            length,
+            callback_factory_.NewCallback(
+                &RangeWriteInProgress::FileLengthWasSet));
+      } else {
+        WriteMore();
+      }
+    }
+   private:
+    void WriteMore() {
+      // Skip past finished (or empty) ranges.
+      while (range_ < ranges_.size() && offset_ >= ranges_[range_].length) {
+        ++range_;
+        offset_ = 0;
+      }
+      if (range_ == ranges_.size()) {
+        if (finished_callback_)
+          finished_callback_();
+        delete this;
+        return;
+      }
+      const FileHandler::WriteRange& range = ranges_[range_];
+      PRINTF("WriteMore: range %zd, offset=%"NACL_PRId64", length=%"
+             NACL_PRId32", done=%"NACL_PRId32"\n",
+             range_, range.offset, range.length, offset_);
+      file_->Write(range.offset + offset_,
+                   range.data + offset_,
+                   range.length - offset_,
+                   callback_factory_.NewCallback(
+                       &RangeWriteInProgress::BytesWereWritten));
+    }
+    void FileLengthWasSet(int32_t result) {
+      PRINTF("FileLengthWasSet result=%"NACL_PRId32"\n", result);
+      WriteMore();
+    }
+    void BytesWereWritten(int32_t bytes_written) {
+      PRINTF("BytesWereWritten: bytes_written=%"NACL_PRId32"\n",
+             bytes_written);
+      CHECK(bytes_written >= 0);
+      offset_ += bytes_written;
+      if (progress_callback_)
+        progress_callback_(bytes_written);
+      WriteMore();
+    }
+
+    pp::FileIO* file_;
+    std::vector<FileHandler::WriteRange> ranges_;
+    std::tr1::function<void (int32_t)> progress_callback_;
+    std::tr1::function<void ()> finished_callback_;
+    size_t range_;
+    int32_t offset_;
+    pp::CompletionCallbackFactory<RangeWriteInProgress> callback_factory_;
+  };
 }  // namespace
 
 namespace FileHandler {
@@ -143,5 +207,12 @@ namespace FileHandler {
                    std::tr1::function<void ()> finished_callback) {
     new WriteInProgress(file, data, progress_callback, finished_callback);
   }
+  void WriteRangesToFile(pp::FileIO* file, int64_t length,
+                         const std::vector<WriteRange>& ranges,
+                         std::tr1::function<void (int32_t)> progress_callback,
+                         std::tr1::function<void ()> finished_callback) {
+    new RangeWriteInProgress(file, length, ranges, progress_callback,
+                             finished_callback);
+  }
 }
 
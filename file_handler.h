@@ -13,6 +13,15 @@
 // FileHandler functions are used to read from a file to a vector or write from
 // a vector to a file. It then calls you back when it's done.
 namespace FileHandler {
+  // |length| bytes starting at |data|, to be written at |offset| in a file.
+  struct WriteRange {
+    WriteRange(int64_t offset_arg, const char* data_arg, int32_t length_arg)
+        : offset(offset_arg), data(data_arg), length(length_arg) {}
+    int64_t offset;
+    const char* data;
+    int32_t length;
+  };
+
   // Read all the data in the file and put the results in data. Assumes the
   // pointers remain valid until the file is done.
   void ReadFromFile(pp::FileIO* file, std::vector<char>* data,
@@ -23,6 +32,13 @@ namespace FileHandler {
   void WriteToFile(pp::FileIO* file, std::vector<char>* data,
                    std::tr1::function<void (int32_t)> progress_callback,
                    std::tr1::function<void ()> finished_callback);
+  // Write only |ranges| to the file, leaving the rest of it alone.  If
+  // |length| is not negative, the file is first truncated or extended to
+  // |length| bytes.  Assumes the pointers remain valid until the file is done.
+  void WriteRangesToFile(pp::FileIO* file, int64_t length,
+                         const std::vector<WriteRange>& ranges,
+                         std::tr1::function<void (int32_t)> progress_callback,
+                         std::tr1::function<void ()> finished_callback);
 }
 
 #endif  // FILE_HANDLER_H_
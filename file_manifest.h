@@ -0,0 +1,362 @@
+// Prefetch manifest, consumed by FileManager::LoadManifest. This one is not
+// from a trace: it lists what Quake reads before the startup demo as startup
+// files, and registers everything else from the old file_list.h, in its
+// order, for idle prefetching. No map groups are claimed until a real trace
+// says which files each map loads. Generate one with
+//   quake -filetrace ...
+//   ./make_manifest.py id1/filetrace.txt > file_manifest.h
+const nacl_file::ManifestEntry file_manifest[] = {
+{"id1/config.cfg", 0u, nacl_file::FETCH_STARTUP, NULL},
+{"id1/gfx.wad", 0u, nacl_file::FETCH_STARTUP, NULL},
+{"id1/gfx/palette.lmp", 0u, nacl_file::FETCH_STARTUP, NULL},
+{"id1/gfx/colormap.lmp", 0u, nacl_file::FETCH_STARTUP, NULL},
+{"id1/gfx/complete.lmp", 0u, nacl_file::FETCH_STARTUP, NULL},
+{"id1/sound/ambience/water1.wav", 0u, nacl_file::FETCH_STARTUP, NULL},
+{"id1/sound/ambience/wind2.wav", 0u, nacl_file::FETCH_STARTUP, NULL},
+{"id1/sound/wizard/hit.wav", 0u, nacl_file::FETCH_STARTUP, NULL},
+{"id1/sound/hknight/hit.wav", 0u, nacl_file::FETCH_STARTUP, NULL},
+{"id1/sound/weapons/tink1.wav", 0u, nacl_file::FETCH_STARTUP, NULL},
+{"id1/sound/weapons/ric1.wav", 0u, nacl_file::FETCH_STARTUP, NULL},
+{"id1/sound/weapons/ric2.wav", 0u, nacl_file::FETCH_STARTUP, NULL},
+{"id1/sound/weapons/ric3.wav", 0u, nacl_file::FETCH_STARTUP, NULL},
+{"id1/sound/weapons/r_exp3.wav", 0u, nacl_file::FETCH_STARTUP, NULL},
+{"id1/quake.rc", 0u, nacl_file::FETCH_STARTUP, NULL},
+{"id1/default.cfg", 0u, nacl_file::FETCH_STARTUP, NULL},
+{"id1/demo1.dem", 0u, nacl_file::FETCH_STARTUP, NULL},
+{"id1/maps/e1m3.bsp", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/progs/player.mdl", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/progs/eyes.mdl", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/progs/h_player.mdl", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/progs/gib1.mdl", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/progs/gib2.mdl", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/progs/gib3.mdl", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/progs/s_bubble.spr", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/progs/s_explod.spr", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/progs/v_axe.mdl", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/progs/v_shot.mdl", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/progs/v_nail.mdl", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/progs/v_rock.mdl", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/progs/v_shot2.mdl", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/progs/v_nail2.mdl", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/progs/v_rock2.mdl", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/progs/bolt.mdl", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/progs/bolt2.mdl", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/progs/bolt3.mdl", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/progs/lavaball.mdl", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/progs/missile.mdl", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/progs/grenade.mdl", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/progs/spike.mdl", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/progs/s_spike.mdl", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/progs/backpack.mdl", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/progs/zom_gib.mdl", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/progs/v_light.mdl", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/progs/s_light.spr", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/progs/flame.mdl", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/progs/flame2.mdl", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/progs/zombie.mdl", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/progs/h_zombie.mdl", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/progs/w_g_key.mdl", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/progs/ogre.mdl", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/progs/h_ogre.mdl", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/progs/demon.mdl", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/progs/h_demon.mdl", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/progs/wizard.mdl", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/progs/h_wizard.mdl", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/progs/w_spike.mdl", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/progs/g_nail.mdl", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/maps/b_shell1.bsp", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/maps/b_bh25.bsp", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/maps/b_bh10.bsp", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/maps/b_bh100.bsp", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/progs/g_shot.mdl", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/maps/b_shell0.bsp", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/maps/b_rock0.bsp", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/maps/b_nail1.bsp", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/maps/b_nail0.bsp", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/progs/armor.mdl", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/maps/b_rock1.bsp", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/progs/g_rock.mdl", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/progs/invisibl.mdl", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/weapons/rocket1i.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/weapons/sgun1.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/weapons/guncock.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/weapons/spike2.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/weapons/grenade.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/weapons/bounce.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/weapons/shotgn2.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/demon/dland2.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/misc/h2ohit1.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/items/itembk2.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/player/plyrjmp8.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/player/land.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/player/land2.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/player/drown1.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/player/drown2.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/player/gasp1.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/player/gasp2.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/player/h2odeath.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/misc/talk.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/player/teledth1.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/misc/r_tele1.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/misc/r_tele2.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/misc/r_tele3.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/misc/r_tele4.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/misc/r_tele5.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/weapons/lock4.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/weapons/pkup.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/items/armor1.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/weapons/lhit.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/player/gib.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/player/udeath.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/player/tornoff2.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/player/pain1.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/player/pain2.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/player/pain3.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/player/pain4.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/player/pain5.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/player/pain6.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/player/death1.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/player/death2.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/player/death3.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/player/death4.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/player/death5.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/weapons/ax1.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/player/axhit1.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/player/axhit2.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/player/h2ojump.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/player/slimbrn2.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/player/inh2o.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/player/inlava.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/misc/outwater.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/player/lburn1.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/player/lburn2.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/misc/water1.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/misc/water2.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/doors/medtry.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/doors/meduse.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/doors/stndr1.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/doors/stndr2.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/misc/null.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/plats/train2.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/plats/train1.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/buttons/switch02.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/doors/drclos4.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/doors/doormv1.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/ambience/fire1.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/doors/basesec1.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/doors/basesec2.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/doors/latch2.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/doors/winch2.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/zombie/z_idle.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/zombie/z_idle1.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/zombie/z_shot1.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/zombie/z_gib.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/zombie/z_pain.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/zombie/z_pain1.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/zombie/z_fall.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/zombie/z_miss.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/zombie/z_hit.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/zombie/idle_w2.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/plats/medplat1.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/plats/medplat2.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/buttons/airbut1.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/misc/medkey.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/ambience/hum1.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/ogre/ogdrag.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/ogre/ogdth.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/ogre/ogidle.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/ogre/ogidle2.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/ogre/ogpain1.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/ogre/ogsawatk.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/ogre/ogwake.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/wizard/wattack.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/wizard/wdeath.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/wizard/widle1.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/wizard/widle2.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/wizard/wpain.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/wizard/wsight.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/demon/ddeath.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/demon/dhit2.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/demon/djump.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/demon/dpain1.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/demon/idle1.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/demon/sight2.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/items/health1.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/items/r_item1.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/misc/secret.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/items/inv1.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/items/inv2.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/items/inv3.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/ambience/drip1.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/ambience/swamp2.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/ambience/swamp1.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/s0.sav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/s1.sav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/s2.sav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/s3.sav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/s4.sav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/s5.sav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/s6.sav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/s7.sav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/s8.sav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/s9.sav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/s10.sav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/s11.sav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/items/r_item2.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/misc/runekey.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/items/protect.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/items/protect2.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/items/protect3.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/items/suit.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/items/suit2.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/items/damage.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/items/damage2.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/items/damage3.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/misc/menu1.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/misc/menu2.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/misc/menu3.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/weapons/lstart.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/misc/power.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/doors/runetry.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/doors/runeuse.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/doors/basetry.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/doors/baseuse.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/doors/hydro1.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/doors/hydro2.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/doors/ddoor1.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/doors/ddoor2.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/doors/airdoor1.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/doors/airdoor2.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/buttons/switch21.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/buttons/switch04.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/misc/trigger1.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/ambience/windfly.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/plats/plat1.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/plats/plat2.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/ambience/fl_hum1.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/ambience/buzz1.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/ambience/suck1.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/ambience/drone6.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/ambience/comp1.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/ambience/thunder1.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/shambler/sattck1.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/shambler/sboom.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/shambler/sdeath.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/shambler/shurt2.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/shambler/sidle.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/shambler/ssight.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/shambler/melee1.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/shambler/melee2.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/shambler/smack.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/knight/kdeath.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/knight/khurt.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/knight/ksight.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/knight/sword1.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/knight/sword2.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/knight/idle.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/soldier/death1.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/soldier/idle.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/soldier/pain1.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/soldier/pain2.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/soldier/sattck1.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/soldier/sight1.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/dog/dattack1.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/dog/ddeath.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/dog/dpain1.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/dog/dsight.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/dog/idle.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/boss1/out1.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/boss1/sight1.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/boss1/throw.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/boss1/pain.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/sound/boss1/death.wav", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/progs/g_nail2.mdl", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/progs/g_rock2.mdl", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/progs/g_light.mdl", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/maps/b_batt1.bsp", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/maps/b_batt0.bsp", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/progs/w_s_key.mdl", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/progs/m_s_key.mdl", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/progs/m_g_key.mdl", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/progs/end1.mdl", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/progs/invulner.mdl", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/progs/suit.mdl", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/progs/quaddama.mdl", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/maps/b_explob.bsp", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/progs/shambler.mdl", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/progs/s_light.mdl", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/progs/h_shams.mdl", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/progs/knight.mdl", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/progs/h_knight.mdl", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/progs/soldier.mdl", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/progs/h_guard.mdl", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/progs/h_dog.mdl", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/progs/dog.mdl", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/progs/boss.mdl", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/progs.dat", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/end1.bin", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/demo2.dem", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/demo3.dem", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/gfx/inter.lmp", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/gfx/ranking.lmp", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/gfx/vidmodes.lmp", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/gfx/finale.lmp", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/gfx/conback.lmp", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/gfx/qplaque.lmp", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/gfx/menudot1.lmp", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/gfx/menudot2.lmp", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/gfx/menudot3.lmp", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/gfx/menudot4.lmp", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/gfx/menudot5.lmp", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/gfx/menudot6.lmp", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/gfx/menuplyr.lmp", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/gfx/bigbox.lmp", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/gfx/dim_modm.lmp", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/gfx/dim_drct.lmp", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/gfx/dim_ipx.lmp", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/gfx/dim_tcp.lmp", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/gfx/dim_mult.lmp", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/gfx/mainmenu.lmp", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/gfx/box_tl.lmp", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/gfx/box_tm.lmp", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/gfx/box_tr.lmp", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/gfx/box_ml.lmp", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/gfx/box_mm.lmp", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/gfx/box_mm2.lmp", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/gfx/box_mr.lmp", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/gfx/box_bl.lmp", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/gfx/box_bm.lmp", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/gfx/box_br.lmp", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/gfx/sp_menu.lmp", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/gfx/ttl_sgl.lmp", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/gfx/ttl_main.lmp", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/gfx/ttl_cstm.lmp", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/gfx/mp_menu.lmp", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/gfx/netmen1.lmp", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/gfx/netmen2.lmp", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/gfx/netmen3.lmp", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/gfx/netmen4.lmp", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/gfx/netmen5.lmp", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/gfx/sell.lmp", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/gfx/help0.lmp", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/gfx/help1.lmp", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/gfx/help2.lmp", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/gfx/help3.lmp", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/gfx/help4.lmp", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/gfx/help5.lmp", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/gfx/pause.lmp", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/gfx/loading.lmp", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/gfx/p_option.lmp", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/gfx/p_load.lmp", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/gfx/p_save.lmp", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/gfx/p_multi.lmp", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/maps/start.bsp", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/maps/e1m1.bsp", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/maps/e1m2.bsp", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/maps/e1m4.bsp", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/maps/e1m5.bsp", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/maps/e1m6.bsp", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/maps/e1m7.bsp", 0u, nacl_file::FETCH_IDLE, NULL},
+{"id1/maps/e1m8.bsp", 0u, nacl_file::FETCH_IDLE, NULL},
+{NULL, 0u, 0, NULL}
+};
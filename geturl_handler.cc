@@ -9,11 +9,41 @@
 #include <ppapi/cpp/module.h>
 #include <ppapi/cpp/url_response_info.h>
 #include <ppapi/cpp/var.h>
+#include <cstdio>
 #include <cstdlib>
+#include <cstring>
+#include <strings.h>
 
 namespace {
 // HTTP status values.
 const int32_t kHTTPStatusOK = 200;
+const int32_t kHTTPStatusPartialContent = 206;
+
+// Returns the value of header |name| in the CRLF separated |headers|, or an
+// empty string if it isn't there.
+std::string FindHeader(const std::string& headers, const char* name) {
+  size_t name_length = strlen(name);
+  size_t line_start = 0;
+  while (line_start < headers.length()) {
+    size_t line_end = headers.find('\n', line_start);
+    if (line_end == std::string::npos)
+      line_end = headers.length();
+    if (!strncasecmp(headers.c_str() + line_start, name, name_length)) {
+      size_t value_start = line_start + name_length;
+      if (value_start < line_end && headers[value_start] == ':') {
+        ++value_start;
+        while (value_start < line_end && headers[value_start] == ' ')
+          ++value_start;
+        size_t value_end = line_end;
+        if (value_end > value_start && headers[value_end - 1] == '\r')
+          --value_end;
+        return headers.substr(value_start, value_end - value_start);
+      }
+    }
+    line_start = line_end + 1;
+  }
+  return std::string();
+}
 }  // namespace
 
 GetURLHandler* GetURLHandler::Create(pp::Instance* instance,
@@ -39,30 +69,68 @@ GetURLHandler::GetURLHandler(pp::Instance* instance,
 GetURLHandler::~GetURLHandler() {
 }
 
+void GetURLHandler::SetRange(int64_t first, int64_t last) {
+  char range[64];
+  snprintf(range, sizeof(range), "Range: bytes=%lld-%lld",
+           static_cast<long long>(first), static_cast<long long>(last));
+  url_request_.SetHeaders(range);
+}
+
+void GetURLHandler::ReportSize(const pp::URLResponseInfo& url_response) {
+  if (!size_func_)
+    return;
+  std::string headers(url_response.GetHeaders().AsString());
+  bool partial = (url_response.GetStatusCode() == kHTTPStatusPartialContent);
+  long long total_size = -1;
+  if (partial) {
+    // Content-Range: bytes <first>-<last>/<total>
+    std::string content_range(FindHeader(headers, "Content-Range"));
+    size_t slash = content_range.find('/');
+    if (slash != std::string::npos)
+      sscanf(content_range.c_str() + slash + 1, "%lld", &total_size);
+  } else {
+    std::string content_length(FindHeader(headers, "Content-Length"));
+    if (!content_length.empty())
+      sscanf(content_length.c_str(), "%lld", &total_size);
+  }
+  size_func_(static_cast<int64_t>(total_size), partial);
+}
+
+void GetURLHandler::Finish(int32_t result) {
+  url_callback_->Execute(url_response_body_, result);
+  delete this;
+}
+
 bool GetURLHandler::Start(SharedURLCallbackExecutor url_callback) {
   url_callback_ = url_callback;
   pp::CompletionCallback cc = cc_factory_.NewCallback(&GetURLHandler::OnOpen);
   int32_t result = url_loader_.Open(url_request_, cc);
-
-  return result == PP_OK || result == PP_OK_COMPLETIONPENDING;
+  if (result != PP_OK && result != PP_OK_COMPLETIONPENDING) {
+    // OnOpen won't be called, so nothing else will free us.
+    delete this;
+    return false;
+  }
+  return true;
 }
 
 void GetURLHandler::OnOpen(int32_t result) {
   if (result != PP_OK) {
-    url_callback_->Execute(url_response_body_, result);
+    Finish(result);
   } else {
     // Process the response, validating the headers to confirm successful
     // loading.
     pp::URLResponseInfo url_response(url_loader_.GetResponseInfo());
     if (url_response.is_null()) {
-      url_callback_->Execute(url_response_body_, PP_ERROR_FILENOTFOUND);
+      Finish(PP_ERROR_FILENOTFOUND);
       return;
     }
     int32_t status_code = url_response.GetStatusCode();
-    if (status_code != kHTTPStatusOK) {
-      url_callback_->Execute(url_response_body_, PP_ERROR_FILENOTFOUND);
+    if (status_code != kHTTPStatusOK &&
+        status_code != kHTTPStatusPartialContent) {
+      Finish(PP_ERROR_FILENOTFOUND);
       return;
     }
+    ReportSize(url_response);
     ReadBody();
   }
 }
@@ -83,7 +151,7 @@ void GetURLHandler::OnRead(int32_t result) {
   } else {
     // Either the end of the file was reached (|result| == PP_OK) or there
     // was an error.  Execute the callback in either case.
-    url_callback_->Execute(url_response_body_, result);
+    Finish(result);
   }
 }
 
@@ -9,6 +9,7 @@
 #include <ppapi/cpp/instance.h>
 #include <ppapi/cpp/url_loader.h>
 #include <ppapi/cpp/url_request_info.h>
+#include <ppapi/cpp/url_response_info.h>
 #include <tr1/functional>
 #include <tr1/memory>
 #include <string>
@@ -21,8 +22,7 @@
 //
 // EXAMPLE USAGE:
 // GetURLHandler* handler* = GetURLHandler::Create(url);
-// if (!handler->Start())
-//   delete handler;
+// handler->Start(callback);  // Frees the handler itself if it fails.
 //
 //
 class GetURLHandler {
@@ -81,6 +81,18 @@ class GetURLHandler {
     progress_func_ = func;
   }
 
+  // Only ask for bytes |first| through |last| (inclusive) of the resource.
+  // Servers that don't support ranges will send the whole thing instead.
+  // Must be called before Start().
+  void SetRange(int64_t first, int64_t last);
+
+  // Optional function called once the response headers have arrived, with
+  // the total size of the resource (-1 if unknown) and whether the body will
+  // be only the requested range (true) or the whole resource (false).
+  void set_size_func(std::tr1::function<void (int64_t, bool)> func) {
+    size_func_ = func;
+  }
+
  private:
   static const int kBufferSize = 32768;
 
@@ -104,10 +116,19 @@ class GetURLHandler {
   // OnRead() will be called when bytes are received or when an error occurs.
   void ReadBody();
 
+  // Works out the total size of the resource from the response headers and
+  // passes it to size_func_.
+  void ReportSize(const pp::URLResponseInfo& url_response);
+
+  // Runs url_callback_ and self-destroys.
+  void Finish(int32_t result);
+
   std::string url_;  // URL to be downloaded.
   // Optional function to call when bytes are received, passes # bytes just
   // read.
   std::tr1::function<void (int32_t)> progress_func_;
+  // Optional function to call with the total size of the resource.
+  std::tr1::function<void (int64_t, bool)> size_func_;
   pp::URLRequestInfo url_request_;
   pp::URLLoader url_loader_;  // URLLoader provides an API to download URLs.
   char buffer_[kBufferSize];  // buffer for pp::URLLoader::ReadResponseBody().
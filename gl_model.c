@@ -160,6 +160,29 @@ byte *Mod_LeafPVS (mleaf_t *leaf, model_t *model)
 	return Mod_DecompressVis (leaf->compressed_vis, model);
 }
 
+/*
+===================
+Mod_AddLeafPVS
+
+Ors a leaf's row into pvs, which is long aligned and padded with zeros to a
+whole number of longs
+===================
+*/
+void Mod_AddLeafPVS (mleaf_t *leaf, model_t *model, unsigned long *pvs)
+{
+	unsigned long	row[MAX_MAP_LEAFS/8/sizeof(unsigned long)];
+	int				i, bytes, count;
+
+	bytes = (model->numleafs+7)>>3;
+	count = (bytes + sizeof(unsigned long)-1) / sizeof(unsigned long);
+	if (count < 1)
+		return;
+	row[count-1] = 0;
+	memcpy (row, Mod_LeafPVS (leaf, model), bytes);
+	for (i=0 ; i<count ; i++)
+		pvs[i] |= row[i];
+}
+
 /*
 ===================
 Mod_ClearAll
@@ -303,6 +326,29 @@ model_t *Mod_LoadModel (model_t *mod, qboolean crash)
 	return mod;
 }
 
+/*
+==================
+Mod_Prefetch
+
+Starts reading a model that isn't in memory, so the read overlaps with
+whatever is loaded before it
+==================
+*/
+void Mod_Prefetch (char *name)
+{
+	model_t	*mod;
+
+	if (name[0] == '*')
+		return;		// inline model, loaded with the world
+	mod = Mod_FindName (name);
+	if (!mod->needload)
+	{
+		if (mod->type != mod_alias || Cache_Check (&mod->cache))
+			return;
+	}
+	COM_LoadFileAsync (mod->name);
+}
+
 /*
 ==================
 Mod_ForName
@@ -262,6 +262,7 @@ void Host_WriteConfiguration (void)
 		Cvar_WriteVariables (f);
 
 		fclose (f);
+		COM_FlushFileCache ();
 	}
 }
 
@@ -477,10 +478,15 @@ not reinitialize anything.
 void Host_ClearMemory (void)
 {
 	Con_DPrintf ("Clearing memory\n");
+#ifndef GLQUAKE
+	R_SyncView ();		// the render thread may still be drawing the old map
+#endif
+	COM_FlushLoads ();
 	D_FlushCaches ();
 	Mod_ClearAll ();
 	if (host_hunklevel)
 		Hunk_FreeToLowMark (host_hunklevel);
+	ED_ClearMemory ();
 
 	cls.signon = 0;
 	memset (&sv, 0, sizeof(sv));
@@ -705,7 +711,8 @@ void _Host_Frame (float time)
 // update audio
 	if (cls.signon == SIGNONS)
 	{
-		S_Update (r_origin, vpn, vright, vup);
+		S_Update (v_listenorigin, v_listenforward, v_listenright,
+				  v_listenup);
 		CL_DecayLights ();
 	}
 	else
@@ -724,6 +731,8 @@ void _Host_Frame (float time)
 	}
 	
 	host_framecount++;
+	Memory_Frame ();
+	Frame_Reset ();
 }
 
 void Host_Frame (float time)
@@ -875,10 +884,14 @@ void Host_Init (quakeparms_t *parms)
  
 	if (cls.state != ca_dedicated)
 	{
-		host_basepal = (byte *)COM_LoadHunkFile ("gfx/palette.lmp");
+		host_basepal = COM_MapFile ("gfx/palette.lmp");
+		if (!host_basepal)
+			host_basepal = (byte *)COM_LoadHunkFile ("gfx/palette.lmp");
 		if (!host_basepal)
 			Sys_Error ("Couldn't load gfx/palette.lmp");
-		host_colormap = (byte *)COM_LoadHunkFile ("gfx/colormap.lmp");
+		host_colormap = COM_MapFile ("gfx/colormap.lmp");
+		if (!host_colormap)
+			host_colormap = (byte *)COM_LoadHunkFile ("gfx/colormap.lmp");
 		if (!host_colormap)
 			Sys_Error ("Couldn't load gfx/colormap.lmp");
 
@@ -943,6 +956,10 @@ void Host_Shutdown(void)
 // keep Con_Printf from trying to update the screen
 	scr_disabled_for_loading = true;
 
+#ifndef GLQUAKE
+	R_SyncView ();
+#endif
+
 	Host_WriteConfiguration (); 
 
 	CDAudio_Shutdown ();
@@ -163,12 +163,14 @@ void Host_Noclip_f (void)
 	{
 		noclip_anglehack = true;
 		sv_player->v.movetype = MOVETYPE_NOCLIP;
+		SV_HotDirty (sv_player);
 		SV_ClientPrintf ("noclip ON\n");
 	}
 	else
 	{
 		noclip_anglehack = false;
 		sv_player->v.movetype = MOVETYPE_WALK;
+		SV_HotDirty (sv_player);
 		SV_ClientPrintf ("noclip OFF\n");
 	}
 }
@@ -194,11 +196,13 @@ void Host_Fly_f (void)
 	if (sv_player->v.movetype != MOVETYPE_FLY)
 	{
 		sv_player->v.movetype = MOVETYPE_FLY;
+		SV_HotDirty (sv_player);
 		SV_ClientPrintf ("flymode ON\n");
 	}
 	else
 	{
 		sv_player->v.movetype = MOVETYPE_WALK;
+		SV_HotDirty (sv_player);
 		SV_ClientPrintf ("flymode OFF\n");
 	}
 }
@@ -677,6 +681,7 @@ void Host_Loadgame_f (void)
 		else
 		{	// parse an edict
 
+			ED_Grow (entnum+1);
 			ent = EDICT_NUM(entnum);
 			memset (&ent->v, 0, progs->entityfields * 4);
 			ent->free = false;
@@ -692,6 +697,7 @@ void Host_Loadgame_f (void)
 	
 	sv.num_edicts = entnum;
 	sv.time = time;
+	ED_ResetFreeList ();
 
 	fclose (f);
 
@@ -840,6 +846,7 @@ int LoadGamestate(char *level, char *startspot)
 			
 		// parse an edict
 
+		ED_Grow (entnum+1);
 		ent = EDICT_NUM(entnum);
 		memset (&ent->v, 0, progs->entityfields * 4);
 		ent->free = false;
@@ -852,6 +859,7 @@ int LoadGamestate(char *level, char *startspot)
 	
 //	sv.num_edicts = entnum;
 	sv.time = time;
+	ED_ResetFreeList ();
 	fclose (f);
 
 //	for (i=0 ; i<NUM_SPAWN_PARMS ; i++)
@@ -973,6 +981,7 @@ void Host_Please_f (void)
 			cl->privileged = false;
 			cl->edict->v.flags = (int)cl->edict->v.flags & ~(FL_GODMODE|FL_NOTARGET);
 			cl->edict->v.movetype = MOVETYPE_WALK;
+			SV_HotDirty (cl->edict);
 			noclip_anglehack = false;
 		}
 		else
@@ -993,6 +1002,7 @@ void Host_Please_f (void)
 				cl->privileged = false;
 				cl->edict->v.flags = (int)cl->edict->v.flags & ~(FL_GODMODE|FL_NOTARGET);
 				cl->edict->v.movetype = MOVETYPE_WALK;
+				SV_HotDirty (cl->edict);
 				noclip_anglehack = false;
 			}
 			else
@@ -1305,6 +1315,7 @@ void Host_Spawn_f (void)
 		ent = host_client->edict;
 
 		memset (&ent->v, 0, progs->entityfields * 4);
+		SV_HotDirty (ent);
 		ent->v.colormap = NUM_FOR_EDICT(ent);
 		ent->v.team = (host_client->colors & 15) + 1;
 		ent->v.netname = host_client->name - pr_strings;
@@ -0,0 +1,113 @@
+#!/usr/bin/python
+#
+# Copyright 2010, The Native Client SDK Authors.  All Rights Reserved.
+# Use of this source code is governed by a BSD-style license that can
+# be found in the LICENSE file.
+#
+
+"""Turns file access traces into the prefetch manifest, file_manifest.h.
+
+Record a trace by running quake with -filetrace (see COM_InitFilesystem). Each
+line of the trace is
+  time<TAB>map<TAB>path<TAB>name<TAB>bytes
+and may be prefixed by "FileTrace: " if it was captured from the console.
+
+Files opened before any map was loaded are startup files, and are fetched in
+the order they were first opened. Every other file is listed under each map
+that opened it, so that opening the map's .bsp fetches them all.
+
+Usage: make_manifest.py trace.txt [trace2.txt ...] > file_manifest.h
+"""
+
+import sys
+
+TRACE_PREFIX = 'FileTrace: '
+
+
+def ResolvePath(path, name):
+  """Returns the name the FileManager knows the file by.
+
+  |path| is the file that was opened: either the file itself or, for files
+  inside a pak, the pak, which is fetched as a whole.
+  """
+  while path.startswith('./'):
+    path = path[2:]
+  return path
+
+
+def ReadTrace(file_name, entries):
+  for line in open(file_name):
+    line = line.rstrip('\r\n')
+    if line.startswith(TRACE_PREFIX):
+      line = line[len(TRACE_PREFIX):]
+    fields = line.split('\t')
+    if len(fields) != 5:
+      continue
+    time, map_name, path, name, size = fields
+    entries.append((float(time), map_name, path, name, int(size)))
+
+
+def BuildManifest(entries):
+  """Returns (startup, maps), where maps is a list of (map, files) pairs."""
+  entries.sort(key=lambda entry: entry[0])
+  # Map names in the trace are as the engine wrote them ("maps/e1m1.bsp"); key
+  # the groups by the file that will actually be opened.
+  map_files = {}
+  for time, map_name, path, name, size in entries:
+    if name == map_name and name not in map_files:
+      map_files[name] = ResolvePath(path, name)
+
+  startup = []
+  sizes = {}
+  seen = set()
+  map_order = []
+  map_groups = {}
+  for time, map_name, path, name, size in entries:
+    full_name = ResolvePath(path, name)
+    sizes[full_name] = max(sizes.get(full_name, 0), size)
+    if not map_name:
+      if full_name not in seen:
+        seen.add(full_name)
+        startup.append(full_name)
+      continue
+    group_name = map_files.get(map_name, map_name)
+    if group_name not in map_groups:
+      map_order.append(group_name)
+      map_groups[group_name] = []
+    group = map_groups[group_name]
+    if full_name not in startup and full_name not in group:
+      group.append(full_name)
+
+  maps = [(map_name, map_groups[map_name]) for map_name in map_order]
+  return startup, maps, sizes
+
+
+def WriteManifest(out, startup, maps, sizes):
+  out.write('// Generated by make_manifest.py from a -filetrace run; do not '
+            'edit.\n')
+  out.write('const nacl_file::ManifestEntry file_manifest[] = {\n')
+  for name in startup:
+    out.write('{"%s", %du, nacl_file::FETCH_STARTUP, NULL},\n' %
+              (name, sizes[name]))
+  for map_name, files in maps:
+    for name in files:
+      out.write('{"%s", %du, nacl_file::FETCH_MAP, "%s"},\n' %
+                (name, sizes[name], map_name))
+  out.write('{NULL, 0u, 0, NULL}\n')
+  out.write('};\n')
+
+
+def main(argv):
+  if len(argv) < 2:
+    sys.stderr.write(__doc__)
+    return 1
+  entries = []
+  for file_name in argv[1:]:
+    ReadTrace(file_name, entries)
+  startup, maps, sizes = BuildManifest(entries)
+  WriteManifest(sys.stdout, startup, maps, sizes)
+  return 0
+
+
+if __name__ == '__main__':
+  sys.exit(main(sys.argv))
@@ -25,13 +25,24 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #include "quakedef.h"
 #include "r_local.h"
 
+#ifdef USE_PTHREADS
+#include <pthread.h>
+#endif
+
 model_t	*loadmodel;
 char	loadname[32];	// for hunk tags
+qboolean	mod_mapped;		// the file being loaded is in a mapped pak file
 
 void Mod_LoadSpriteModel (model_t *mod, void *buffer);
 void Mod_LoadBrushModel (model_t *mod, void *buffer);
 void Mod_LoadAliasModel (model_t *mod, void *buffer);
 model_t *Mod_LoadModel (model_t *mod, qboolean crash);
+void Mod_BspTest_f (void);
+void Mod_PVSCache_f (void);
+
+extern cvar_t	mod_parallel;
+extern cvar_t	mod_bspcache;
+extern cvar_t	mod_pvscache;
 
 byte	mod_novis[MAX_MAP_LEAFS/8];
 
@@ -52,6 +63,11 @@ Mod_Init
 void Mod_Init (void)
 {
 	memset (mod_novis, 0xff, sizeof(mod_novis));
+	Cvar_RegisterVariable (&mod_parallel);
+	Cvar_RegisterVariable (&mod_bspcache);
+	Cvar_RegisterVariable (&mod_pvscache);
+	Cmd_AddCommand ("bsptest", Mod_BspTest_f);
+	Cmd_AddCommand ("pvscache", Mod_PVSCache_f);
 }
 
 /*
@@ -107,56 +123,376 @@ mleaf_t *Mod_PointInLeaf (vec3_t p, model_t *model)
 }
 
 
+/*
+===============================================================================
+
+					PVS CACHE
+
+Every Mod_LeafPVS used to run the leaf's row through the RLE decoder, and
+the server asks for the same few rows for every client every frame.  The
+decompressed rows of the last model asked about are kept in a malloced
+cache of mod_pvscache kilobytes.  If every row fits, the cache is the whole
+matrix, filled as rows are first asked for; otherwise it holds the most
+recently used rows.
+
+Rows are padded to a whole number of longs, so SV_FatPVS can or them into
+its fat PVS a word at a time with Mod_AddLeafPVS.  Mod_LeafPVS copies a
+cached row into a per thread buffer rather than handing out the cache, as
+the server and the render thread both ask for rows.
+
+===============================================================================
+*/
+
+typedef struct
+{
+	model_t			*model;			// the rows are from, or NULL
+	byte			*visdata;		// of the model, in case the slot is reused
+	int				budget;			// mod_pvscache when the cache was sized
+	int				rowbytes;		// of a padded row
+	int				numslots;		// 0 if no cache
+	int				used;			// slots filled so far
+	qboolean		matrix;			// a slot for every leaf, slot leafnum-1
+	int				*leafslot;		// numleafs+1, -1 if the row isn't cached
+	int				*slotleaf;		// numslots
+	int				*older, *newer;	// numslots+1 ring, numslots is the head
+	unsigned long	*rows;			// numslots rows
+
+	int				hits, misses, evictions;
+	int				uncached;		// with no cache, or leafs past numleafs
+} pvscache_t;
+
+cvar_t	mod_pvscache = {"mod_pvscache", "4096"};	// kilobytes, 0 for none
+
+static pvscache_t	mod_pvs;
+
+// largest mod_pvscache honoured, so the sizes below stay in an int
+#define	PVS_MAXBUDGET	0x100000
+
+// decompressed rows handed out by Mod_LeafPVS and Mod_DecompressVis
+static D_THREADLOCAL unsigned long	mod_pvsrow[MAX_MAP_LEAFS/8/sizeof(unsigned long)];
+
+#ifdef USE_PTHREADS
+static pthread_mutex_t pvs_lock = PTHREAD_MUTEX_INITIALIZER;
+#define PVS_LOCK() pthread_mutex_lock(&pvs_lock)
+#define PVS_UNLOCK() pthread_mutex_unlock(&pvs_lock)
+#else
+#define PVS_LOCK()
+#define PVS_UNLOCK()
+#endif
+
+#define	PVS_ROWBYTES(model)	(((((model)->numleafs+7)>>3) + sizeof(unsigned long)-1) \
+	& ~(sizeof(unsigned long)-1))
+
 /*
 ===================
-Mod_DecompressVis
+Mod_DecompressRow
+
+Decompresses a row into out, zero padded to PVS_ROWBYTES
 ===================
 */
-byte *Mod_DecompressVis (byte *in, model_t *model)
+static void Mod_DecompressRow (byte *in, model_t *model, byte *out)
 {
-	static byte	decompressed[MAX_MAP_LEAFS/8];
 	int		c;
-	byte	*out;
 	int		row;
+	byte	*end;
 
-	row = (model->numleafs+7)>>3;	
-	out = decompressed;
+	row = (model->numleafs+7)>>3;
+	end = out + row;
 
 	if (!in)
 	{	// no vis info, so make all visible
-		while (row)
+		memset (out, 0xff, row);
+	}
+	else
+	{
+		while (out < end)
 		{
-			*out++ = 0xff;
-			row--;
+			if (*in)
+			{
+				*out++ = *in++;
+				continue;
+			}
+
+			c = in[1];
+			in += 2;
+			while (c && out < end)
+			{
+				*out++ = 0;
+				c--;
+			}
 		}
-		return decompressed;		
 	}
 
-	do
+	memset (end, 0, PVS_ROWBYTES(model) - row);
+}
+
+/*
+===================
+Mod_DecompressVis
+===================
+*/
+byte *Mod_DecompressVis (byte *in, model_t *model)
+{
+	Mod_DecompressRow (in, model, (byte *)mod_pvsrow);
+	return (byte *)mod_pvsrow;
+}
+
+/*
+===================
+Mod_PVSReset
+
+Sizes the cache for model, or just frees it if model is NULL
+===================
+*/
+static void Mod_PVSReset (model_t *model)
+{
+	pvscache_t	*c;
+	int			numslots, budget;
+
+	c = &mod_pvs;
+	free (c->rows);
+	free (c->leafslot);
+	c->rows = NULL;
+	c->leafslot = NULL;
+	c->numslots = 0;
+	c->used = 0;
+
+	c->model = model;
+	c->budget = (int)mod_pvscache.value;
+	if (!model)
+		return;
+	c->visdata = model->visdata;
+	c->rowbytes = PVS_ROWBYTES(model);
+
+	if (c->budget <= 0 || model->numleafs < 1)
+		return;
+// c->budget keeps the cvar value, so Mod_PVSRow doesn't keep resizing
+	budget = c->budget;
+	if (budget > PVS_MAXBUDGET)
+		budget = PVS_MAXBUDGET;
+	numslots = budget * 1024 / c->rowbytes;
+	if (numslots < 1)
+		return;
+	c->matrix = numslots >= model->numleafs;
+	if (c->matrix)
+		numslots = model->numleafs;
+
+	c->rows = malloc (numslots * c->rowbytes);
+	c->leafslot = malloc ((model->numleafs + 1 + 3*numslots + 2) * sizeof(int));
+	if (!c->rows || !c->leafslot)
 	{
-		if (*in)
-		{
-			*out++ = *in++;
-			continue;
+		Con_DPrintf ("couldn't allocate %ik for the PVS cache\n",
+			numslots * c->rowbytes / 1024);
+		free (c->rows);
+		free (c->leafslot);
+		c->rows = NULL;
+		c->leafslot = NULL;
+		return;
+	}
+	c->slotleaf = c->leafslot + model->numleafs + 1;
+	c->older = c->slotleaf + numslots;
+	c->newer = c->older + numslots + 1;
+	c->numslots = numslots;
+
+	memset (c->leafslot, 0xff, (model->numleafs + 1) * sizeof(int));
+	c->older[numslots] = c->newer[numslots] = numslots;
+}
+
+/*
+===================
+Mod_PVSRow
+
+Returns the cached row for a leaf, decompressing it into a slot if it isn't
+there yet, or NULL if it can't be cached.  Called with the cache locked.
+===================
+*/
+static unsigned long *Mod_PVSRow (mleaf_t *leaf, model_t *model)
+{
+	pvscache_t		*c;
+	int				leafnum, slot, head;
+	unsigned long	*row;
+
+	c = &mod_pvs;
+	if (c->model != model || c->visdata != model->visdata
+	|| c->budget != (int)mod_pvscache.value)
+		Mod_PVSReset (model);
+
+	leafnum = leaf - model->leafs;
+	if (!c->numslots || leafnum < 1 || leafnum > model->numleafs)
+	{
+		c->uncached++;
+		return NULL;
+	}
+
+	head = c->numslots;
+	slot = c->leafslot[leafnum];
+	if (slot >= 0)
+	{
+		c->hits++;
+		if (!c->matrix)
+		{	// unlink, to be linked back as the newest
+			c->newer[c->older[slot]] = c->newer[slot];
+			c->older[c->newer[slot]] = c->older[slot];
 		}
-	
-		c = in[1];
-		in += 2;
-		while (c)
+	}
+	else
+	{
+		c->misses++;
+		if (c->matrix)
 		{
-			*out++ = 0;
-			c--;
+			slot = leafnum - 1;
+			c->used++;
 		}
-	} while (out - decompressed < row);
-	
-	return decompressed;
+		else if (c->used < c->numslots)
+			slot = c->used++;
+		else
+		{	// throw out the least recently used row
+			slot = c->newer[head];
+			c->newer[head] = c->newer[slot];
+			c->older[c->newer[slot]] = head;
+			c->leafslot[c->slotleaf[slot]] = -1;
+			c->evictions++;
+		}
+		c->leafslot[leafnum] = slot;
+		c->slotleaf[slot] = leafnum;
+		Mod_DecompressRow (leaf->compressed_vis, model,
+			(byte *)(c->rows + slot * c->rowbytes / sizeof(unsigned long)));
+	}
+
+	if (!c->matrix)
+	{
+		c->older[slot] = c->older[head];
+		c->newer[slot] = head;
+		c->newer[c->older[head]] = slot;
+		c->older[head] = slot;
+	}
+
+	row = c->rows + slot * c->rowbytes / sizeof(unsigned long);
+	return row;
 }
 
+/*
+===================
+Mod_LeafPVS
+
+The returned row is good until the next call on the same thread
+===================
+*/
 byte *Mod_LeafPVS (mleaf_t *leaf, model_t *model)
 {
+	unsigned long	*row;
+
 	if (leaf == model->leafs)
 		return mod_novis;
-	return Mod_DecompressVis (leaf->compressed_vis, model);
+
+	PVS_LOCK();
+	row = Mod_PVSRow (leaf, model);
+	if (row)
+		memcpy (mod_pvsrow, row, mod_pvs.rowbytes);
+	PVS_UNLOCK();
+
+	if (!row)
+		return Mod_DecompressVis (leaf->compressed_vis, model);
+	return (byte *)mod_pvsrow;
+}
+
+/*
+===================
+Mod_AddLeafPVS
+
+Ors a leaf's row into pvs a word at a time.  pvs must be long aligned and
+at least PVS_ROWBYTES long.
+===================
+*/
+void Mod_AddLeafPVS (mleaf_t *leaf, model_t *model, unsigned long *pvs)
+{
+	unsigned long	*row;
+	unsigned long	decompressed[MAX_MAP_LEAFS/8/sizeof(unsigned long)];
+	int				i, count;
+
+	count = PVS_ROWBYTES(model) / sizeof(unsigned long);
+
+	if (leaf == model->leafs)
+	{
+		for (i=0 ; i<count ; i++)
+			pvs[i] = ~0UL;
+		return;
+	}
+
+	PVS_LOCK();
+	row = Mod_PVSRow (leaf, model);
+	if (row)
+	{
+		for (i=0 ; i<count ; i++)
+			pvs[i] |= row[i];
+	}
+	PVS_UNLOCK();
+
+	if (!row)
+	{	// not into mod_pvsrow, the caller may still be using a Mod_LeafPVS row
+		Mod_DecompressRow (leaf->compressed_vis, model, (byte *)decompressed);
+		for (i=0 ; i<count ; i++)
+			pvs[i] |= decompressed[i];
+	}
+}
+
+/*
+===================
+Mod_PVSFlush
+
+Drops the cached rows when the models are cleared for a new map
+===================
+*/
+static void Mod_PVSFlush (void)
+{
+	PVS_LOCK();
+	Mod_PVSReset (NULL);
+	PVS_UNLOCK();
+}
+
+/*
+===================
+Mod_PVSCache_f
+
+pvscache [clear]
+===================
+*/
+void Mod_PVSCache_f (void)
+{
+	pvscache_t	*c, s;
+	char		name[MAX_QPATH];
+	int			lookups;
+
+	c = &mod_pvs;
+	PVS_LOCK();
+	if (Cmd_Argc () == 2 && !Q_strcmp (Cmd_Argv(1), "clear"))
+	{
+		c->hits = c->misses = c->evictions = c->uncached = 0;
+		PVS_UNLOCK();
+		return;
+	}
+
+// copy the numbers out, Con_Printf can wait on the render thread, which
+// may be waiting on pvs_lock
+	s = *c;
+	name[0] = 0;
+	if (c->model)
+		Q_strcpy (name, c->model->name);
+	PVS_UNLOCK();
+
+	if (s.numslots)
+		Con_Printf ("%ik PVS cache for %s, %s: %i of %i rows filled\n",
+			s.numslots * s.rowbytes / 1024, name,
+			s.matrix ? "full matrix" : "LRU", s.used, s.numslots);
+	else
+		Con_Printf ("no PVS cache\n");
+
+	lookups = s.hits + s.misses;
+	if (lookups)
+		Con_Printf ("%i lookups, %.1f%% hits, %i evictions\n", lookups,
+			100.0 * s.hits / lookups, s.evictions);
+	if (s.uncached)
+		Con_Printf ("%i rows decompressed uncached\n", s.uncached);
 }
 
 /*
@@ -169,6 +505,7 @@ void Mod_ClearAll (void)
 	int		i;
 	model_t	*mod;
 
+	Mod_PVSFlush ();
 
 	for (i=0 , mod=mod_known ; i<mod_numknown ; i++, mod++) {
 		mod->needload = NL_UNREFERENCED;
@@ -279,7 +616,10 @@ model_t *Mod_LoadModel (model_t *mod, qboolean crash)
 //
 // load the file
 //
-	buf = (unsigned *)COM_LoadStackFile (mod->name, stackbuf, sizeof(stackbuf));
+	buf = (unsigned *)COM_MapFile (mod->name);
+	mod_mapped = (buf != NULL);
+	if (!buf)
+		buf = (unsigned *)COM_LoadStackFile (mod->name, stackbuf, sizeof(stackbuf));
 	if (!buf)
 	{
 		if (crash)
@@ -320,6 +660,31 @@ model_t *Mod_LoadModel (model_t *mod, qboolean crash)
 	return mod;
 }
 
+/*
+==================
+Mod_Prefetch
+
+Starts reading a model that isn't in memory, so the read overlaps with
+whatever is loaded before it
+==================
+*/
+void Mod_Prefetch (char *name)
+{
+	model_t	*mod;
+
+	if (name[0] == '*')
+		return;		// inline model, loaded with the world
+	mod = Mod_FindName (name);
+	if (mod->type == mod_alias)
+	{
+		if (Cache_Check (&mod->cache))
+			return;
+	}
+	else if (mod->needload == NL_PRESENT)
+		return;
+	COM_LoadFileAsync (mod->name);
+}
+
 /*
 ==================
 Mod_ForName
@@ -347,6 +712,15 @@ model_t *Mod_ForName (char *name, qboolean crash)
 
 byte	*mod_base;
 
+// lump conversion is split into jobs of this many items (bytes for the
+// lighting and visibility copies); faces are heavier, so their jobs are smaller
+#define	MOD_LUMPCHUNK	4096
+#define	MOD_FACECHUNK	1024
+#define	MOD_BYTECHUNK	(256*1024)
+
+cvar_t	mod_parallel = {"mod_parallel", "1"};
+qboolean	mod_parallel_load;	// Mod_LoadBrushModel is queueing lump jobs
+
 
 /*
 =================
@@ -356,6 +730,7 @@ Mod_LoadTextures
 void Mod_LoadTextures (lump_t *l)
 {
 	int		i, j, pixels, num, max, altmax;
+	int		nummiptex, dataofs, width, height;
 	miptex_t	*mt;
 	texture_t	*tx, *tx2;
 	texture_t	*anims[10];
@@ -368,34 +743,33 @@ void Mod_LoadTextures (lump_t *l)
 		return;
 	}
 	m = (dmiptexlump_t *)(mod_base + l->fileofs);
+
+// the lump is swapped as it is read, so the file data is never written to
+	nummiptex = LittleLong (m->nummiptex);
 	
-	m->nummiptex = LittleLong (m->nummiptex);
-	
-	loadmodel->numtextures = m->nummiptex;
-	loadmodel->textures = Hunk_AllocName (m->nummiptex * sizeof(*loadmodel->textures) , loadname);
+	loadmodel->numtextures = nummiptex;
+	loadmodel->textures = Hunk_AllocName (nummiptex * sizeof(*loadmodel->textures) , loadname);
 
-	for (i=0 ; i<m->nummiptex ; i++)
+	for (i=0 ; i<nummiptex ; i++)
 	{
-		m->dataofs[i] = LittleLong(m->dataofs[i]);
-		if (m->dataofs[i] == -1)
+		dataofs = LittleLong(m->dataofs[i]);
+		if (dataofs == -1)
 			continue;
-		mt = (miptex_t *)((byte *)m + m->dataofs[i]);
-		mt->width = LittleLong (mt->width);
-		mt->height = LittleLong (mt->height);
-		for (j=0 ; j<MIPLEVELS ; j++)
-			mt->offsets[j] = LittleLong (mt->offsets[j]);
+		mt = (miptex_t *)((byte *)m + dataofs);
+		width = LittleLong (mt->width);
+		height = LittleLong (mt->height);
 		
-		if ( (mt->width & 15) || (mt->height & 15) )
+		if ( (width & 15) || (height & 15) )
 			Sys_Error ("Texture %s is not 16 aligned", mt->name);
-		pixels = mt->width*mt->height/64*85;
+		pixels = width*height/64*85;
 		tx = Hunk_AllocName (sizeof(texture_t) +pixels, loadname );
 		loadmodel->textures[i] = tx;
 
 		memcpy (tx->name, mt->name, sizeof(tx->name));
-		tx->width = mt->width;
-		tx->height = mt->height;
+		tx->width = width;
+		tx->height = height;
 		for (j=0 ; j<MIPLEVELS ; j++)
-			tx->offsets[j] = mt->offsets[j] + sizeof(texture_t) - sizeof(miptex_t);
+			tx->offsets[j] = LittleLong (mt->offsets[j]) + sizeof(texture_t) - sizeof(miptex_t);
 		// the pixels immediately follow the structures
 		memcpy ( tx+1, mt+1, pixels);
 		
@@ -406,7 +780,7 @@ void Mod_LoadTextures (lump_t *l)
 //
 // sequence the animations
 //
-	for (i=0 ; i<m->nummiptex ; i++)
+	for (i=0 ; i<nummiptex ; i++)
 	{
 		tx = loadmodel->textures[i];
 		if (!tx || tx->name[0] != '+')
@@ -439,7 +813,7 @@ void Mod_LoadTextures (lump_t *l)
 		else
 			Sys_Error ("Bad animating texture %s", tx->name);
 
-		for (j=i+1 ; j<m->nummiptex ; j++)
+		for (j=i+1 ; j<nummiptex ; j++)
 		{
 			tx2 = loadmodel->textures[j];
 			if (!tx2 || tx2->name[0] != '+')
@@ -497,11 +871,34 @@ void Mod_LoadTextures (lump_t *l)
 	}
 }
 
+/*
+=================
+Mod_LumpJob
+
+Runs func over the count items of a lump: queued for the worker threads
+while Mod_LoadBrushModel is loading in parallel, otherwise right away.
+The hunk is always allocated on the main thread, in the same order, so the
+model comes out the same either way.
+=================
+*/
+void Mod_LumpJob (jobfunc_t func, void *in, int count, int chunk)
+{
+	if (mod_parallel_load)
+		Job_Add (func, in, count, chunk);
+	else
+		func (in, 0, count);
+}
+
 /*
 =================
 Mod_LoadLighting
 =================
 */
+void Mod_CopyLighting (void *data, int first, int count)
+{
+	memcpy (loadmodel->lightdata + first, (byte *)data + first, count);
+}
+
 void Mod_LoadLighting (lump_t *l)
 {
 	if (!l->filelen)
@@ -509,8 +906,13 @@ void Mod_LoadLighting (lump_t *l)
 		loadmodel->lightdata = NULL;
 		return;
 	}
+	if (mod_mapped)
+	{	// use the lightmaps straight out of the pak file
+		loadmodel->lightdata = mod_base + l->fileofs;
+		return;
+	}
 	loadmodel->lightdata = Hunk_AllocName ( l->filelen, loadname);	
-	memcpy (loadmodel->lightdata, mod_base + l->fileofs, l->filelen);
+	Mod_LumpJob (Mod_CopyLighting, mod_base + l->fileofs, l->filelen, MOD_BYTECHUNK);
 }
 
 
@@ -519,6 +921,11 @@ void Mod_LoadLighting (lump_t *l)
 Mod_LoadVisibility
 =================
 */
+void Mod_CopyVisibility (void *data, int first, int count)
+{
+	memcpy (loadmodel->visdata + first, (byte *)data + first, count);
+}
+
 void Mod_LoadVisibility (lump_t *l)
 {
 	if (!l->filelen)
@@ -526,8 +933,13 @@ void Mod_LoadVisibility (lump_t *l)
 		loadmodel->visdata = NULL;
 		return;
 	}
+	if (mod_mapped)
+	{	// use the compressed vis straight out of the pak file
+		loadmodel->visdata = mod_base + l->fileofs;
+		return;
+	}
 	loadmodel->visdata = Hunk_AllocName ( l->filelen, loadname);	
-	memcpy (loadmodel->visdata, mod_base + l->fileofs, l->filelen);
+	Mod_LumpJob (Mod_CopyVisibility, mod_base + l->fileofs, l->filelen, MOD_BYTECHUNK);
 }
 
 
@@ -553,11 +965,28 @@ void Mod_LoadEntities (lump_t *l)
 Mod_LoadVertexes
 =================
 */
+void Mod_ConvertVertexes (void *data, int first, int count)
+{
+	dvertex_t	*in;
+	mvertex_t	*out;
+	int			i;
+
+	in = (dvertex_t *)data + first;
+	out = loadmodel->vertexes + first;
+
+	for ( i=0 ; i<count ; i++, in++, out++)
+	{
+		out->position[0] = LittleFloat (in->point[0]);
+		out->position[1] = LittleFloat (in->point[1]);
+		out->position[2] = LittleFloat (in->point[2]);
+	}
+}
+
 void Mod_LoadVertexes (lump_t *l)
 {
 	dvertex_t	*in;
 	mvertex_t	*out;
-	int			i, count;
+	int			count;
 
 	in = (void *)(mod_base + l->fileofs);
 	if (l->filelen % sizeof(*in))
@@ -568,12 +997,7 @@ void Mod_LoadVertexes (lump_t *l)
 	loadmodel->vertexes = out;
 	loadmodel->numvertexes = count;
 
-	for ( i=0 ; i<count ; i++, in++, out++)
-	{
-		out->position[0] = LittleFloat (in->point[0]);
-		out->position[1] = LittleFloat (in->point[1]);
-		out->position[2] = LittleFloat (in->point[2]);
-	}
+	Mod_LumpJob (Mod_ConvertVertexes, in, count, MOD_LUMPCHUNK);
 }
 
 /*
@@ -581,20 +1005,14 @@ void Mod_LoadVertexes (lump_t *l)
 Mod_LoadSubmodels
 =================
 */
-void Mod_LoadSubmodels (lump_t *l)
+void Mod_ConvertSubmodels (void *data, int first, int count)
 {
 	dmodel_t	*in;
 	dmodel_t	*out;
-	int			i, j, count;
-
-	in = (void *)(mod_base + l->fileofs);
-	if (l->filelen % sizeof(*in))
-		Sys_Error ("MOD_LoadBmodel: funny lump size in %s",loadmodel->name);
-	count = l->filelen / sizeof(*in);
-	out = Hunk_AllocName ( count*sizeof(*out), loadname);	
+	int			i, j;
 
-	loadmodel->submodels = out;
-	loadmodel->numsubmodels = count;
+	in = (dmodel_t *)data + first;
+	out = loadmodel->submodels + first;
 
 	for ( i=0 ; i<count ; i++, in++, out++)
 	{
@@ -612,16 +1030,50 @@ void Mod_LoadSubmodels (lump_t *l)
 	}
 }
 
+void Mod_LoadSubmodels (lump_t *l)
+{
+	dmodel_t	*in;
+	dmodel_t	*out;
+	int			count;
+
+	in = (void *)(mod_base + l->fileofs);
+	if (l->filelen % sizeof(*in))
+		Sys_Error ("MOD_LoadBmodel: funny lump size in %s",loadmodel->name);
+	count = l->filelen / sizeof(*in);
+	out = Hunk_AllocName ( count*sizeof(*out), loadname);	
+
+	loadmodel->submodels = out;
+	loadmodel->numsubmodels = count;
+
+	Mod_LumpJob (Mod_ConvertSubmodels, in, count, MOD_LUMPCHUNK);
+}
+
 /*
 =================
 Mod_LoadEdges
 =================
 */
+void Mod_ConvertEdges (void *data, int first, int count)
+{
+	dedge_t *in;
+	medge_t *out;
+	int 	i;
+
+	in = (dedge_t *)data + first;
+	out = loadmodel->edges + first;
+
+	for ( i=0 ; i<count ; i++, in++, out++)
+	{
+		out->v[0] = (unsigned short)LittleShort(in->v[0]);
+		out->v[1] = (unsigned short)LittleShort(in->v[1]);
+	}
+}
+
 void Mod_LoadEdges (lump_t *l)
 {
 	dedge_t *in;
 	medge_t *out;
-	int 	i, count;
+	int 	count;
 
 	in = (void *)(mod_base + l->fileofs);
 	if (l->filelen % sizeof(*in))
@@ -632,11 +1084,7 @@ void Mod_LoadEdges (lump_t *l)
 	loadmodel->edges = out;
 	loadmodel->numedges = count;
 
-	for ( i=0 ; i<count ; i++, in++, out++)
-	{
-		out->v[0] = (unsigned short)LittleShort(in->v[0]);
-		out->v[1] = (unsigned short)LittleShort(in->v[1]);
-	}
+	Mod_LumpJob (Mod_ConvertEdges, in, count, MOD_LUMPCHUNK);
 }
 
 /*
@@ -644,22 +1092,16 @@ void Mod_LoadEdges (lump_t *l)
 Mod_LoadTexinfo
 =================
 */
-void Mod_LoadTexinfo (lump_t *l)
+void Mod_ConvertTexinfo (void *data, int first, int count)
 {
 	texinfo_t *in;
 	mtexinfo_t *out;
-	int 	i, j, count;
+	int 	i, j;
 	int		miptex;
 	float	len1, len2;
 
-	in = (void *)(mod_base + l->fileofs);
-	if (l->filelen % sizeof(*in))
-		Sys_Error ("MOD_LoadBmodel: funny lump size in %s",loadmodel->name);
-	count = l->filelen / sizeof(*in);
-	out = Hunk_AllocName ( count*sizeof(*out), loadname);	
-
-	loadmodel->texinfo = out;
-	loadmodel->numtexinfo = count;
+	in = (texinfo_t *)data + first;
+	out = loadmodel->texinfo + first;
 
 	for ( i=0 ; i<count ; i++, in++, out++)
 	{
@@ -705,16 +1147,34 @@ void Mod_LoadTexinfo (lump_t *l)
 	}
 }
 
-/*
-================
-CalcSurfaceExtents
-
-Fills in s->texturemins[] and s->extents[]
-================
-*/
-void CalcSurfaceExtents (msurface_t *s)
+void Mod_LoadTexinfo (lump_t *l)
 {
-	float	mins[2], maxs[2], val;
+	texinfo_t *in;
+	mtexinfo_t *out;
+	int 	count;
+
+	in = (void *)(mod_base + l->fileofs);
+	if (l->filelen % sizeof(*in))
+		Sys_Error ("MOD_LoadBmodel: funny lump size in %s",loadmodel->name);
+	count = l->filelen / sizeof(*in);
+	out = Hunk_AllocName ( count*sizeof(*out), loadname);	
+
+	loadmodel->texinfo = out;
+	loadmodel->numtexinfo = count;
+
+	Mod_LumpJob (Mod_ConvertTexinfo, in, count, MOD_LUMPCHUNK);
+}
+
+/*
+================
+CalcSurfaceExtents
+
+Fills in s->texturemins[] and s->extents[]
+================
+*/
+void CalcSurfaceExtents (msurface_t *s)
+{
+	float	mins[2], maxs[2], val;
 	int		i,j, e;
 	mvertex_t	*v;
 	mtexinfo_t	*tex;
@@ -764,21 +1224,15 @@ void CalcSurfaceExtents (msurface_t *s)
 Mod_LoadFaces
 =================
 */
-void Mod_LoadFaces (lump_t *l)
+void Mod_ConvertFaces (void *data, int first, int count)
 {
 	dface_t		*in;
 	msurface_t 	*out;
-	int			i, count, surfnum;
+	int			i, surfnum;
 	int			planenum, side;
 
-	in = (void *)(mod_base + l->fileofs);
-	if (l->filelen % sizeof(*in))
-		Sys_Error ("MOD_LoadBmodel: funny lump size in %s",loadmodel->name);
-	count = l->filelen / sizeof(*in);
-	out = Hunk_AllocName ( count*sizeof(*out), loadname);	
-
-	loadmodel->surfaces = out;
-	loadmodel->numsurfaces = count;
+	in = (dface_t *)data + first;
+	out = loadmodel->surfaces + first;
 
 	for ( surfnum=0 ; surfnum<count ; surfnum++, in++, out++)
 	{
@@ -828,6 +1282,27 @@ void Mod_LoadFaces (lump_t *l)
 	}
 }
 
+void Mod_LoadFaces (lump_t *l)
+{
+	dface_t		*in;
+	msurface_t 	*out;
+	int			count;
+
+	in = (void *)(mod_base + l->fileofs);
+	if (l->filelen % sizeof(*in))
+		Sys_Error ("MOD_LoadBmodel: funny lump size in %s",loadmodel->name);
+	count = l->filelen / sizeof(*in);
+	out = Hunk_AllocName ( count*sizeof(*out), loadname);	
+
+	loadmodel->surfaces = out;
+	loadmodel->numsurfaces = count;
+
+// the extents need the vertexes, edges, surfedges and texinfo
+	if (mod_parallel_load)
+		Job_Wait ();
+	Mod_LumpJob (Mod_ConvertFaces, in, count, MOD_FACECHUNK);
+}
+
 
 /*
 =================
@@ -848,20 +1323,14 @@ void Mod_SetParent (mnode_t *node, mnode_t *parent)
 Mod_LoadNodes
 =================
 */
-void Mod_LoadNodes (lump_t *l)
+void Mod_ConvertNodes (void *data, int first, int count)
 {
-	int			i, j, count, p;
+	int			i, j, p;
 	dnode_t		*in;
 	mnode_t 	*out;
 
-	in = (void *)(mod_base + l->fileofs);
-	if (l->filelen % sizeof(*in))
-		Sys_Error ("MOD_LoadBmodel: funny lump size in %s",loadmodel->name);
-	count = l->filelen / sizeof(*in);
-	out = Hunk_AllocName ( count*sizeof(*out), loadname);	
-
-	loadmodel->nodes = out;
-	loadmodel->numnodes = count;
+	in = (dnode_t *)data + first;
+	out = loadmodel->nodes + first;
 
 	for ( i=0 ; i<count ; i++, in++, out++)
 	{
@@ -886,8 +1355,25 @@ void Mod_LoadNodes (lump_t *l)
 				out->children[j] = (mnode_t *)(loadmodel->leafs + (-1 - p));
 		}
 	}
-	
-	Mod_SetParent (loadmodel->nodes, NULL);	// sets nodes and leafs
+}
+
+void Mod_LoadNodes (lump_t *l)
+{
+	dnode_t		*in;
+	mnode_t 	*out;
+	int			count;
+
+	in = (void *)(mod_base + l->fileofs);
+	if (l->filelen % sizeof(*in))
+		Sys_Error ("MOD_LoadBmodel: funny lump size in %s",loadmodel->name);
+	count = l->filelen / sizeof(*in);
+	out = Hunk_AllocName ( count*sizeof(*out), loadname);	
+
+	loadmodel->nodes = out;
+	loadmodel->numnodes = count;
+
+	Mod_LumpJob (Mod_ConvertNodes, in, count, MOD_LUMPCHUNK);
+// Mod_LoadBrushModel links the parents once every node is in
 }
 
 /*
@@ -895,20 +1381,14 @@ void Mod_LoadNodes (lump_t *l)
 Mod_LoadLeafs
 =================
 */
-void Mod_LoadLeafs (lump_t *l)
+void Mod_ConvertLeafs (void *data, int first, int count)
 {
 	dleaf_t 	*in;
 	mleaf_t 	*out;
-	int			i, j, count, p;
+	int			i, j, p;
 
-	in = (void *)(mod_base + l->fileofs);
-	if (l->filelen % sizeof(*in))
-		Sys_Error ("MOD_LoadBmodel: funny lump size in %s",loadmodel->name);
-	count = l->filelen / sizeof(*in);
-	out = Hunk_AllocName ( count*sizeof(*out), loadname);	
-
-	loadmodel->leafs = out;
-	loadmodel->numleafs = count;
+	in = (dleaf_t *)data + first;
+	out = loadmodel->leafs + first;
 
 	for ( i=0 ; i<count ; i++, in++, out++)
 	{
@@ -937,15 +1417,49 @@ void Mod_LoadLeafs (lump_t *l)
 	}	
 }
 
+void Mod_LoadLeafs (lump_t *l)
+{
+	dleaf_t 	*in;
+	mleaf_t 	*out;
+	int			count;
+
+	in = (void *)(mod_base + l->fileofs);
+	if (l->filelen % sizeof(*in))
+		Sys_Error ("MOD_LoadBmodel: funny lump size in %s",loadmodel->name);
+	count = l->filelen / sizeof(*in);
+	out = Hunk_AllocName ( count*sizeof(*out), loadname);	
+
+	loadmodel->leafs = out;
+	loadmodel->numleafs = count;
+
+	Mod_LumpJob (Mod_ConvertLeafs, in, count, MOD_LUMPCHUNK);
+}
+
 /*
 =================
 Mod_LoadClipnodes
 =================
 */
+void Mod_ConvertClipnodes (void *data, int first, int count)
+{
+	dclipnode_t *in, *out;
+	int			i;
+
+	in = (dclipnode_t *)data + first;
+	out = loadmodel->clipnodes + first;
+
+	for (i=0 ; i<count ; i++, out++, in++)
+	{
+		out->planenum = LittleLong(in->planenum);
+		out->children[0] = LittleShort(in->children[0]);
+		out->children[1] = LittleShort(in->children[1]);
+	}
+}
+
 void Mod_LoadClipnodes (lump_t *l)
 {
 	dclipnode_t *in, *out;
-	int			i, count;
+	int			count;
 	hull_t		*hull;
 
 	in = (void *)(mod_base + l->fileofs);
@@ -981,12 +1495,7 @@ void Mod_LoadClipnodes (lump_t *l)
 	hull->clip_maxs[1] = 32;
 	hull->clip_maxs[2] = 64;
 
-	for (i=0 ; i<count ; i++, out++, in++)
-	{
-		out->planenum = LittleLong(in->planenum);
-		out->children[0] = LittleShort(in->children[0]);
-		out->children[1] = LittleShort(in->children[1]);
-	}
+	Mod_LumpJob (Mod_ConvertClipnodes, in, count, MOD_LUMPCHUNK);
 }
 
 /*
@@ -1033,9 +1542,27 @@ void Mod_MakeHull0 (void)
 Mod_LoadMarksurfaces
 =================
 */
+void Mod_ConvertMarksurfaces (void *data, int first, int count)
+{	
+	int		i, j;
+	short		*in;
+	msurface_t **out;
+	
+	in = (short *)data + first;
+	out = loadmodel->marksurfaces + first;
+
+	for ( i=0 ; i<count ; i++)
+	{
+		j = LittleShort(in[i]);
+		if (j >= loadmodel->numsurfaces)
+			Sys_Error ("Mod_ParseMarksurfaces: bad surface number");
+		out[i] = loadmodel->surfaces + j;
+	}
+}
+
 void Mod_LoadMarksurfaces (lump_t *l)
 {	
-	int		i, j, count;
+	int		count;
 	short		*in;
 	msurface_t **out;
 	
@@ -1048,13 +1575,7 @@ void Mod_LoadMarksurfaces (lump_t *l)
 	loadmodel->marksurfaces = out;
 	loadmodel->nummarksurfaces = count;
 
-	for ( i=0 ; i<count ; i++)
-	{
-		j = LittleShort(in[i]);
-		if (j >= loadmodel->numsurfaces)
-			Sys_Error ("Mod_ParseMarksurfaces: bad surface number");
-		out[i] = loadmodel->surfaces + j;
-	}
+	Mod_LumpJob (Mod_ConvertMarksurfaces, in, count, MOD_LUMPCHUNK);
 }
 
 /*
@@ -1062,9 +1583,21 @@ void Mod_LoadMarksurfaces (lump_t *l)
 Mod_LoadSurfedges
 =================
 */
+void Mod_ConvertSurfedges (void *data, int first, int count)
+{	
+	int		i;
+	int		*in, *out;
+	
+	in = (int *)data + first;
+	out = loadmodel->surfedges + first;
+
+	for ( i=0 ; i<count ; i++)
+		out[i] = LittleLong (in[i]);
+}
+
 void Mod_LoadSurfedges (lump_t *l)
 {	
-	int		i, count;
+	int		count;
 	int		*in, *out;
 	
 	in = (void *)(mod_base + l->fileofs);
@@ -1076,8 +1609,7 @@ void Mod_LoadSurfedges (lump_t *l)
 	loadmodel->surfedges = out;
 	loadmodel->numsurfedges = count;
 
-	for ( i=0 ; i<count ; i++)
-		out[i] = LittleLong (in[i]);
+	Mod_LumpJob (Mod_ConvertSurfedges, in, count, MOD_LUMPCHUNK);
 }
 
 /*
@@ -1085,22 +1617,15 @@ void Mod_LoadSurfedges (lump_t *l)
 Mod_LoadPlanes
 =================
 */
-void Mod_LoadPlanes (lump_t *l)
+void Mod_ConvertPlanes (void *data, int first, int count)
 {
 	int			i, j;
 	mplane_t	*out;
 	dplane_t 	*in;
-	int			count;
 	int			bits;
 	
-	in = (void *)(mod_base + l->fileofs);
-	if (l->filelen % sizeof(*in))
-		Sys_Error ("MOD_LoadBmodel: funny lump size in %s",loadmodel->name);
-	count = l->filelen / sizeof(*in);
-	out = Hunk_AllocName ( count*2*sizeof(*out), loadname);	
-	
-	loadmodel->planes = out;
-	loadmodel->numplanes = count;
+	in = (dplane_t *)data + first;
+	out = loadmodel->planes + first;
 
 	for ( i=0 ; i<count ; i++, in++, out++)
 	{
@@ -1118,6 +1643,24 @@ void Mod_LoadPlanes (lump_t *l)
 	}
 }
 
+void Mod_LoadPlanes (lump_t *l)
+{
+	mplane_t	*out;
+	dplane_t 	*in;
+	int			count;
+	
+	in = (void *)(mod_base + l->fileofs);
+	if (l->filelen % sizeof(*in))
+		Sys_Error ("MOD_LoadBmodel: funny lump size in %s",loadmodel->name);
+	count = l->filelen / sizeof(*in);
+	out = Hunk_AllocName ( count*2*sizeof(*out), loadname);	
+	
+	loadmodel->planes = out;
+	loadmodel->numplanes = count;
+
+	Mod_LumpJob (Mod_ConvertPlanes, in, count, MOD_LUMPCHUNK);
+}
+
 /*
 =================
 RadiusFromBounds
@@ -1136,32 +1679,440 @@ float RadiusFromBounds (vec3_t mins, vec3_t maxs)
 	return Length (corner);
 }
 
+/*
+===============================================================================
+
+					BRUSHMODEL CACHE
+
+A converted brush model is saved to bspcache/<name>-<bits>.bsc as an image
+of the hunk blocks Mod_LoadBrushModel allocated, with every pointer replaced
+by an offset, so loading it again is a read and a relocation pass.  <bits>
+is the pointer size, so 32 and 64 bit builds keep caches of their own.  The
+cache is keyed by the length, CRC and FNV-1a hash of the bsp, and is
+rebuilt whenever those or the layout of the structures don't match.
+
+===============================================================================
+*/
+
+#define	BSPCACHE_IDENT		(('C'<<24)+('S'<<16)+('B'<<8)+'Q')
+#define	BSPCACHE_VERSION	2
+
+// what Mod_LoadBrushCache found
+#define	BSPCACHE_LOADED		0
+#define	BSPCACHE_MISSING	1
+#define	BSPCACHE_STALE		2		// or damaged
+
+// the kind of pointer is kept in the low bits of a saved pointer
+#define	RELOC_IMAGE		1		// into the hunk image
+#define	RELOC_FILE		2		// into the mapped bsp
+#define	RELOC_NOTEXTURE	3		// r_notexture_mip
+
+typedef struct
+{
+	int				ident;
+	int				version;
+	int				sizes[8];		// of the structures, for an engine rebuilt since
+	unsigned short	crc;			// of the bsp
+	short			mapped;			// lighting and vis were left in the mapped bsp
+	unsigned		hash;			// of the bsp
+	int				filelen;
+	int				imagesize;
+	model_t			model;			// with its pointers saved
+} bspcache_t;
+
+cvar_t	mod_bspcache = {"mod_bspcache", "1"};
+
+byte		*mod_image;				// hunk image being saved or loaded
+int			mod_imagesize;
+int			mod_filelen;			// of the bsp at mod_base
+qboolean	mod_relocfailed;
+qboolean	mod_fromcache;			// the last brush model came from its cache
+qboolean	mod_cachedir;			// bspcache has been made this session
+qboolean	mod_cantsave;			// a cache couldn't be written, don't retry
+
+/*
+=================
+Mod_BrushFileLength
+
+The bsp ends with whichever lump ends last
+=================
+*/
+int Mod_BrushFileLength (dheader_t *header)
+{
+	int		i, end, len;
+
+	len = sizeof(dheader_t);
+	for (i=0 ; i<HEADER_LUMPS ; i++)
+	{
+		end = header->lumps[i].fileofs + header->lumps[i].filelen;
+		if (end > len)
+			len = end;
+	}
+	return len;
+}
+
 /*
 =================
-Mod_LoadBrushModel
+Mod_SavePointer
 =================
 */
-void Mod_LoadBrushModel (model_t *mod, void *buffer)
+void *Mod_SavePointer (void *ptr)
+{
+	byte	*p;
+
+	p = ptr;
+	if (!p)
+		return NULL;
+	if (p >= mod_image && p <= mod_image + mod_imagesize)
+		return (void *)(((long)(p - mod_image) << 2) | RELOC_IMAGE);
+	if (mod_mapped && p >= mod_base && p <= mod_base + mod_filelen)
+		return (void *)(((long)(p - mod_base) << 2) | RELOC_FILE);
+	if (ptr == r_notexture_mip)
+		return (void *)RELOC_NOTEXTURE;
+
+	mod_relocfailed = true;
+	return ptr;
+}
+
+/*
+=================
+Mod_CheckPointer
+
+Finds out if a model can be saved without changing it
+=================
+*/
+void *Mod_CheckPointer (void *ptr)
+{
+	Mod_SavePointer (ptr);
+	return ptr;
+}
+
+/*
+=================
+Mod_LoadPointer
+=================
+*/
+void *Mod_LoadPointer (void *ptr)
+{
+	long	ofs;
+
+	ofs = (long)ptr >> 2;
+	switch ((long)ptr & 3)
+	{
+	case 0:
+		if (ptr)
+			break;
+		return NULL;
+	case RELOC_IMAGE:
+		if (ofs > mod_imagesize)
+			break;
+		return mod_image + ofs;
+	case RELOC_FILE:
+		if (!mod_mapped || ofs > mod_filelen)
+			break;
+		return mod_base + ofs;
+	case RELOC_NOTEXTURE:
+		if (ofs)
+			break;
+		return r_notexture_mip;
+	}
+
+	mod_relocfailed = true;
+	return NULL;
+}
+
+/*
+=================
+Mod_RelocModel
+
+The pointers kept in the model_t itself
+=================
+*/
+void Mod_RelocModel (model_t *mod, void *(*reloc) (void *))
+{
+	int		i;
+
+	mod->submodels = reloc (mod->submodels);
+	mod->planes = reloc (mod->planes);
+	mod->leafs = reloc (mod->leafs);
+	mod->vertexes = reloc (mod->vertexes);
+	mod->edges = reloc (mod->edges);
+	mod->nodes = reloc (mod->nodes);
+	mod->texinfo = reloc (mod->texinfo);
+	mod->surfaces = reloc (mod->surfaces);
+	mod->surfedges = reloc (mod->surfedges);
+	mod->clipnodes = reloc (mod->clipnodes);
+	mod->marksurfaces = reloc (mod->marksurfaces);
+	for (i=0 ; i<MAX_MAP_HULLS ; i++)
+	{
+		mod->hulls[i].clipnodes = reloc (mod->hulls[i].clipnodes);
+		mod->hulls[i].planes = reloc (mod->hulls[i].planes);
+	}
+	mod->textures = reloc (mod->textures);
+	mod->visdata = reloc (mod->visdata);
+	mod->lightdata = reloc (mod->lightdata);
+	mod->entities = reloc (mod->entities);
+	mod->cache.data = reloc (mod->cache.data);
+}
+
+/*
+=================
+Mod_RelocArrays
+
+The pointers in the arrays of a model whose own pointers are usable.  The
+textures are reached through the texture list, so when saving its entries
+are done after the textures, and when loading before.
+=================
+*/
+void Mod_RelocArrays (model_t *mod, void *(*reloc) (void *), qboolean saving)
 {
 	int			i, j;
-	dheader_t	*header;
-	dmodel_t 	*bm;
-	
-	loadmodel->type = mod_brush;
-	
-	header = (dheader_t *)buffer;
+	mleaf_t		*leaf;
+	mnode_t		*node;
+	msurface_t	*surf;
+	texture_t	*tx;
 
-	i = LittleLong (header->version);
-	if (i != BSPVERSION)
-		Sys_Error ("Mod_LoadBrushModel: %s has wrong version number (%i should be %i)", mod->name, i, BSPVERSION);
+	for (i=0, leaf=mod->leafs ; i<mod->numleafs ; i++, leaf++)
+	{
+		leaf->parent = reloc (leaf->parent);
+		leaf->compressed_vis = reloc (leaf->compressed_vis);
+		leaf->efrags = reloc (leaf->efrags);
+		leaf->firstmarksurface = reloc (leaf->firstmarksurface);
+	}
 
-// swap all the lumps
-	mod_base = (byte *)header;
+	for (i=0, node=mod->nodes ; i<mod->numnodes ; i++, node++)
+	{
+		node->parent = reloc (node->parent);
+		node->plane = reloc (node->plane);
+		node->children[0] = reloc (node->children[0]);
+		node->children[1] = reloc (node->children[1]);
+	}
 
-	for (i=0 ; i<sizeof(dheader_t)/4 ; i++)
-		((int *)header)[i] = LittleLong ( ((int *)header)[i]);
+	for (i=0, surf=mod->surfaces ; i<mod->numsurfaces ; i++, surf++)
+	{
+		surf->plane = reloc (surf->plane);
+		for (j=0 ; j<MIPLEVELS ; j++)
+			surf->cachespots[j] = reloc (surf->cachespots[j]);
+		surf->texinfo = reloc (surf->texinfo);
+		surf->samples = reloc (surf->samples);
+	}
+
+	for (i=0 ; i<mod->nummarksurfaces ; i++)
+		mod->marksurfaces[i] = reloc (mod->marksurfaces[i]);
+
+	for (i=0 ; i<mod->numtexinfo ; i++)
+		mod->texinfo[i].texture = reloc (mod->texinfo[i].texture);
+
+	if (!mod->textures)
+		return;
+	for (i=0 ; i<mod->numtextures ; i++)
+	{
+		if (!saving)
+			mod->textures[i] = reloc (mod->textures[i]);
+		tx = mod->textures[i];
+		if (saving)
+			mod->textures[i] = reloc (mod->textures[i]);
+		if (!tx || mod_relocfailed)
+			continue;
+		tx->anim_next = reloc (tx->anim_next);
+		tx->alternate_anims = reloc (tx->alternate_anims);
+	}
+}
+
+/*
+=================
+Mod_BrushCacheSizes
+=================
+*/
+void Mod_BrushCacheSizes (int *sizes)
+{
+	sizes[0] = sizeof(void *);
+	sizes[1] = sizeof(model_t);
+	sizes[2] = sizeof(mleaf_t);
+	sizes[3] = sizeof(mnode_t);
+	sizes[4] = sizeof(msurface_t);
+	sizes[5] = sizeof(mtexinfo_t);
+	sizes[6] = sizeof(texture_t);
+	sizes[7] = sizeof(mplane_t);
+}
+
+/*
+=================
+Mod_BrushHash
+
+32 bit FNV-1a, to back up the CRC in the cache key
+=================
+*/
+unsigned Mod_BrushHash (byte *data, int len)
+{
+	unsigned	hash;
+
+	hash = 2166136261u;
+	while (len--)
+		hash = (hash ^ *data++) * 16777619u;
+	return hash;
+}
+
+/*
+=================
+Mod_BrushCacheName
+
+Returns false if the path doesn't fit
+=================
+*/
+qboolean Mod_BrushCacheName (char *name, int size)
+{
+	int		len;
+
+	len = snprintf (name, size, "%s/bspcache/%s-%i.bsc", com_gamedir,
+		loadname, (int)sizeof(void *)*8);
+	return len >= 0 && len < size;
+}
+
+/*
+=================
+Mod_SaveBrushCache
+
+Writes out the model Mod_LoadBrushModel converted onto the hunk above mark
+=================
+*/
+void Mod_SaveBrushCache (model_t *mod, int mark, unsigned short crc,
+	unsigned hash, int found)
+{
+	bspcache_t	cache;
+	char		name[MAX_OSPATH];
+	int			handle, len;
+
+	if (mod_cantsave || !Mod_BrushCacheName (name, sizeof(name)))
+		return;
 
-// load into heap
+	mod_image = Hunk_LowPointer (mark);
+	mod_imagesize = Hunk_LowMark () - mark;
+	mod_relocfailed = false;
+
+	Mod_RelocArrays (mod, Mod_CheckPointer, true);
+	memset (&cache, 0, sizeof(cache));
+	cache.model = *mod;
+	Mod_RelocModel (&cache.model, Mod_SavePointer);
+	if (mod_relocfailed)
+	{
+		Con_DPrintf ("%s can't be cached\n", mod->name);
+		return;
+	}
+
+	cache.ident = BSPCACHE_IDENT;
+	cache.version = BSPCACHE_VERSION;
+	Mod_BrushCacheSizes (cache.sizes);
+	cache.crc = crc;
+	cache.hash = hash;
+	cache.mapped = mod_mapped;
+	cache.filelen = mod_filelen;
+	cache.imagesize = mod_imagesize;
+
+// a stale cache's directory is already there
+	if (found == BSPCACHE_MISSING && !mod_cachedir)
+	{
+		char	dir[MAX_OSPATH];
+
+		len = snprintf (dir, sizeof(dir), "%s/bspcache", com_gamedir);
+		if (len >= 0 && len < sizeof(dir))
+			Sys_mkdir (dir);
+		mod_cachedir = true;
+	}
+	handle = Sys_FileOpenWrite (name);
+	if (handle == -1)
+	{
+		Con_DPrintf ("Couldn't write %s\n", name);
+		mod_cantsave = true;
+		return;
+	}
+
+	Mod_RelocArrays (mod, Mod_SavePointer, true);
+	Sys_FileWrite (handle, &cache, sizeof(cache));
+	Sys_FileWrite (handle, mod_image, mod_imagesize);
+	Sys_FileClose (handle);
+	Mod_RelocArrays (mod, Mod_LoadPointer, false);
+}
+
+/*
+=================
+Mod_LoadBrushCache
+
+Loads the model from its cache if the cache was made from this bsp.
+Otherwise the bsp has to be converted, and the return says whether there was
+no cache or a stale one.
+=================
+*/
+int Mod_LoadBrushCache (model_t *mod, unsigned short crc, unsigned hash)
+{
+	bspcache_t	cache;
+	char		name[MAX_OSPATH];
+	int			handle, len, mark, i, sizes[8];
+	model_t		*m;
+
+	if (!Mod_BrushCacheName (name, sizeof(name)))
+		return BSPCACHE_STALE;		// and can't be written either
+	len = Sys_FileOpenRead (name, &handle);
+	if (handle == -1)
+		return BSPCACHE_MISSING;
+
+	Mod_BrushCacheSizes (sizes);
+	if (len < sizeof(cache)
+	|| Sys_FileRead (handle, &cache, sizeof(cache)) != sizeof(cache)
+	|| cache.ident != BSPCACHE_IDENT || cache.version != BSPCACHE_VERSION
+	|| memcmp (cache.sizes, sizes, sizeof(sizes))
+	|| cache.crc != crc || cache.hash != hash || cache.mapped != mod_mapped
+	|| cache.filelen != mod_filelen
+	|| cache.imagesize != len - sizeof(cache))
+	{
+		Sys_FileClose (handle);
+		Con_DPrintf ("%s is out of date\n", name);
+		return BSPCACHE_STALE;
+	}
+
+	mark = Hunk_LowMark ();
+	mod_image = Hunk_LoadImage (handle, cache.imagesize);
+	Sys_FileClose (handle);
+	if (!mod_image)
+	{
+		Con_DPrintf ("%s is damaged\n", name);
+		return BSPCACHE_STALE;
+	}
+	mod_imagesize = cache.imagesize;
+	mod_relocfailed = false;
+
+	m = &cache.model;
+	Mod_RelocModel (m, Mod_LoadPointer);
+	if (!mod_relocfailed)
+		Mod_RelocArrays (m, Mod_LoadPointer, false);
+	if (mod_relocfailed)
+	{
+		Hunk_FreeToLowMark (mark);
+		Con_DPrintf ("%s is damaged\n", name);
+		return BSPCACHE_STALE;
+	}
+
+	// everything but the name and cache state comes from the cache
+	Q_memcpy (m->name, mod->name, sizeof(m->name));
+	m->needload = mod->needload;
+	*mod = *m;
+
+	for (i=0 ; mod->textures && i<mod->numtextures ; i++)
+		if (mod->textures[i] && !Q_strncmp(mod->textures[i]->name,"sky",3))
+			R_InitSky (mod->textures[i]);
+
+	return BSPCACHE_LOADED;
+}
+
+/*
+=================
+Mod_ConvertBrushModel
+=================
+*/
+void Mod_ConvertBrushModel (dheader_t *header)
+{
+// the lump conversions run on the worker threads when there are any
+	mod_parallel_load = mod_parallel.value && Job_NumThreads ();
 	
 	Mod_LoadVertexes (&header->lumps[LUMP_VERTEXES]);
 	Mod_LoadEdges (&header->lumps[LUMP_EDGES]);
@@ -1179,7 +2130,67 @@ void Mod_LoadBrushModel (model_t *mod, void *buffer)
 	Mod_LoadEntities (&header->lumps[LUMP_ENTITIES]);
 	Mod_LoadSubmodels (&header->lumps[LUMP_MODELS]);
 
+	if (mod_parallel_load)
+		Job_Wait ();
+	mod_parallel_load = false;
+
+	Mod_SetParent (loadmodel->nodes, NULL);	// sets nodes and leafs
 	Mod_MakeHull0 ();
+}
+
+/*
+=================
+Mod_LoadBrushModel
+=================
+*/
+void Mod_LoadBrushModel (model_t *mod, void *buffer)
+{
+	int			i, j, mark;
+	dheader_t	*header;
+	dheader_t	swapped;
+	dmodel_t 	*bm;
+	double		start;
+	unsigned short	crc;
+	unsigned	hash;
+	int			found;
+	
+	loadmodel->type = mod_brush;
+	start = Sys_FloatTime ();
+	
+	header = (dheader_t *)buffer;
+
+	i = LittleLong (header->version);
+	if (i != BSPVERSION)
+		Sys_Error ("Mod_LoadBrushModel: %s has wrong version number (%i should be %i)", mod->name, i, BSPVERSION);
+
+// swap all the lumps into a local copy, the file data may be mapped
+	mod_base = (byte *)buffer;
+
+	for (i=0 ; i<sizeof(dheader_t)/4 ; i++)
+		((int *)&swapped)[i] = LittleLong ( ((int *)header)[i]);
+	header = &swapped;
+	mod_filelen = Mod_BrushFileLength (header);
+
+// use the converted model from the last time this bsp was loaded if there
+// is one, otherwise convert it and save that for next time
+	mod_fromcache = false;
+	hash = 0;
+	found = BSPCACHE_MISSING;
+	mark = Hunk_LowMark ();
+	if (mod_bspcache.value)
+	{
+		CRC_Init (&crc);
+		CRC_Block (&crc, mod_base, mod_filelen);
+		hash = Mod_BrushHash (mod_base, mod_filelen);
+		found = Mod_LoadBrushCache (mod, crc, hash);
+		mod_fromcache = found == BSPCACHE_LOADED;
+	}
+	if (!mod_fromcache)
+	{
+		Mod_ConvertBrushModel (header);
+		if (mod_bspcache.value)
+			Mod_SaveBrushCache (mod, mark, crc, hash, found);
+	}
 	
 	mod->numframes = 2;		// regular and alternate animation
 	mod->flags = 0;
@@ -1218,6 +2229,135 @@ void Mod_LoadBrushModel (model_t *mod, void *buffer)
 			mod = loadmodel;
 		}
 	}
+
+	Con_DPrintf ("%s %s in %.1f ms\n", loadname, mod_fromcache ? "loaded from cache" : "loaded",
+		(Sys_FloatTime () - start) * 1000);
+}
+
+/*
+=================
+Mod_ChecksumBlock
+=================
+*/
+void Mod_ChecksumBlock (unsigned short *crc, void *data, int size)
+{
+	CRC_Block (crc, data, size);
+}
+
+/*
+=================
+Mod_BrushChecksum
+
+CRC of everything Mod_LoadBrushModel built from the file with the given
+header, pointers included, so two loads to the same hunk mark can be compared
+=================
+*/
+unsigned short Mod_BrushChecksum (model_t *mod, dheader_t *header)
+{
+	unsigned short	crc;
+
+	CRC_Init (&crc);
+	Mod_ChecksumBlock (&crc, mod, sizeof(*mod));
+	Mod_ChecksumBlock (&crc, mod->submodels, mod->numsubmodels*sizeof(*mod->submodels));
+	Mod_ChecksumBlock (&crc, mod->planes, mod->numplanes*2*sizeof(*mod->planes));
+	Mod_ChecksumBlock (&crc, mod->leafs, mod->numleafs*sizeof(*mod->leafs));
+	Mod_ChecksumBlock (&crc, mod->vertexes, mod->numvertexes*sizeof(*mod->vertexes));
+	Mod_ChecksumBlock (&crc, mod->edges, mod->numedges*sizeof(*mod->edges));
+	Mod_ChecksumBlock (&crc, mod->nodes, mod->numnodes*sizeof(*mod->nodes));
+	Mod_ChecksumBlock (&crc, mod->texinfo, mod->numtexinfo*sizeof(*mod->texinfo));
+	Mod_ChecksumBlock (&crc, mod->surfaces, mod->numsurfaces*sizeof(*mod->surfaces));
+	Mod_ChecksumBlock (&crc, mod->surfedges, mod->numsurfedges*sizeof(*mod->surfedges));
+	Mod_ChecksumBlock (&crc, mod->clipnodes, mod->numclipnodes*sizeof(*mod->clipnodes));
+	Mod_ChecksumBlock (&crc, mod->hulls[0].clipnodes, mod->numnodes*sizeof(*mod->clipnodes));
+	Mod_ChecksumBlock (&crc, mod->marksurfaces, mod->nummarksurfaces*sizeof(*mod->marksurfaces));
+	Mod_ChecksumBlock (&crc, mod->textures, mod->numtextures*sizeof(*mod->textures));
+	if (mod->lightdata)
+		Mod_ChecksumBlock (&crc, mod->lightdata, LittleLong (header->lumps[LUMP_LIGHTING].filelen));
+	if (mod->visdata)
+		Mod_ChecksumBlock (&crc, mod->visdata, LittleLong (header->lumps[LUMP_VISIBILITY].filelen));
+	return CRC_Value (crc);
+}
+
+/*
+=================
+Mod_BspTest_f
+
+bsptest <map> : loads a map serially, in parallel and from the brush model
+cache, and compares the load times and the models that came out
+=================
+*/
+void Mod_BspTest_f (void)
+{
+	model_t		*saved, test;
+	int			savednum, mark, pass, tries;
+	float		saveparallel, savecache;
+	byte		*buf;
+	double		time[3];
+	unsigned short	crc[3];
+
+	if (Cmd_Argc () != 2)
+	{
+		Con_Printf ("bsptest <map> : times loads of maps/<map>.bsp\n");
+		return;
+	}
+	if (sv.active || cls.state == ca_connected)
+	{
+		Con_Printf ("bsptest: disconnect first\n");
+		return;
+	}
+
+	saved = malloc (sizeof(mod_known));
+	if (!saved)
+		Sys_Error ("Mod_BspTest_f: out of memory");
+	memcpy (saved, mod_known, sizeof(mod_known));
+	savednum = mod_numknown;
+	saveparallel = mod_parallel.value;
+	savecache = mod_bspcache.value;
+	mark = Hunk_LowMark ();
+
+// the cached pass is run again if the first try had to write the cache
+	for (pass = 0, tries = 0 ; pass < 3 ; )
+	{
+		memset (&test, 0, sizeof(test));
+		sprintf (test.name, "maps/%s.bsp", Cmd_Argv(1));
+		buf = COM_MapFile (test.name);
+		mod_mapped = (buf != NULL);
+		if (!buf)
+			buf = COM_LoadHunkFile (test.name);
+		if (!buf)
+		{
+			Con_Printf ("bsptest: couldn't load %s\n", test.name);
+			break;
+		}
+		COM_FileBase (test.name, loadname);
+		loadmodel = &test;
+		mod_parallel.value = pass > 0;
+		mod_bspcache.value = pass == 2;
+
+		time[pass] = Sys_FloatTime ();
+		Mod_LoadBrushModel (&test, buf);
+		time[pass] = Sys_FloatTime () - time[pass];
+		crc[pass] = Mod_BrushChecksum (&test, (dheader_t *)buf);
+
+		Hunk_FreeToLowMark (mark);
+		memcpy (mod_known, saved, sizeof(mod_known));
+		mod_numknown = savednum;
+
+		if (pass < 2 || mod_fromcache || ++tries == 2)
+			pass++;
+	}
+
+	mod_parallel.value = saveparallel;
+	mod_bspcache.value = savecache;
+	free (saved);
+	if (pass < 3)
+		return;
+
+	Con_Printf ("serial %.1f ms, parallel %.1f ms on %i threads, %s %.1f ms\n",
+		time[0]*1000, time[1]*1000, Job_NumThreads (),
+		mod_fromcache ? "cached" : "uncached", time[2]*1000);
+	Con_Printf ("checksums %04x %04x %04x: %s\n", crc[0], crc[1], crc[2],
+		crc[0] == crc[1] && crc[1] == crc[2] ? "match" : "MISMATCH");
 }
 
 /*
@@ -375,8 +375,10 @@ void	Mod_ClearAll (void);
 model_t *Mod_ForName (char *name, qboolean crash);
 void	*Mod_Extradata (model_t *mod);	// handles caching
 void	Mod_TouchModel (char *name);
+void	Mod_Prefetch (char *name);
 
 mleaf_t *Mod_PointInLeaf (float *p, model_t *model);
 byte	*Mod_LeafPVS (mleaf_t *leaf, model_t *model);
+void	Mod_AddLeafPVS (mleaf_t *leaf, model_t *model, unsigned long *pvs);
 
 #endif	// __MODEL__
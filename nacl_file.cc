@@ -10,7 +10,9 @@
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <pthread.h>
+#include <sys/time.h>
 
+#include <algorithm>
 #include <string>
 #include <tr1/functional>
 #include <tr1/memory>
@@ -18,6 +20,7 @@
 #include "file_handler.h"
 #include "geturl_handler.h"
 #include "nacl/nacl_inttypes.h"
+#include "ppapi/c/pp_errors.h"
 #include "ppapi/c/pp_file_info.h"
 #include "ppapi/c/ppb_file_io.h"
 #include "ppapi/cpp/file_io.h"
@@ -60,9 +63,14 @@ namespace {
     return std::string("/") + str;
   }
 
-  enum FETCH_TIME {
-    FETCHED_AT_START, FETCHED_AFTER_START
-  };
+  // Files are downloaded in range requests of this many bytes.
+  const size_t kChunkSize = 256u * 1024u;
+  // How many range requests may be outstanding at once.
+  const int kMaxChunksInFlight = 6;
+  // How many failed range requests of a file are asked for again.
+  const int kMaxChunkRetries = 4;
+  // How many files may be idle prefetched at once.
+  const int kMaxIdleFetches = 2;
 }
 
 namespace nacl_file {
@@ -84,17 +92,228 @@ bool Lock::Try() {
   return (rv == 0);
 }
 
+Condition::Condition() {
+  pthread_cond_init(&cond_, NULL);
+}
+Condition::~Condition() {
+  pthread_cond_destroy(&cond_);
+}
+void Condition::Wait(Lock* lock) {
+  pthread_cond_wait(&cond_, &lock->mutex_);
+}
+void Condition::Broadcast() {
+  pthread_cond_broadcast(&cond_);
+}
+
+namespace {
+// Like ScopedLock, but adds any time spent waiting for the lock to the
+// FileManager's lock wait total.
+class TimedScopedLock {
+ public:
+  explicit TimedScopedLock(Lock* lock)
+      : lock_(lock) {
+    if (lock_->Try())
+      return;
+    struct timeval start, end;
+    gettimeofday(&start, NULL);
+    lock_->Acquire();
+    gettimeofday(&end, NULL);
+    FileManager::AddLockWait((end.tv_sec - start.tv_sec) * 1000000 +
+                             (end.tv_usec - start.tv_usec));
+  }
+  ~TimedScopedLock() {
+    lock_->Release();
+  }
+ private:
+  TimedScopedLock(const TimedScopedLock&);  // Unimplemented, do not use.
+  TimedScopedLock& operator=(const TimedScopedLock&);  // Unimplemented.
+  Lock* lock_;
+};
+
+// Copies up to |num_bytes| from |data| at |*position| and advances it.
+int ReadBytes(const std::vector<uint8_t>& data, size_t* position,
+              void* buffer, size_t num_bytes) {
+  if (*position >= data.size()) {
+    PRINTF("Returning 0; EOF.\n");
+    return 0;  // EOF
+  }
+  int bytes_to_read(std::min(num_bytes, data.size() - *position));
+  memcpy(buffer, &data[*position], bytes_to_read);
+  *position += bytes_to_read;
+  PRINTF("Read %d bytes successfully, setting position to %zd.\n",
+         bytes_to_read, *position);
+  return bytes_to_read;
+}
+}  // namespace
+
 File::File(const std::string& name_arg, FileManager* fm)
     : name(StripPath(name_arg)), lock(new Lock()), file_ref(NULL),
-      file_io(NULL), write_in_progress(false), file_manager(fm), exists(true) {
+      file_io(NULL), write_in_progress(false), file_manager(fm), exists(true),
+      complete(false), streaming(false), size_known(false),
+      first_chunk_requested(false),
+      chunks_resident(0u), chunk_retries(0), failed(false),
+      download_finished(false), data_arrived(new Condition()),
+      fetch_started(false), idle_fetch(false), fetch_finished(false),
+      published(NULL),
+      snapshot_readers(0), persisted_size(0u), writing(NULL) {
   PRINTF("Created 'File' object for %s.\n", name.c_str());
 }
 
-void File::QueueWrite() {
+bool File::HasRange(size_t start, size_t end) const {
+  if (complete)
+    return true;
+  if (!size_known)
+    return false;
+  if (end > data.size())
+    end = data.size();
+  if (start >= end)
+    return true;
+  for (size_t chunk = start / kChunkSize; chunk <= (end - 1) / kChunkSize;
+       ++chunk) {
+    if (!chunk_resident[chunk])
+      return false;
+  }
+  return true;
+}
+
+bool File::WaitForRange(size_t start, size_t end) {
+  // Demand again whenever the download starts or its size becomes known,
+  // since that changes which chunks can be asked for.
+  int demanded_state = -1;
+  while (!HasRange(start, end)) {
+    if (failed)
+      return false;
+    int state = (streaming ? 1 : 0) | (size_known ? 2 : 0);
+    if (state != demanded_state) {
+      demanded_state = state;
+      if (streaming) {
+        // Bump the missing chunks to the front of the queue. The FileManager
+        // locks before the File, so we can't hold our lock while asking.
+        lock->Release();
+        FileManager::DemandRange(this, start, end);
+        lock->Acquire();
+      }
+      continue;
+    }
+    data_arrived->Wait(lock);
+  }
+  return true;
+}
+
+bool File::WaitForComplete() {
+  // The first wait returns once the size is known.
+  return WaitForRange(0, 0) && WaitForRange(0, contents().size());
+}
+
+void File::MarkComplete() {
   ScopedLock scoped_lock(lock);
-  // Copy the whole file on to our write queue.
-  write_queue.push_back(data);
-  StartWrite();
+  complete = true;
+  // We only get here for files read from the local file system.
+  persisted_size = data.size();
+  Publish();
+  data_arrived->Broadcast();
+}
+
+const FileSnapshot* File::AcquireSnapshot() {
+  // Count ourselves before looking at |published|, so that Unpublish can
+  // tell whether the snapshot it replaced might still be in use.  The
+  // __sync builtins are full barriers.
+  __sync_fetch_and_add(&snapshot_readers, 1);
+  const FileSnapshot* snapshot = published;
+  if (!snapshot)
+    __sync_fetch_and_sub(&snapshot_readers, 1);
+  return snapshot;
+}
+
+void File::ReleaseSnapshot() {
+  __sync_fetch_and_sub(&snapshot_readers, 1);
+}
+
+void File::Publish() {
+  if (published)
+    return;
+  FileSnapshot* snapshot = new FileSnapshot;
+  snapshot->data.swap(data);
+  // Make sure the bytes are visible before the pointer is.
+  __sync_synchronize();
+  published = snapshot;
+}
+
+void File::Unpublish() {
+  FileSnapshot* snapshot = published;
+  if (!snapshot)
+    return;
+  published = NULL;
+  __sync_synchronize();
+  if (!snapshot_readers && !snapshot->writes_pending) {
+    // Nobody else can see it any more, so just take the bytes back.
+    data.swap(snapshot->data);
+    delete snapshot;
+  } else {
+    // Readers may still be copying out of the old snapshot, or a write may
+    // still be saving it, so copy rather than steal its bytes.
+    data = snapshot->data;
+    retired_snapshots.push_back(snapshot);
+  }
+  ReleaseRetired();
+}
+
+void File::ReleaseRetired() {
+  if (retired_snapshots.empty() || snapshot_readers != 0)
+    return;
+  std::vector<FileSnapshot*> still_writing;
+  for (size_t i = 0; i < retired_snapshots.size(); ++i) {
+    if (retired_snapshots[i]->writes_pending)
+      still_writing.push_back(retired_snapshots[i]);
+    else
+      delete retired_snapshots[i];
+  }
+  retired_snapshots.swap(still_writing);
+}
+
+bool File::RequestChunk(size_t chunk) {
+  if (complete)
+    return false;
+  if (!size_known) {
+    // Until the first response tells us the size, only chunk 0 can be asked
+    // for.
+    if (chunk != 0 || first_chunk_requested)
+      return false;
+    first_chunk_requested = true;
+    return true;
+  }
+  if (chunk >= chunk_requested.size() || chunk_requested[chunk])
+    return false;
+  chunk_requested[chunk] = true;
+  return true;
+}
+
+void File::MarkDirty(size_t start, size_t end) {
+  if (start >= end)
+    return;
+  // Merge with any range that overlaps or touches [start, end).
+  std::map<size_t, size_t>::iterator iter = dirty_ranges.upper_bound(start);
+  if (iter != dirty_ranges.begin()) {
+    std::map<size_t, size_t>::iterator prev = iter;
+    --prev;
+    if (prev->second >= start) {
+      start = prev->first;
+      end = std::max(end, prev->second);
+      dirty_ranges.erase(prev);
+    }
+  }
+  while (iter != dirty_ranges.end() && iter->first <= end) {
+    end = std::max(end, iter->second);
+    dirty_ranges.erase(iter++);
+  }
+  dirty_ranges[start] = end;
+}
+
+void File::QueueWrite() {
+  TimedScopedLock scoped_lock(lock);
+  // Writes queued before the last one starts are folded into it.
+  if (!write_in_progress)
+    StartWrite();
 }
 
 namespace {
@@ -110,64 +329,129 @@ void File::StartWrite() {
 }
 
 void File::StartWriteImpl() {
+  // Get this before locking; the FileManager locks before the File.
+  std::tr1::function<void(int32_t)> progress_func(
+      file_manager->write_progress_func());
   ScopedLock scoped_lock(lock);
-  if (!write_in_progress && !write_queue.empty()) {
-    write_in_progress = true;
-    FileHandler::WriteToFile(
-        file_io,
-        reinterpret_cast<std::vector<char>*>(&write_queue.front()),
-        file_manager->write_progress_func(),
-        std::tr1::bind(&File::WriteFinished, this));
+  if (write_in_progress)
+    return;
+  // Save from the published snapshot; it won't change under the write, so
+  // there is no need to copy anything.
+  Publish();
+  const std::vector<uint8_t>& bytes = published->data;
+  std::vector<FileHandler::WriteRange> ranges;
+  std::map<size_t, size_t>::iterator iter = dirty_ranges.begin();
+  for (; iter != dirty_ranges.end() && iter->first < bytes.size(); ++iter) {
+    size_t end = std::min(iter->second, bytes.size());
+    ranges.push_back(FileHandler::WriteRange(
+        iter->first, reinterpret_cast<const char*>(&bytes[iter->first]),
+        end - iter->first));
   }
+  dirty_ranges.clear();
+  // Writing past the end grows the file by itself; only shrinking needs an
+  // explicit SetLength.
+  int64_t length = -1;
+  if (bytes.size() < persisted_size)
+    length = bytes.size();
+  persisted_size = bytes.size();
+  if (ranges.empty() && length < 0)
+    return;
+  write_in_progress = true;
+  writing = published;
+  ++writing->writes_pending;
+  FileHandler::WriteRangesToFile(
+      file_io, length, ranges, progress_func,
+      std::tr1::bind(&File::WriteFinished, this));
 }
 
 void File::WriteFinished() {
   ScopedLock scoped_lock(lock);
-  write_queue.pop_front();
-  if (write_queue.empty())
-    write_in_progress = false;
-  else
+  --writing->writes_pending;
+  writing = NULL;
+  write_in_progress = false;
+  ReleaseRetired();
+  // Anything dirtied while we were writing goes out in one more write.
+  if (!dirty_ranges.empty() || contents().size() < persisted_size)
     StartWrite();
 }
 
 File::~File() {
+  delete published;
+  for (size_t i = 0; i < retired_snapshots.size(); ++i)
+    delete retired_snapshots[i];
+  delete data_arrived;
   delete lock;
 }
 
 int FileHandle::Length() {
-  ScopedLock lock(file->lock);
-  int size = static_cast<int>(file->data.size());
+  const FileSnapshot* snapshot = file->AcquireSnapshot();
+  if (snapshot) {
+    int size = static_cast<int>(snapshot->data.size());
+    file->ReleaseSnapshot();
+    return size;
+  }
+  TimedScopedLock lock(file->lock);
+  if (!file->size_known)
+    file->WaitForRange(0, 0);
+  int size = static_cast<int>(file->contents().size());
   PRINTF("Length is %d\n", size);
   return size;
 }
 
 int FileHandle::Read(void* buffer, size_t num_bytes) {
-  ScopedLock lock(file->lock);
-  PRINTF("Attempting read of %s, position %zd, size %zd, %zd bytes.\n", file->name.c_str(), position, file->data.size(), num_bytes);
-  if (position == file->data.size()) {
-    PRINTF("Returning 0; EOF.\n");
-    return 0;  // EOF
+  // Complete files are read straight from their snapshot, without the lock.
+  const FileSnapshot* snapshot = file->AcquireSnapshot();
+  if (snapshot) {
+    int bytes_read = ReadBytes(snapshot->data, &position, buffer, num_bytes);
+    file->ReleaseSnapshot();
+    return bytes_read;
   }
-  int bytes_to_read(std::min(num_bytes, file->data.size() - position));
-  memcpy(buffer, &file->data[position], bytes_to_read);
-  position += bytes_to_read;
-  PRINTF("Read %zd bytes successfully, setting position to %zd.\n", bytes_to_read, position);
-  return bytes_to_read;
+  TimedScopedLock lock(file->lock);
+  if (!file->WaitForRange(position, position + num_bytes)) {
+    PRINTF("Read of %s failed; chunks missing.\n", file->name.c_str());
+    errno = EIO;
+    return -1;
+  }
+  PRINTF("Attempting read of %s, position %zd, size %zd, %zd bytes.\n", file->name.c_str(), position, file->contents().size(), num_bytes);
+  return ReadBytes(file->contents(), &position, buffer, num_bytes);
 }
 
 int FileHandle::Write(void* buffer, size_t num_bytes) {
-  ScopedLock lock(file->lock);
+  TimedScopedLock lock(file->lock);
+  // Don't let a download overwrite what we write.
+  if (!file->WaitForComplete()) {
+    errno = EIO;
+    return -1;
+  }
+  // Readers keep using the old snapshot until this handle is closed.
+  file->Unpublish();
   PRINTF("Attempting write of %s, position %zd, size %zd, %zd bytes.\n", file->name.c_str(), position, file->data.size(), num_bytes);
   if (position + num_bytes > file->data.size()) {
     file->data.resize(position + num_bytes);
   }
   memcpy(&file->data[position], buffer, num_bytes);
+  file->MarkDirty(position, position + num_bytes);
   position += num_bytes;
   is_dirty = true;
   PRINTF("Wrote %zd bytes successfully, setting position to %zd.\n", num_bytes, position);
   return num_bytes;
 }
 
+void FileHandle::Truncate() {
+  TimedScopedLock lock(file->lock);
+  // Don't let a download put the old contents back.  A failed download is
+  // replaced entirely, so it can't leave holes.
+  if (!file->WaitForComplete()) {
+    file->failed = false;
+    file->complete = true;
+  }
+  file->Unpublish();
+  file->data.clear();
+  position = 0;
+  // Nothing to write, but the file on disk has to shrink.
+  is_dirty = true;
+}
+
 // We're being closed.
 FileHandle::~FileHandle() {
   // If we made the file dirty, flush it. Note QueueWrite locks for us.
@@ -177,8 +461,8 @@ FileHandle::~FileHandle() {
 }
 
 off_t FileHandle::Seek(off_t offset, int whence) {
-  ScopedLock lock(file->lock);
-  PRINTF("Seeking from %zd with offset %ld, size=%zd, whence=", position, static_cast<long>(offset), file->data.size());
+  // |position| belongs to this handle, so only SEEK_END needs the file.
+  PRINTF("Seeking from %zd with offset %ld, whence=", position, static_cast<long>(offset));
   switch (whence) {
     case SEEK_SET:
       PRINTF("SEEK_SET");
@@ -190,7 +474,7 @@ off_t FileHandle::Seek(off_t offset, int whence) {
       break;
     case SEEK_END:
       PRINTF("SEEK_END");
-      position = static_cast<off_t>(file->data.size()) - offset;
+      position = static_cast<off_t>(Length()) - offset;
       break;
     default:
       break;
@@ -200,49 +484,237 @@ off_t FileHandle::Seek(off_t offset, int whence) {
 }
 
 FileManager::FileManager(pp::Instance* instance)
-    : last_fd_(2),  // start with empty spots for stdout, stdin, and stderr
+    : chunks_in_flight_(0),
       instance_(instance),
       callback_factory_(this),
       file_system_(instance, PP_FILESYSTEMTYPE_LOCALPERSISTENT),
       //file_system_(instance, PP_FILESYSTEMTYPE_LOCALTEMPORARY),
-      file_system_opened_(false) {
+      file_system_opened_(false),
+      directories_created_(false),
+      foreground_fetches_(0),
+      idle_fetches_(0) {
   PRINTF("Constructing FileManager.\n");
 }
 
 FileManager::~FileManager() {}
 
 void FileManager::FileReadFinished(File* file) {
+  ScopedLock lock(&lock_);
   if (!file->data.size())
     file->exists = false;
-  file->lock->Release();
+  file->MarkComplete();
+  if (!FetchFinished(file))
+    return;
   pending_files_.erase(file->name);
   if (pending_files_.empty() && pending_fetch_set_.empty() && ready_func_) {
     ready_func_();
   }
 }
-void FileManager::URLRequestFinished(File* file,
-                                     std::vector<uint8_t>& data) {
-  // Put the data in the file and unlock any waiting reads/writes/etc.
-  file->data.swap(data);
-  file->lock->Release();
-  file->QueueWrite();
+
+void FileManager::FileDownloadFinished(File* file) {
+  // Requests still in flight when the download ended don't end it again.
+  if (file->download_finished)
+    return;
+  file->download_finished = true;
+  bool persist;
+  {
+    ScopedLock file_lock(file->lock);
+    // A failed download has holes, so it isn't saved.
+    persist = file->exists && file->complete;
+    // The local copy is empty, so all of it needs saving.
+    if (persist)
+      file->MarkDirty(0, file->contents().size());
+  }
+  if (persist)
+    file->QueueWrite();
+  if (!FetchFinished(file))
+    return;
   pending_files_.erase(file->name);
   if (pending_files_.empty() && ready_func_) {
     ready_func_();
   }
 }
 
-FileManager::ResponseHandler::ResponseHandler(File* file)
-    : file_(file) {
+void FileManager::ChunkArrived(File* file, size_t chunk,
+                               std::vector<uint8_t>& data, int32_t error,
+                               int64_t total_size, bool partial) {
+  --chunks_in_flight_;
+  if (error || (partial && total_size < 0)) {
+    // A missing file or a server that can't say how big it is won't do
+    // better the next time.
+    ChunkFailed(file, chunk, error && error != PP_ERROR_FILENOTFOUND);
+    PumpChunkRequests();
+    return;
+  }
+  bool finished = false;
+  bool short_chunk = false;
+  {
+    ScopedLock file_lock(file->lock);
+    if (file->complete || file->failed) {
+      // Still in flight when the file finished or failed; nothing to do.
+    } else if (!partial) {
+      // The server ignored the range and sent the whole file.
+      file->data.swap(data);
+      file->complete = true;
+    } else {
+      if (!file->size_known) {
+        // This is the first chunk, so now we know how big the file is. Queue
+        // up the rest of it behind whatever else is waiting.
+        size_t num_chunks = (static_cast<size_t>(total_size) + kChunkSize - 1)
+                            / kChunkSize;
+        file->data.resize(static_cast<size_t>(total_size));
+        file->chunk_resident.assign(num_chunks, false);
+        file->chunk_requested.assign(num_chunks, false);
+        file->chunk_requested[0] = true;
+        file->size_known = true;
+        for (size_t i = 1; i < num_chunks; ++i)
+          background_chunks_.push_back(ChunkRequest(file, i));
+      }
+      size_t offset = chunk * kChunkSize;
+      if (!file->chunk_resident[chunk] && offset < file->data.size()) {
+        size_t length = std::min(kChunkSize, file->data.size() - offset);
+        if (data.size() < length) {
+          // A short response would leave the rest of the chunk zeroed, so
+          // it doesn't count as resident.
+          short_chunk = true;
+        } else {
+          memcpy(&file->data[offset], &data[0], length);
+          file->chunk_resident[chunk] = true;
+          ++file->chunks_resident;
+        }
+      }
+      if (file->chunks_resident == file->chunk_resident.size())
+        file->complete = true;
+    }
+    finished = file->complete;
+    if (finished)
+      file->Publish();
+    file->data_arrived->Broadcast();
+  }
+  if (short_chunk)
+    ChunkFailed(file, chunk, true);
+  if (finished)
+    FileDownloadFinished(file);
+  PumpChunkRequests();
+}
+
+void FileManager::ChunkFailed(File* file, size_t chunk, bool retry) {
+  {
+    ScopedLock file_lock(file->lock);
+    if (file->complete || file->failed)
+      return;
+    if (retry && file->chunk_retries < kMaxChunkRetries) {
+      PRINTF("Retrying chunk %zd of %s\n", chunk, file->name.c_str());
+      ++file->chunk_retries;
+      if (file->size_known)
+        file->chunk_requested[chunk] = false;
+      else
+        file->first_chunk_requested = false;
+      urgent_chunks_.push_back(ChunkRequest(file, chunk));
+      return;
+    }
+    if (!file->size_known) {
+      // Nothing arrived, so treat the file as missing.
+      file->exists = false;
+      file->complete = true;
+      file->Publish();
+    } else {
+      // Handles may already be reading it, so keep what did arrive and fail
+      // reads of the rest.
+      file->failed = true;
+    }
+    file->data_arrived->Broadcast();
+  }
+  FileDownloadFinished(file);
+}
+
+void FileManager::PumpChunkRequests() {
+  while (chunks_in_flight_ < kMaxChunksInFlight) {
+    ChunkQueue* queue = &urgent_chunks_;
+    if (queue->empty())
+      queue = &background_chunks_;
+    if (queue->empty())
+      break;
+    ChunkRequest request(queue->front());
+    queue->pop_front();
+    bool start;
+    {
+      ScopedLock file_lock(request.file->lock);
+      start = request.file->RequestChunk(request.chunk);
+    }
+    if (start)
+      StartChunkRequest(request.file, request.chunk);
+  }
+}
+
+void FileManager::PumpChunkRequestsThunk(void* /* user_data */,
+                                         int32_t /* result */) {
+  instance()->PumpChunkRequests();
+}
+
+void FileManager::StartChunkRequest(File* file, size_t chunk) {
+  PRINTF("Requesting chunk %zd of %s\n", chunk, file->name.c_str());
+  ++chunks_in_flight_;
+  ResponseHandler* req_handler = new ResponseHandler(file, chunk);
+  GetURLHandler* handler = GetURLHandler::Create(instance_, file->name,
+                                                 kChunkSize);
+  handler->SetRange(chunk * kChunkSize, (chunk + 1) * kChunkSize - 1);
+  handler->set_progress_func(read_progress_func_);
+  handler->set_size_func(
+      std::tr1::bind(&ResponseHandler::SizeKnown, req_handler,
+                     std::tr1::placeholders::_1, std::tr1::placeholders::_2));
+  if (!handler->Start(NewGetURLCallback(req_handler,
+                                        &ResponseHandler::FileFinishedDownload))) {
+    // No callback is coming, so give the slot back here.  The handler has
+    // already freed itself.
+    --chunks_in_flight_;
+    delete req_handler;
+    ChunkFailed(file, chunk, true);
+  }
+}
+
+void FileManager::DemandRange(File* file, size_t start, size_t end) {
+  // Called from a reader, so the wait for lock_ is counted.
+  CHECK(file_manager_instance_);
+  FileManager* self = file_manager_instance_;
+  {
+    TimedScopedLock lock(&self->lock_);
+    ScopedLock file_lock(file->lock);
+    if (file->complete || file->failed || !file->streaming)
+      return;
+    if (!file->size_known) {
+      self->urgent_chunks_.push_back(ChunkRequest(file, 0));
+    } else {
+      if (end > file->data.size())
+        end = file->data.size();
+      for (size_t chunk = start / kChunkSize;
+           start < end && chunk <= (end - 1) / kChunkSize; ++chunk) {
+        if (!file->chunk_requested[chunk])
+          self->urgent_chunks_.push_back(ChunkRequest(file, chunk));
+      }
+    }
+  }
+  pp::Module::Get()->core()->CallOnMainThread(
+      0,
+      pp::CompletionCallback(&FileManager::PumpChunkRequestsThunk, NULL));
+}
+
+FileManager::ResponseHandler::ResponseHandler(File* file, size_t chunk)
+    : file_(file), chunk_(chunk), total_size_(-1), partial_(false) {
   PRINTF("Creating ResponseHandler.\n");
 }
 
+void FileManager::ResponseHandler::SizeKnown(int64_t total_size,
+                                             bool partial) {
+  total_size_ = total_size;
+  partial_ = partial;
+}
+
 void FileManager::ResponseHandler::FileFinishedDownload(
     std::vector<uint8_t>& data, int32_t error) {
-  PRINTF("Finished downloading %s, %zd bytes, error: %"NACL_PRId32".\n", file_->name.c_str(), data.size(), error);
-  if (error)
-    file_->exists = false;
-  FileManager::instance()->URLRequestFinished(file_, data);
+  PRINTF("Finished downloading chunk %zd of %s, %zd bytes, error: %"NACL_PRId32".\n", chunk_, file_->name.c_str(), data.size(), error);
+  FileManager::instance()->ChunkArrived(file_, chunk_, data, error,
+                                        total_size_, partial_);
   delete this;
 }
 
@@ -253,6 +725,16 @@ FileManager::FileManagerPtr FileManager::instance() {
 }
 
 FileManager* FileManager::file_manager_instance_ = NULL;
+FileHandle* volatile FileManager::file_handles_[FileManager::kMaxFDs];
+volatile int32_t FileManager::lock_wait_ = 0;
+
+void FileManager::AddLockWait(int32_t microseconds) {
+  __sync_fetch_and_add(&lock_wait_, microseconds);
+}
+
+int32_t FileManager::TakeLockWait() {
+  return __sync_lock_test_and_set(&lock_wait_, 0);
+}
 void FileManager::Init(pp::Instance* instance_arg, int64_t file_sys_size) {
   if (!file_manager_instance_) {
     file_manager_instance_ = new FileManager(instance_arg);
@@ -263,37 +745,82 @@ void FileManager::Init(pp::Instance* instance_arg, int64_t file_sys_size) {
           &nacl_file::FileManager::FileSystemOpened));
 }
 
+File* FileManager::Register(const std::string& file_name) {
+  FileMap::iterator iter = file_map_.find(file_name);
+  if (iter != file_map_.end())
+    return iter->second;
+  // Add an empty File to our map; reads/writes will block until the bytes
+  // they need have arrived.
+  File* file = new File(file_name, this);
+  file_map_[file_name] = file;
+  return file;
+}
+
+void FileManager::StartFetch(File* file, bool idle) {
+  if (file->fetch_started)
+    return;
+  PRINTF("Starting %s fetch of %s\n", idle ? "idle" : "foreground",
+         file->name.c_str());
+  file->fetch_started = true;
+  file->idle_fetch = idle;
+  if (idle)
+    ++idle_fetches_;
+  else
+    ++foreground_fetches_;
+  pending_fetch_set_.insert(file->name);
+  // If the file system is ready we can go ahead and start fetching; otherwise
+  // DirectoryCreated will get to it.
+  if (directories_created_) {
+    pp::Module::Get()->core()->CallOnMainThread(
+        0,
+        callback_factory_.NewCallback(
+            &nacl_file::FileManager::DoFetch,
+            file));
+  }
+}
+
+bool FileManager::FetchFinished(File* file) {
+  if (!file->fetch_started || file->fetch_finished)
+    return false;
+  file->fetch_finished = true;
+  if (file->idle_fetch)
+    --idle_fetches_;
+  else
+    --foreground_fetches_;
+  PumpIdleFetches();
+  return true;
+}
+
+void FileManager::PumpIdleFetches() {
+  while (foreground_fetches_ == 0 && idle_fetches_ < kMaxIdleFetches &&
+         !idle_files_.empty()) {
+    File* file = idle_files_.front();
+    idle_files_.pop_front();
+    StartFetch(file, true);
+  }
+}
+
 void FileManager::Fetch(const std::string& file_name_arg,
                         size_t size) {
   PRINTF("Requesting %s\n", file_name_arg.c_str());
   std::string file_name = StripPath(file_name_arg);
   FileManagerPtr self(instance());
-  std::pair<StringSet::iterator, bool> iter_success_pair;
-  iter_success_pair = self->pending_fetch_set_.insert(file_name);
-  bool success = iter_success_pair.second;
-  // If it was successful, then this is the first time the file has been
-  // added, and we should start a local file request.
-  if (success) {
-    // And add an empty, locked File to our map, so reads/writes will block
-    // until the file is ready.
-    std::pair<FileMap::iterator, bool> file_iter_success_pair;
-    file_iter_success_pair = self->file_map_.insert(
-        FileMap::value_type(file_name,
-                            new File(file_name, self.get())));
-    if (file_iter_success_pair.second) {
-      file_iter_success_pair.first->second->lock->Acquire();
-    }
-    // If this Fetch is happening after the file system has already been opened,
-    // we can go ahead and start fetching.
-    if (self->file_system_opened_) {
-      pp::Module::Get()->core()->CallOnMainThread(
-          0,
-          self->callback_factory_.NewCallback(
-              &nacl_file::FileManager::DoFetch,
-              file_name,
-              FETCHED_AFTER_START));
+  self->StartFetch(self->Register(file_name), false);
+}
+
+void FileManager::LoadManifest(const ManifestEntry* manifest) {
+  FileManagerPtr self(instance());
+  for (; manifest->name; ++manifest) {
+    File* file = self->Register(StripPath(manifest->name));
+    if (manifest->priority == FETCH_STARTUP) {
+      self->StartFetch(file, false);
+    } else {
+      if (manifest->priority == FETCH_MAP)
+        self->map_groups_[StripPath(manifest->map)].push_back(file);
+      self->idle_files_.push_back(file);
     }
   }
+  self->PumpIdleFetches();
 }
 
 void FileManager::DirectoryCreated(int32_t result, std::string name,
@@ -303,11 +830,13 @@ void FileManager::DirectoryCreated(int32_t result, std::string name,
          result, name.c_str(), directory_ref->pp_resource());
   pending_directories_set_.erase(name);
   if (pending_directories_set_.empty()) {
+    ScopedLock lock(&lock_);
+    directories_created_ = true;
     // No files have been fetched yet, because the file system was not open
     // at the time they were requested.
     StringSet::iterator iter = pending_fetch_set_.begin();
     for (; iter != pending_fetch_set_.end(); ++iter) {
-      DoFetch(0, *iter);
+      DoFetch(0, file_map_[*iter]);
     }
   }
   delete directory_ref;
@@ -322,12 +851,17 @@ void FileManager::FileSystemOpened(int32_t success) {
   // Make the directories we will need. We just assume these will either work
   // if the directories don't exist yet, or will fail if they exist (but we
   // don't care; we just want them to exist). We don't do completion callbacks.
-  StringSet::iterator iter(pending_fetch_set_.begin());
   std::set<std::string> directories;
-  // Find all unique directory names.
-  for (; iter != pending_fetch_set_.end(); ++iter) {
-    directories.insert(GetParent(*iter));
+  // Find all unique directory names, including those of registered files we
+  // haven't started fetching yet.
+  {
+    ScopedLock lock(&lock_);
+    FileMap::iterator file_iter(file_map_.begin());
+    for (; file_iter != file_map_.end(); ++file_iter) {
+      directories.insert(GetParent(file_iter->first));
+    }
   }
+  StringSet::iterator iter;
   // Make them, assuming either success or they already existed.
   for (iter = directories.begin(); iter != directories.end(); ++iter) {
     pp::FileRef* directory_ref = new pp::FileRef(file_system_,
@@ -345,6 +879,7 @@ void FileManager::FileQueried(int32_t result, File* file, PP_FileInfo* info) {
   PRINTF("FileQueried: result=%"NACL_PRId32", file=%s, size=%"NACL_PRId64"\n",
          result, file->name.c_str(), info->size);
   CHECK(result == PP_OK);
+  ScopedLock lock(&lock_);
   pending_fetch_set_.erase(file->name);
   // Now, finally, we can figure out if the file existed.
   int64_t size = info->size;
@@ -361,72 +896,82 @@ void FileManager::FileQueried(int32_t result, File* file, PP_FileInfo* info) {
           read_progress_func_,
           std::tr1::bind(&FileManager::FileReadFinished, this, file));
     } else {
-      ResponseHandler* req_handler = new ResponseHandler(file);
-      GetURLHandler* handler = GetURLHandler::Create(instance_, file->name);
-      handler->set_progress_func(read_progress_func_);
-      handler->Start(NewGetURLCallback(req_handler,
-                                       &ResponseHandler::FileFinishedDownload));
+      // Download it a chunk at a time. The first chunk tells us the size.
+      {
+        ScopedLock file_lock(file->lock);
+        file->streaming = true;
+        file->data_arrived->Broadcast();
+      }
+      background_chunks_.push_back(ChunkRequest(file, 0));
+      PumpChunkRequests();
     }
   }
 }
 
-void FileManager::FileOpened(int32_t result, File* file,
-                             FETCH_TIME fetch_time) {
+void FileManager::FileOpened(int32_t result, File* file) {
   PRINTF("FileOpened, result:%"NACL_PRId32", file:%s\n",
          result, file->name.c_str());
   CHECK(result == PP_OK);
-  if (fetch_time == FETCHED_AT_START) {
-    PP_FileInfo* file_info = new PP_FileInfo;
-    file->file_io->Query(file_info,
-                         callback_factory_.NewCallback(
-                             &nacl_file::FileManager::FileQueried,
-                             file,
-                             file_info));
-  } else {
-    // If we're fetching after start, we don't bother with URL loading; we just
-    // read all of the file, whatever it is.
-    FileHandler::ReadFromFile(
-        file->file_io,
-        reinterpret_cast<std::vector<char>* >(&file->data),
-        NULL,  // No progress required.
-        std::tr1::bind(&Lock::Release, file->lock));  // Just unlock when done.
-  }
+  PP_FileInfo* file_info = new PP_FileInfo;
+  file->file_io->Query(file_info,
+                       callback_factory_.NewCallback(
+                           &nacl_file::FileManager::FileQueried,
+                           file,
+                           file_info));
 }
 
-void FileManager::DoFetch(int32_t /* cc_result */, const std::string& file_name,
-                          FETCH_TIME fetch_time) {
-  PRINTF("DoFetch: file_name=%s\n", file_name.c_str());
-  // Start fetching the file from file_system_.
-  pp::FileRef* ref = new pp::FileRef(file_system_, AddSlash(file_name).c_str());
+void FileManager::DoFetch(int32_t /* cc_result */, File* file) {
+  PRINTF("DoFetch: file_name=%s\n", file->name.c_str());
+  // Start fetching the file from file_system_.  Only the main thread touches
+  // file_ref and file_io, so this needs no lock.
+  pp::FileRef* ref = new pp::FileRef(file_system_,
+                                     AddSlash(file->name).c_str());
   pp::FileIO* io = new pp::FileIO(instance_);
-  // Assume if we got here that there is already a File in the map.
-  File* file = file_map_[file_name];
   file->file_ref = ref;
   file->file_io = io;
   io->Open(
       *ref,
       PP_FILEOPENFLAG_WRITE | PP_FILEOPENFLAG_CREATE | PP_FILEOPENFLAG_READ,
       callback_factory_.NewCallback(&nacl_file::FileManager::FileOpened,
-                                    file,
-                                    fetch_time));
+                                    file));
 }
 
 bool FileManager::HasFD(int fd) {
-  FileManagerPtr self(instance());
-  FileHandleMap::const_iterator iter(self->file_handle_map_.find(fd));
-  return (iter != self->file_handle_map_.end());
+  return GetFileHandle(fd) != NULL;
 }
 
 int FileManager::GetFD(const std::string& file_name_arg, bool create) {
-  FileManagerPtr self(instance());
+  // Opened from the Quake thread, so the wait for lock_ is counted.
+  CHECK(file_manager_instance_);
+  FileManager* self = file_manager_instance_;
+  TimedScopedLock lock(&self->lock_);
   std::string file_name(StripPath(file_name_arg));
   FileMap::iterator iter = self->file_map_.find(file_name);
   if (iter != self->file_map_.end()) {
     if (create)
       iter->second->exists = true;
+    // Anything from the manifest that hasn't been fetched yet is needed now.
+    // Opening a map also pulls in everything that map was seen to load.
+    self->StartFetch(iter->second, false);
+    MapGroupMap::iterator group = self->map_groups_.find(file_name);
+    if (group != self->map_groups_.end()) {
+      for (size_t i = 0; i < group->second.size(); ++i)
+        self->StartFetch(group->second[i], false);
+      self->map_groups_.erase(group);
+    }
     if (iter->second->exists) {
-      int fd = ++self->last_fd_;
-      self->file_handle_map_[fd] = FileHandle(iter->second);
+      // Leave empty spots for stdin, stdout and stderr.
+      int fd = 3;
+      while (fd < kMaxFDs && file_handles_[fd])
+        ++fd;
+      if (fd == kMaxFDs) {
+        errno = EMFILE;
+        return -1;
+      }
+      FileHandle* handle = new FileHandle(iter->second);
+      // Make sure the handle is visible before the slot is.
+      __sync_synchronize();
+      file_handles_[fd] = handle;
       return fd;
     }
   }
@@ -437,7 +982,13 @@ int FileManager::GetFD(const std::string& file_name_arg, bool create) {
 
 
 void FileManager::Close(int fd) {
-  instance()->file_handle_map_.erase(fd);
+  if (fd < 0 || fd >= kMaxFDs)
+    return;
+  // Closing a dirty handle queues its write, which only takes the File's
+  // lock, so lock_ isn't needed to free the slot.
+  FileHandle* handle = __sync_lock_test_and_set(&file_handles_[fd],
+                                                static_cast<FileHandle*>(NULL));
+  delete handle;
 }
 
 void FileManager::Dump(const std::string& file_name_arg) {
@@ -445,7 +996,8 @@ void FileManager::Dump(const std::string& file_name_arg) {
   std::string file_name(StripPath(file_name_arg));
   FileMap::iterator iter = self->file_map_.find(file_name);
   if (iter != self->file_map_.end()) {
-    std::vector<uint8_t>& data = iter->second->data;
+    ScopedLock file_lock(iter->second->lock);
+    const std::vector<uint8_t>& data = iter->second->contents();
     for (size_t i = 0u; i < data.size(); ++i) {
       if (!(i % 16u))
         std::printf("0%zo", i);
@@ -464,12 +1016,10 @@ void FileManager::Dump(const std::string& file_name_arg) {
 
 FileHandle* FileManager::GetFileHandle(int fd) {
   PRINTF("Getting file for FD %d.\n", fd);
-  FileManagerPtr self(instance());
-  FileHandleMap::iterator iter = self->file_handle_map_.find(fd);
-  if (iter != self->file_handle_map_.end())
-    return &iter->second;
-
-  return NULL;
+  // No lock; see file_handles_.
+  if (fd < 0 || fd >= kMaxFDs)
+    return NULL;
+  return file_handles_[fd];
 }
 
 }  // namespace nacl_file
@@ -483,6 +1033,13 @@ int __wrap_open(char const *pathname, int oflags, int perms) {
     nacl_file::FileManager::Fetch(StripPath(pathname));
   }*/
   int fd = nacl_file::FileManager::GetFD(StripPath(pathname), create);
+  if (fd >= 0 && (oflags & (O_TRUNC | O_APPEND))) {
+    nacl_file::FileHandle* file = nacl_file::FileManager::GetFileHandle(fd);
+    if (oflags & O_TRUNC)
+      file->Truncate();
+    else
+      file->Seek(0, SEEK_END);
+  }
   PRINTF("Returning %d\n", fd);
   return fd;
 }
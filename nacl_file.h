@@ -22,6 +22,10 @@
 // It will asynchronously retrieve all the files, and when they have all
 // downloaded, it invokes your 'ready' function.
 //
+// Files that aren't in the local file system yet are downloaded in chunks
+// with HTTP range requests, so a Read only has to wait for the chunks it
+// touches.  Chunks that some Read is blocked on are requested before the rest.
+//
 // E.g.:
 //
 //  FileManager::set_pp_instance(this);
@@ -31,8 +35,34 @@
 //  FileManager::Fetch("levels/level1.lvl");
 //  FileManager::Fetch("levels/level2.lvl");
 //  //<etc>
+//
+// Instead of calling Fetch for everything up front, you can hand FileManager a
+// manifest (see make_manifest.py). Startup files are fetched right away. The
+// rest are registered so they can be opened, but are only fetched when their
+// map's .bsp is opened, when they are opened themselves, or a couple at a time
+// once nothing else is being fetched.
 namespace nacl_file {
 
+// How urgently a manifest entry is needed.
+enum FetchPriority {
+  // Needed before the first frame.
+  FETCH_STARTUP,
+  // Part of a map's precache set.
+  FETCH_MAP,
+  // Not known to be needed by anything in particular; registered so it can
+  // be opened, and prefetched when nothing else is being fetched.
+  FETCH_IDLE
+};
+
+// One entry of a prefetch manifest. A file may appear once for each map that
+// uses it. The manifest ends with an entry whose |name| is NULL.
+struct ManifestEntry {
+  const char* name;
+  size_t size;
+  int priority;     // A FetchPriority.
+  const char* map;  // For FETCH_MAP, the .bsp whose opening fetches this file.
+};
+
 
 // Some synchronization helpers. TODO(dmichael): These really belong in
 // separate files.
@@ -44,10 +74,24 @@ class Lock {
   void Release();
   bool Try();
  private:
+  friend class Condition;
   Lock(const Lock&);  // Unimplemented, do not use.
   Lock& operator=(const Lock&);  // Unimplemented, do not use.
   pthread_mutex_t mutex_;
 };
+// A condition variable to wait on while holding a Lock.
+class Condition {
+ public:
+  Condition();
+  ~Condition();
+  // |lock| must be held; it is released while waiting.
+  void Wait(Lock* lock);
+  void Broadcast();
+ private:
+  Condition(const Condition&);  // Unimplemented, do not use.
+  Condition& operator=(const Condition&);  // Unimplemented, do not use.
+  pthread_cond_t cond_;
+};
 class ScopedLock {
  public:
   explicit ScopedLock(Lock* lock)
@@ -116,8 +160,33 @@ class ThreadSafeRefCount {
 
 class FileManager;
 
+// The contents of a complete file.  Once published by a File it is never
+// modified, so readers can use it without taking File::lock.
+struct FileSnapshot {
+  FileSnapshot() : writes_pending(0) {}
+  std::vector<uint8_t> data;
+  // How many persistent writes in flight still refer to |data|.  Guarded by
+  // the owning File's lock.
+  int writes_pending;
+};
+
 // A simple struct to represent a file in memory.  It has the name and a vector
 // containing the data for the file.
+//
+// Until |complete| is set, |data| may still be arriving.  While a file is
+// being downloaded in chunks, |data| is sized as soon as the total length is
+// known and |chunk_resident| says which chunks of it are filled in.  Use
+// WaitForRange/WaitForComplete (with |lock| held) before touching |data|.
+//
+// When the file completes, its bytes move from |data| into a published
+// FileSnapshot, which readers get with AcquireSnapshot and no lock.  A write
+// takes the bytes back into |data| (Unpublish), and closing the written handle
+// publishes them again.
+//
+// Writes only persist what changed: FileHandle::Write records the byte ranges
+// it touched in |dirty_ranges|, and the next persistent write saves just those
+// ranges.  Everything dirtied while a write is in flight is saved by one
+// follow-up write.
 struct File {
   ~File();
   File(const std::string& name_arg, FileManager* fm);
@@ -127,14 +196,91 @@ struct File {
   FileManager* file_manager;
   pp::FileRef* file_ref;
   pp::FileIO* file_io;
-  std::deque<std::vector<uint8_t> > write_queue;
+  // Schedules a persistent write of the dirty ranges.
   void QueueWrite();
   void StartWriteImpl();
+  // Records that bytes [start, end) need saving.  |lock| must be held.
+  void MarkDirty(size_t start, size_t end);
+  // Dirty byte ranges not yet handed to a write, keyed by start; the value is
+  // the end.  Ranges never overlap or touch.
+  std::map<size_t, size_t> dirty_ranges;
+  // How big the file is in the local file system, as of the last write.
+  size_t persisted_size;
   bool exists;
+
+  // Set once all of |data| is present, or the file turned out to be missing.
+  bool complete;
+  // Set once we know the file is being downloaded rather than read locally.
+  bool streaming;
+  // Set once |data| has been sized for a chunked download.
+  bool size_known;
+  std::vector<bool> chunk_resident;
+  // Only touched on the main thread, by the FileManager.
+  std::vector<bool> chunk_requested;
+  bool first_chunk_requested;
+  size_t chunks_resident;
+  // Failed range requests that have been asked for again.
+  int chunk_retries;
+  // Set if a chunk past the first could not be downloaded.  Reads of the
+  // chunks that never arrived fail rather than see zeros.
+  bool failed;
+  // Set once the FileManager has handled the end of the download.  Only
+  // touched on the main thread, by the FileManager.
+  bool download_finished;
+  // Signalled whenever a chunk arrives or the file completes or fails.
+  Condition* data_arrived;
+
+  // Set once the FileManager has started fetching the file; until then it is
+  // only registered from the manifest.
+  bool fetch_started;
+  // Set if the fetch was started by idle prefetching.
+  bool idle_fetch;
+  // Set once FetchFinished has counted the fetch as done.
+  bool fetch_finished;
+
+  // The published contents, or NULL while the file is arriving or being
+  // written.  Only changed with |lock| held.
+  FileSnapshot* volatile published;
+  // Lock-free readers between AcquireSnapshot and ReleaseSnapshot.
+  volatile int32_t snapshot_readers;
+  // Snapshots replaced by Unpublish, deleted once nobody can be using them.
+  std::vector<FileSnapshot*> retired_snapshots;
+
+  // Returns the published snapshot, or NULL if there isn't one, without
+  // taking |lock|.  Call ReleaseSnapshot when done with a non-NULL result.
+  const FileSnapshot* AcquireSnapshot();
+  void ReleaseSnapshot();
+  // Moves |data| into a new published snapshot.  |lock| must be held.
+  void Publish();
+  // Takes the published bytes back into |data| so they can be modified.
+  // |lock| must be held.
+  void Unpublish();
+  // The file's current bytes, wherever they live.  |lock| must be held.
+  const std::vector<uint8_t>& contents() const {
+    return published ? published->data : data;
+  }
+
+  // Blocks until bytes [start, end) are readable, asking the FileManager to
+  // fetch any missing chunks first.  Returns false if some of them can't be
+  // downloaded.  |lock| must be held.
+  bool WaitForRange(size_t start, size_t end);
+  // Blocks until the whole file is present.  Returns false if it can't be
+  // downloaded.  |lock| must be held.
+  bool WaitForComplete();
+  // Marks the file as done and wakes up any waiting readers.
+  void MarkComplete();
+  // Returns false if the chunk has already been asked for.  |lock| must be held.
+  bool RequestChunk(size_t chunk);
+  bool HasRange(size_t start, size_t end) const;
  private:
   bool write_in_progress;
+  // The snapshot the write in flight is saving from.
+  FileSnapshot* writing;
   void StartWrite();
   void WriteFinished();
+  // Deletes retired snapshots no reader or write refers to.  |lock| must be
+  // held.
+  void ReleaseRetired();
   File(const File&);  // Unimplemented, do not use.
   File& operator=(const File&);  // Unimplemented, do not use.
 };
@@ -157,6 +303,8 @@ struct FileHandle {
   // buffer is grown, if necessary, to accomodate the written bytes.  Returns
   // 0 on success (no failure conditions yet).
   int Write(void* buffer, size_t num_bytes);
+  // Throw away the file's contents, as for O_TRUNC.
+  void Truncate();
   off_t Seek(off_t offset, int whence);
   int Length();
 
@@ -173,29 +321,67 @@ class FileManager {
   ~FileManager();
   void FileSystemOpened(int32_t success);
 
-  enum FETCH_TIME {
-    FETCHED_AT_START, FETCHED_AFTER_START
-  };
   // This is only called once the FileSystem is initialized. It starts a fetch
   // from the local file system using FileRef and FileIO. It has an unused
   // int32_t param first just so it can be used as a completion callback.
-  void DoFetch(int32_t /* cc_result */, const std::string& name,
-               FETCH_TIME fetch_time = FETCHED_AT_START);
-  void FileOpened(int32_t result, File* file, FETCH_TIME fetch_time);
+  void DoFetch(int32_t /* cc_result */, File* file);
+  void FileOpened(int32_t result, File* file);
   void DirectoryCreated(int32_t result, std::string directory,
                         pp::FileRef* directory_ref);
   void FileQueried(int32_t result, File* file, PP_FileInfo* info);
   void FileReadFinished(File* file);
-  void URLRequestFinished(File* file, std::vector<uint8_t>& data);
+  // Returns the File for |file_name|, adding it to file_map_ if needed.
+  File* Register(const std::string& file_name);
+  // Queues |file| to be fetched, if that hasn't started yet.
+  void StartFetch(File* file, bool idle);
+  // Called when a fetch has finished one way or another.  Only the first
+  // call for a file counts; returns false for any later ones.
+  bool FetchFinished(File* file);
+  // Starts idle prefetches while nothing else is being fetched.
+  void PumpIdleFetches();
+  void ChunkArrived(File* file, size_t chunk, std::vector<uint8_t>& data,
+                    int32_t error, int64_t total_size, bool partial);
+  void FileDownloadFinished(File* file);
+  // Asks for |chunk| again, or gives up on the file if |retry| is false or
+  // it has failed too often.  Must be called on the main thread with lock_
+  // held.
+  void ChunkFailed(File* file, size_t chunk, bool retry);
 
+  // Collects the response to one range request.
   class ResponseHandler {
    public:
-    ResponseHandler(File* file);
+    ResponseHandler(File* file, size_t chunk);
+    void SizeKnown(int64_t total_size, bool partial);
     void FileFinishedDownload(std::vector<uint8_t>& data, int32_t error);
    private:
     File* file_;
+    size_t chunk_;
+    int64_t total_size_;
+    bool partial_;
+  };
+  friend class ResponseHandler;
+
+  // A chunk of a file waiting to be requested.
+  struct ChunkRequest {
+    ChunkRequest(File* file_arg, size_t chunk_arg)
+        : file(file_arg), chunk(chunk_arg) {}
+    File* file;
+    size_t chunk;
   };
-  friend struct ResponseHandler;
+  typedef std::deque<ChunkRequest> ChunkQueue;
+  // Chunks some Read is blocked on; these are always requested first.
+  ChunkQueue urgent_chunks_;
+  // Everything else, in the order the files and chunks were discovered.
+  ChunkQueue background_chunks_;
+  int chunks_in_flight_;
+
+  // Starts range requests from the queues until the concurrency limit is
+  // reached.  Must be called on the main thread with lock_ held.  Like the
+  // fetch sets and maps below, the queues are also changed by the Quake
+  // thread, so every main thread callback that touches them holds lock_.
+  void PumpChunkRequests();
+  void StartChunkRequest(File* file, size_t chunk);
+  static void PumpChunkRequestsThunk(void* /* user_data */, int32_t result);
 
   typedef std::set<std::string> StringSet;
   // Files in this set are being fetched from local storage (or we're trying).
@@ -215,9 +401,12 @@ class FileManager {
   // via FileIO.
   FileMap pending_files_;
   FileMap file_map_;
-  typedef std::map<int, FileHandle> FileHandleMap;
-  FileHandleMap file_handle_map_;
-  int last_fd_;
+  // Open handles, indexed by fd.  Slots are claimed under lock_, but looked
+  // up without it, so reading an open file never waits behind a main thread
+  // callback that holds lock_.  A handle is fully built before its slot is
+  // set.
+  static const int kMaxFDs = 256;
+  static FileHandle* volatile file_handles_[kMaxFDs];
   std::tr1::function<void()> ready_func_;
   std::tr1::function<void(int32_t)> read_progress_func_;
   std::tr1::function<void(int32_t)> write_progress_func_;
@@ -227,8 +416,21 @@ class FileManager {
       callback_factory_;
   pp::FileSystem file_system_;
   bool file_system_opened_;
+  // Set once the directories for all registered files exist, so fetches can
+  // go straight to DoFetch.
+  bool directories_created_;
+
+  // Manifest files to fetch, in order, when there is nothing else to do.
+  std::deque<File*> idle_files_;
+  // Files to fetch as soon as the .bsp they are keyed by is opened.
+  typedef std::map<std::string, std::vector<File*> > MapGroupMap;
+  MapGroupMap map_groups_;
+  int foreground_fetches_;
+  int idle_fetches_;
 
   static FileManager* file_manager_instance_;
+  // Updated atomically, without lock_.
+  static volatile int32_t lock_wait_;
   typedef LockedPtr<FileManager> FileManagerPtr;
   static FileManagerPtr instance();
  public:
@@ -238,14 +440,26 @@ class FileManager {
   // preallocate the buffer (i.e., vector.reserve()).  For large files, this
   // can save time, but it is not required.
   static void Fetch(const std::string& file_name, size_t size = 1024u);
+  // Register every file in |manifest|, and start fetching the startup ones.
+  static void LoadManifest(const ManifestEntry* manifest);
   // Open a file some time after startup; the file will be created if it does
   // not exist in the local file system.
   static void OpenNewFile(const std::string& file_name);
   static bool HasFD(int fd);
   static int GetFD(const std::string& file_name, bool create);
   static void Close(int fd);
+  // Called by a File when a reader is blocked on bytes [start, end); moves
+  // the missing chunks to the front of the download queue.  Must not be
+  // called with file->lock held.
+  static void DemandRange(File* file, size_t start, size_t end);
   static void Dump(const std::string& file_name);
   static FileHandle* GetFileHandle(int fd);
+  // Adds to the time file readers and writers spent blocked on a File's lock
+  // or on lock_.
+  static void AddLockWait(int32_t microseconds);
+  // Returns the lock wait time accumulated since the last call, in
+  // microseconds.  Meant to be reported from the progress callbacks.
+  static int32_t TakeLockWait();
   static void set_ready_func(std::tr1::function<void()> func) {
     instance()->ready_func_ = func;
   }
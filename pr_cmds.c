@@ -32,9 +32,13 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 char *PF_VarString (int	first)
 {
-	int		i;
-	static char out[256];
+	int		i, len;
+	char	*out;
 	
+	len = 1;
+	for (i=first ; i<pr_argc ; i++)
+		len += strlen (G_STRING((OFS_PARM0+i*3)));
+	out = Frame_Alloc (len);
 	out[0] = 0;
 	for (i=first ; i<pr_argc ; i++)
 	{
@@ -252,6 +256,7 @@ void PF_setmodel (void)
 
 	e->v.model = m - pr_strings;
 	e->v.modelindex = i; //SV_ModelIndex (m);
+	SV_HotDirty (e);
 
 	mod = sv.models[ (int)e->v.modelindex];  // Mod_ForName (m, true);
 	
@@ -920,12 +925,16 @@ void PF_dprint (void)
 	Con_DPrintf ("%s",PF_VarString(0));
 }
 
-char	pr_string_temp[128];
+// each temp string gets its own frame memory, so strcat(ftos(a), ftos(b))
+// style code sees both
+#define	PR_STRING_TEMP	128
 
 void PF_ftos (void)
 {
 	float	v;
+	char	*pr_string_temp;
 	v = G_FLOAT(OFS_PARM0);
+	pr_string_temp = Frame_Alloc (PR_STRING_TEMP);
 	
 	if (v == (int)v)
 		sprintf (pr_string_temp, "%d",(int)v);
@@ -943,6 +952,9 @@ void PF_fabs (void)
 
 void PF_vtos (void)
 {
+	char	*pr_string_temp;
+
+	pr_string_temp = Frame_Alloc (PR_STRING_TEMP);
 	sprintf (pr_string_temp, "'%5.1f %5.1f %5.1f'", G_VECTOR(OFS_PARM0)[0], G_VECTOR(OFS_PARM0)[1], G_VECTOR(OFS_PARM0)[2]);
 	G_INT(OFS_RETURN) = pr_string_temp - pr_strings;
 }
@@ -950,6 +962,9 @@ void PF_vtos (void)
 #ifdef QUAKE2
 void PF_etos (void)
 {
+	char	*pr_string_temp;
+
+	pr_string_temp = Frame_Alloc (PR_STRING_TEMP);
 	sprintf (pr_string_temp, "entity %i", G_EDICTNUM(OFS_PARM0));
 	G_INT(OFS_RETURN) = pr_string_temp - pr_strings;
 }
@@ -1081,6 +1096,8 @@ void PF_precache_sound (void)
 		if (!sv.sound_precache[i])
 		{
 			sv.sound_precache[i] = s;
+		// a local client will load it, start reading it now
+			S_PrefetchSound (s);
 			return;
 		}
 		if (!strcmp(sv.sound_precache[i], s))
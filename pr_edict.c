@@ -31,6 +31,9 @@ globalvars_t	*pr_global_struct;
 float			*pr_globals;			// same as pr_global_struct
 int				pr_edict_size;	// in bytes
 
+byte			*ed_memory;		// EDICT_RESERVE bytes of address space
+int				ed_used;		// bytes of it the last server touched
+
 unsigned short		pr_crc;
 
 int		type_size[8] = {1,sizeof(string_t)/4,1,3,1,1,sizeof(func_t)/4,sizeof(void *)/4};
@@ -71,6 +74,94 @@ void ED_ClearEdict (edict_t *e)
 {
 	memset (&e->v, 0, progs->entityfields * 4);
 	e->free = false;
+	SV_HotDirty (e);
+}
+
+/*
+=================
+ED_InitMemory
+
+Points sv.edicts at the reserved space, with room for the clients, once the
+progs have set the edict size
+=================
+*/
+void ED_InitMemory (void)
+{
+	if (!ed_memory)
+		ed_memory = Hunk_Reserve (EDICT_RESERVE, "edicts");
+
+	sv.edicts = (edict_t *)ed_memory;
+	sv.edict_limit = EDICT_RESERVE / pr_edict_size;
+	if (sv.edict_limit > MAX_EDICTS)
+		sv.edict_limit = MAX_EDICTS;
+	sv.max_edicts = 0;
+	sv.freehead = sv.freetail = 0;
+	ED_Grow (svs.maxclients+1);
+}
+
+/*
+=================
+ED_ClearMemory
+
+Clears the last server's edicts and gives their pages back
+=================
+*/
+void ED_ClearMemory (void)
+{
+	if (!ed_used)
+		return;
+	Hunk_Release (ed_memory, ed_used);
+	ed_used = 0;
+}
+
+/*
+=================
+ED_Grow
+
+Makes edicts up to count usable, a chunk at a time.  They are in place in
+the reserved space, so edict pointers and progs offsets don't change, and
+already clear.
+=================
+*/
+void ED_Grow (int count)
+{
+	if (count <= sv.max_edicts)
+		return;
+	if (count > sv.edict_limit)
+		Sys_Error ("ED_Alloc: no free edicts (%i max)", sv.edict_limit);
+
+	sv.max_edicts = (count + EDICT_CHUNK - 1) / EDICT_CHUNK * EDICT_CHUNK;
+	if (sv.max_edicts > sv.edict_limit)
+		sv.max_edicts = sv.edict_limit;
+	if (sv.max_edicts * pr_edict_size > ed_used)
+		ed_used = sv.max_edicts * pr_edict_size;
+}
+
+/*
+=================
+ED_ResetFreeList
+
+Queues every free edict, for after a savegame has filled them in directly
+=================
+*/
+void ED_ResetFreeList (void)
+{
+	int			i;
+	edict_t		*e;
+
+	sv.freehead = sv.freetail = 0;
+	for (i=svs.maxclients+1 ; i<sv.num_edicts ; i++)
+	{
+		e = EDICT_NUM(i);
+		if (!e->free)
+			continue;
+		e->freenext = 0;
+		if (sv.freetail)
+			EDICT_NUM(sv.freetail)->freenext = i;
+		else
+			sv.freehead = i;
+		sv.freetail = i;
+	}
 }
 
 /*
@@ -82,30 +173,41 @@ Try to avoid reusing an entity that was recently freed, because it
 can cause the client to think the entity morphed into something else
 instead of being removed and recreated, which can cause interpolated
 angles and bad trails.
+
+Freed edicts are queued in the order they were freed, so if the oldest
+can't be reused yet none of them can, and a new one is used instead.
 =================
 */
 edict_t *ED_Alloc (void)
 {
-	int			i;
 	edict_t		*e;
 
-	for ( i=svs.maxclients+1 ; i<sv.num_edicts ; i++)
+	while (sv.freehead)
 	{
-		e = EDICT_NUM(i);
+		e = EDICT_NUM(sv.freehead);
+		if (!e->free)
+		{	// brought back some other way, like a savegame
+			sv.freehead = e->freenext;
+			continue;
+		}
 		// the first couple seconds of server time can involve a lot of
 		// freeing and allocating, so relax the replacement policy
-		if (e->free && ( e->freetime < 2 || sv.time - e->freetime > 0.5 ) )
+		if ( e->freetime < 2 || sv.time - e->freetime > 0.5 )
 		{
+			sv.freehead = e->freenext;
+			if (!sv.freehead)
+				sv.freetail = 0;
 			ED_ClearEdict (e);
 			return e;
 		}
+		break;
 	}
-	
-	if (i == MAX_EDICTS)
-		Sys_Error ("ED_Alloc: no free edicts");
-		
+	if (!sv.freehead)
+		sv.freetail = 0;
+
+	ED_Grow (sv.num_edicts+1);
+	e = EDICT_NUM(sv.num_edicts);
 	sv.num_edicts++;
-	e = EDICT_NUM(i);
 	ED_ClearEdict (e);
 
 	return e;
@@ -121,8 +223,22 @@ FIXME: walk all entities and NULL out references to this entity
 */
 void ED_Free (edict_t *ed)
 {
+	int		num;
+
 	SV_UnlinkEdict (ed);		// unlink from world bsp
 
+// queue it for ED_Alloc, unless it already is or it is the world or a client
+	num = NUM_FOR_EDICT(ed);
+	if (!ed->free && num > svs.maxclients)
+	{
+		ed->freenext = 0;
+		if (sv.freetail)
+			EDICT_NUM(sv.freetail)->freenext = num;
+		else
+			sv.freehead = num;
+		sv.freetail = num;
+	}
+
 	ed->free = true;
 	ed->v.model = 0;
 	ed->v.takedamage = 0;
@@ -136,6 +252,7 @@ void ED_Free (edict_t *ed)
 	ed->v.solid = 0;
 	
 	ed->freetime = sv.time;
+	SV_HotDirty (ed);
 }
 
 //===========================================================================
@@ -880,8 +997,12 @@ sprintf (com_token, "0 %s 0", temp);
 			Host_Error ("ED_ParseEdict: parse error");
 	}
 
+// an empty entity goes on the free list like any other, so its number
+// gets reused
 	if (!init)
-		ent->free = true;
+		ED_Free (ent);
+	else
+		SV_HotDirty (ent);
 
 	return data;
 }
@@ -566,6 +566,7 @@ while (1)
 		if (ed == (edict_t *)sv.edicts && sv.state == ss_active)
 			PR_RunError ("assignment to world entity");
 		c->_int = (byte *)((int *)&ed->v + b->_int) - (byte *)sv.edicts;
+		sv_hot.dirty[a->edict / pr_edict_size] = 1;	// about to be stored to
 		break;
 		
 	case OP_LOAD_F:
@@ -658,6 +659,7 @@ while (1)
 			ed->v.frame = a->_float;
 		}
 		ed->v.think = b->function;
+		sv_hot.dirty[pr_global_struct->self / pr_edict_size] = 1;
 		break;
 		
 	default:
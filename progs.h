@@ -43,6 +43,7 @@ typedef struct edict_s
 	entity_state_t	baseline;
 	
 	float		freetime;			// sv.time when the object was freed
+	int			freenext;			// next on sv.freehead, 0 for the last
 	entvars_t	v;					// C exported fields from progs
 // other fields from progs come immediately after
 } edict_t;
@@ -72,6 +73,10 @@ void PR_Profile_f (void);
 
 edict_t *ED_Alloc (void);
 void ED_Free (edict_t *ed);
+void ED_Grow (int count);
+void ED_ResetFreeList (void);
+void ED_InitMemory (void);
+void ED_ClearMemory (void);
 
 char	*ED_NewString (char *string);
 // returns a copy of the string allocated from the server's string heap
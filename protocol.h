@@ -20,6 +20,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 // protocol.h -- communications protocols
 
 #define	PROTOCOL_VERSION	15
+#define	PROTOCOL_LARGEENTITY	16	// 15 plus SND_LARGEENTITY, see sv_protocol
 
 // if the high bit of the servercmd is set, the low bits are fast update flags:
 #define	U_MOREBITS	(1<<0)
@@ -61,6 +62,9 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #define	SND_VOLUME		(1<<0)		// a byte
 #define	SND_ATTENUATION	(1<<1)		// a byte
 #define	SND_LOOPING		(1<<2)		// a long
+#define	SND_LARGEENTITY	(1<<3)		// entity is a short and channel a byte,
+									// only sent for entities past 4095, and
+									// only in PROTOCOL_LARGEENTITY
 
 
 // defaults for clientinfo messages
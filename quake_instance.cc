@@ -93,6 +93,7 @@ void QuakeInstance::BytesWereRead(int32_t bytes) {
   if (bytes_since_last_progress_ >= kBytesPerProgressUpdate) {
     PostMessage(bytes_since_last_progress_);
     bytes_since_last_progress_ = 0;
+    ReportLockWait();
   }
 }
 
@@ -100,6 +101,17 @@ void QuakeInstance::BytesWereWritten(int32_t bytes) {
   static int32_t total_bytes_written = 0;
   total_bytes_written += bytes;
   PRINTF("TOTAL BYTES WRITTEN: %"NACL_PRId32"\n", total_bytes_written);
+  ReportLockWait();
+}
+
+void QuakeInstance::ReportLockWait() {
+  static int32_t total_lock_wait = 0;
+  int32_t lock_wait = nacl_file::FileManager::TakeLockWait();
+  if (!lock_wait)
+    return;
+  total_lock_wait += lock_wait;
+  printf("File lock wait: %"NACL_PRId32" us (%"NACL_PRId32" us total)\n",
+         lock_wait, total_lock_wait);
 }
 
 bool QuakeInstance::Init(uint32_t argc, const char* argn[], const char* argv[]) {
@@ -117,12 +129,8 @@ bool QuakeInstance::Init(uint32_t argc, const char* argn[], const char* argv[])
   FileManager::Fetch("id1/config.cfg", 1724u);
   FileManager::Fetch("id1/pak0.pak", 18689235u);
 #else 
-#include "file_list.h"
-  size_t i = 0;
-  while (file_list[i]) {
-    FileManager::Fetch(file_list[i]);
-    ++i;
-  }
+#include "file_manifest.h"
+  FileManager::LoadManifest(file_manifest);
 #endif 
   // Launch the quake 'main' thread.
   pthread_create(&quake_main_thread_, NULL, LaunchQuake, this);
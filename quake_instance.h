@@ -41,6 +41,9 @@ class QuakeInstance : public pp::Instance {
   // bytes from a file.
   void BytesWereRead(int32_t bytes);
   void BytesWereWritten(int32_t bytes);
+  // Prints how long file reads and writes have spent waiting on file locks
+  // since the last report.
+  void ReportLockWait();
 
   int width() const {
     return width_;
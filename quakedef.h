@@ -92,12 +92,19 @@ void	VID_UnlockBuffer (void);
 #define UNALIGNED_OK	0
 #endif
 
+// platforms where the engine runs work on pthreads: background file loads,
+// worker threads, and the locks for data the sound callback shares
+#if defined(__linux__) || defined(__native_client__)
+#define USE_PTHREADS
+#endif
+
 // !!! if this is changed, it must be changed in d_ifacea.h too !!!
 #define CACHE_SIZE	32		// used to align key data structures
 
 #define UNUSED(x)	(x = x)	// for pesky compiler / lint warnings
 
 #define	MINIMUM_MEMORY			0x550000
+#define	HUNK_RESERVE			(256*1024*1024)	// when Sys_HunkReserve works
 #define	MINIMUM_MEMORY_LEVELPAK	(MINIMUM_MEMORY + 0x100000)
 
 #define MAX_NUM_ARGVS	50
@@ -123,7 +130,9 @@ void	VID_UnlockBuffer (void);
 //
 // per-level limits
 //
-#define	MAX_EDICTS		600			// FIXME: ouch! ouch! ouch!
+#define	MAX_EDICTS		8192		// entity numbers are sent as shorts
+#define	EDICT_CHUNK		256			// sv.max_edicts grows this many at a time
+#define	EDICT_RESERVE	(MAX_EDICTS*1024)	// bytes of address space for them
 #define	MAX_LIGHTSTYLES	64
 #define	MAX_MODELS		256			// these are sent over the net as bytes
 #define	MAX_SOUNDS		256			// so they cannot be blindly increased
@@ -256,9 +256,9 @@ void R_StoreEfrags (efrag_t **ppefrag)
 			pent = pefrag->entity;
 
 			if ((pent->visframe != r_framecount) &&
-				(cl_numvisedicts < MAX_VISEDICTS))
+				(r_frame.numvisedicts < MAX_VISEDICTS))
 			{
-				cl_visedicts[cl_numvisedicts++] = pent;
+				r_frame.visedicts[r_frame.numvisedicts++] = pent;
 
 			// mark that we've recorded this entity for this frame
 				pent->visframe = r_framecount;
@@ -37,16 +37,16 @@ void R_AnimateLight (void)
 //
 // light animations
 // 'm' is normal light, 'a' is no light, 'z' is double bright
-	i = (int)(cl.time*10);
+	i = (int)(r_frame.time*10);
 	for (j=0 ; j<MAX_LIGHTSTYLES ; j++)
 	{
-		if (!cl_lightstyle[j].length)
+		if (!r_frame.lightstyles[j].length)
 		{
 			d_lightstylevalue[j] = 256;
 			continue;
 		}
-		k = i % cl_lightstyle[j].length;
-		k = cl_lightstyle[j].map[k] - 'a';
+		k = i % r_frame.lightstyles[j].length;
+		k = r_frame.lightstyles[j].map[k] - 'a';
 		k = k*22;
 		d_lightstylevalue[j] = k;
 	}	
@@ -119,11 +119,11 @@ void R_PushDlights (void)
 
 	r_dlightframecount = r_framecount + 1;	// because the count hasn't
 											//  advanced yet for this frame
-	l = cl_dlights;
+	l = r_frame.dlights;
 
 	for (i=0 ; i<MAX_DLIGHTS ; i++, l++)
 	{
-		if (l->die < cl.time || !l->radius)
+		if (l->die < r_frame.time || !l->radius)
 			continue;
 		R_MarkLights ( l, 1<<i, cl.worldmodel->nodes );
 	}
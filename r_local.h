@@ -66,6 +66,12 @@ extern cvar_t	r_dspeeds;
 extern cvar_t	r_drawflat;
 extern cvar_t	r_ambient;
 extern cvar_t	r_reportsurfout;
+extern cvar_t	r_reportsurfcache;
+extern cvar_t	r_dynres;
+extern cvar_t	r_dynrestarget;
+extern cvar_t	r_dynresmin;
+extern cvar_t	r_dynresfilter;
+extern cvar_t	r_dynresstats;
 extern cvar_t	r_maxsurfs;
 extern cvar_t	r_numsurfs;
 extern cvar_t	r_reportedgeout;
@@ -140,14 +146,20 @@ void R_DrawSurfaceBlock16 (void);
 void R_DrawSurfaceBlock8 (void);
 texture_t *R_TextureAnimation (texture_t *base);
 
-#if	id386
-
 void R_DrawSurfaceBlock8_mip0 (void);
 void R_DrawSurfaceBlock8_mip1 (void);
 void R_DrawSurfaceBlock8_mip2 (void);
 void R_DrawSurfaceBlock8_mip3 (void);
 
-#endif
+// R_DrawSurface's surface and the block drawers' inputs it sets up
+extern D_THREADLOCAL drawsurf_t		r_drawsurf;
+extern D_THREADLOCAL int			sourcetstep, surfrowbytes;
+extern D_THREADLOCAL int			r_lightwidth, r_numvblocks, r_stepback;
+extern D_THREADLOCAL unsigned		*r_lightptr;
+extern D_THREADLOCAL void			*prowdestbase;
+extern D_THREADLOCAL unsigned char	*pbasesource, *r_sourcemax;
+
+extern void	(*surfmiptable[4])(void);	// picked by D_SelectDrawers
 
 void R_GenSkyTile (void *pdest);
 void R_GenSkyTile16 (void *pdest);
@@ -189,8 +201,8 @@ extern int		*pfrustum_indexes[4];
 extern int			ubasestep, errorterm, erroradjustup, erroradjustdown;
 extern int			vstartscan;
 
-extern fixed16_t	sadjust, tadjust;
-extern fixed16_t	bbextents, bbextentt;
+extern D_THREADLOCAL fixed16_t	sadjust, tadjust;
+extern D_THREADLOCAL fixed16_t	bbextents, bbextentt;
 
 #define MAXBVERTINDEXES	1000	// new clipped vertices when clipping bmodels
 								//  to the world BSP
@@ -289,6 +301,8 @@ extern int		r_maxsurfsseen, r_maxedgesseen, r_cnumsurfs;
 extern qboolean	r_surfsonstack;
 extern cshift_t	cshift_water;
 extern qboolean	r_dowarpold, r_viewchanged;
+extern float	r_dynscale;
+extern double	r_viewtime;
 
 extern mleaf_t	*r_viewleaf, *r_oldviewleaf;
 
@@ -313,5 +327,32 @@ void R_ClipEdge (mvertex_t *pv0, mvertex_t *pv1, clipplane_t *clip);
 void R_SplitEntityOnNode2 (mnode_t *node);
 void R_MarkLights (dlight_t *light, int bit, mnode_t *node);
 
+//=========================================================
+// render thread
+
+// the client state a view is drawn from, copied by R_SnapshotView so the
+// client can run the next frame while the render thread draws this one
+typedef struct
+{
+	double			time, oldtime;
+	int				items, health;
+	entity_t		viewent;
+	entity_t		*player;			// the view entity's copy, not drawn
+	int				numvisedicts;
+	entity_t		*visedicts[MAX_VISEDICTS];
+	entity_t		entities[MAX_VISEDICTS];	// copies of cl_visedicts
+	dlight_t		dlights[MAX_DLIGHTS];
+	lightstyle_t	lightstyles[MAX_LIGHTSTYLES];
+	int				numparticles;
+	particle_t		*particles;			// r_numparticles of them
+} renderframe_t;
+
+extern renderframe_t	r_frame;
+
+void R_InitPipeline (void);
+void R_SnapshotParticles (void);
+void R_RenderView_ (void);
+qboolean R_OnRenderThread (void);
+
 #endif
 
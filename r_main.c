@@ -39,6 +39,9 @@ int			r_outofsurfaces;
 int			r_outofedges;
 
 qboolean	r_dowarp, r_dowarpold, r_viewchanged;
+qboolean	r_dodynres;
+float		r_dynscale = 1;
+double		r_viewtime;				// seconds in R_RenderView_ last frame
 
 int			numbtofpolys;
 btofpoly_t	*pbtofpolys;
@@ -50,6 +53,7 @@ qboolean	r_surfsonstack;
 int			r_clipflags;
 
 byte		*r_warpbuffer;
+byte		*r_dynresbuffer;
 
 byte		*r_stack_start;
 
@@ -129,6 +133,12 @@ cvar_t	r_dspeeds = {"r_dspeeds","0"};
 cvar_t	r_drawflat = {"r_drawflat", "0"};
 cvar_t	r_ambient = {"r_ambient", "0"};
 cvar_t	r_reportsurfout = {"r_reportsurfout", "0"};
+cvar_t	r_reportsurfcache = {"r_reportsurfcache", "0"};
+cvar_t	r_dynres = {"r_dynres", "0"};
+cvar_t	r_dynrestarget = {"r_dynrestarget", "16.6"};	// ms per frame
+cvar_t	r_dynresmin = {"r_dynresmin", "0.5"};
+cvar_t	r_dynresfilter = {"r_dynresfilter", "0"};	// 0 = nearest, 1 = blended
+cvar_t	r_dynresstats = {"r_dynresstats", "0"};
 cvar_t	r_maxsurfs = {"r_maxsurfs", "0"};
 cvar_t	r_numsurfs = {"r_numsurfs", "0"};
 cvar_t	r_reportedgeout = {"r_reportedgeout", "0"};
@@ -206,6 +216,12 @@ void R_Init (void)
 	Cvar_RegisterVariable (&r_aliasstats);
 	Cvar_RegisterVariable (&r_dspeeds);
 	Cvar_RegisterVariable (&r_reportsurfout);
+	Cvar_RegisterVariable (&r_reportsurfcache);
+	Cvar_RegisterVariable (&r_dynres);
+	Cvar_RegisterVariable (&r_dynrestarget);
+	Cvar_RegisterVariable (&r_dynresmin);
+	Cvar_RegisterVariable (&r_dynresfilter);
+	Cvar_RegisterVariable (&r_dynresstats);
 	Cvar_RegisterVariable (&r_maxsurfs);
 	Cvar_RegisterVariable (&r_numsurfs);
 	Cvar_RegisterVariable (&r_reportedgeout);
@@ -228,6 +244,7 @@ void R_Init (void)
 	r_refdef.yOrigin = YCENTERING;
 
 	R_InitParticles ();
+	R_InitPipeline ();
 
 // TODO: collect 386-specific code in one place
 #if	id386
@@ -537,11 +554,11 @@ void R_DrawEntitiesOnList (void)
 	if (!r_drawentities.value)
 		return;
 
-	for (i=0 ; i<cl_numvisedicts ; i++)
+	for (i=0 ; i<r_frame.numvisedicts ; i++)
 	{
-		currententity = cl_visedicts[i];
+		currententity = r_frame.visedicts[i];
 
-		if (currententity == &cl_entities[cl.viewentity])
+		if (currententity == r_frame.player)
 			continue;	// don't draw the player
 
 		switch (currententity->model->type)
@@ -569,12 +586,12 @@ void R_DrawEntitiesOnList (void)
 
 				for (lnum=0 ; lnum<MAX_DLIGHTS ; lnum++)
 				{
-					if (cl_dlights[lnum].die >= cl.time)
+					if (r_frame.dlights[lnum].die >= r_frame.time)
 					{
 						VectorSubtract (currententity->origin,
-										cl_dlights[lnum].origin,
+										r_frame.dlights[lnum].origin,
 										dist);
-						add = cl_dlights[lnum].radius - Length(dist);
+						add = r_frame.dlights[lnum].radius - Length(dist);
 	
 						if (add > 0)
 							lighting.ambientlight += add;
@@ -616,13 +633,13 @@ void R_DrawViewModel (void)
 	if (!r_drawviewmodel.value || r_fov_greater_than_90)
 		return;
 
-	if (cl.items & IT_INVISIBILITY)
+	if (r_frame.items & IT_INVISIBILITY)
 		return;
 
-	if (cl.stats[STAT_HEALTH] <= 0)
+	if (r_frame.health <= 0)
 		return;
 
-	currententity = &cl.viewent;
+	currententity = &r_frame.viewent;
 	if (!currententity->model)
 		return;
 
@@ -642,12 +659,12 @@ void R_DrawViewModel (void)
 // add dynamic lights		
 	for (lnum=0 ; lnum<MAX_DLIGHTS ; lnum++)
 	{
-		dl = &cl_dlights[lnum];
+		dl = &r_frame.dlights[lnum];
 		if (!dl->radius)
 			continue;
 		if (!dl->radius)
 			continue;
-		if (dl->die < cl.time)
+		if (dl->die < r_frame.time)
 			continue;
 
 		VectorSubtract (currententity->origin, dl->origin, dist);
@@ -755,9 +772,9 @@ void R_DrawBEntitiesOnList (void)
 	insubmodel = true;
 	r_dlightframecount = r_framecount;
 
-	for (i=0 ; i<cl_numvisedicts ; i++)
+	for (i=0 ; i<r_frame.numvisedicts ; i++)
 	{
-		currententity = cl_visedicts[i];
+		currententity = r_frame.visedicts[i];
 
 		switch (currententity->model->type)
 		{
@@ -795,13 +812,13 @@ void R_DrawBEntitiesOnList (void)
 				{
 					for (k=0 ; k<MAX_DLIGHTS ; k++)
 					{
-						if ((cl_dlights[k].die < cl.time) ||
-							(!cl_dlights[k].radius))
+						if ((r_frame.dlights[k].die < r_frame.time) ||
+							(!r_frame.dlights[k].radius))
 						{
 							continue;
 						}
 
-						R_MarkLights (&cl_dlights[k], 1<<k,
+						R_MarkLights (&r_frame.dlights[k], 1<<k,
 							clmodel->nodes + clmodel->hulls[0].firstclipnode);
 					}
 				}
@@ -931,7 +948,7 @@ void R_EdgeDrawing (void)
 		se_time1 = db_time2;
 	}
 
-	if (!r_dspeeds.value)
+	if (!r_dspeeds.value && !R_OnRenderThread ())
 	{
 		VID_UnlockBuffer ();
 		S_ExtraUpdate ();	// don't let sound get messed up if going slow
@@ -953,9 +970,12 @@ r_refdef must be set before the first call
 void R_RenderView_ (void)
 {
 	byte	warpbuffer[WARP_WIDTH * WARP_HEIGHT];
+	double	viewtime;
 
 	r_warpbuffer = warpbuffer;
 
+	viewtime = Sys_FloatTime ();
+
 	if (r_timegraph.value || r_speeds.value || r_dspeeds.value)
 		r_time1 = Sys_FloatTime ();
 
@@ -976,7 +996,7 @@ SetVisibilityByPassages ();
 	if (!cl_entities[0].model || !cl.worldmodel)
 		Sys_Error ("R_RenderView: NULL worldmodel");
 		
-	if (!r_dspeeds.value)
+	if (!r_dspeeds.value && !R_OnRenderThread ())
 	{
 		VID_UnlockBuffer ();
 		S_ExtraUpdate ();	// don't let sound get messed up if going slow
@@ -985,7 +1005,7 @@ SetVisibilityByPassages ();
 	
 	R_EdgeDrawing ();
 
-	if (!r_dspeeds.value)
+	if (!r_dspeeds.value && !R_OnRenderThread ())
 	{
 		VID_UnlockBuffer ();
 		S_ExtraUpdate ();	// don't let sound get messed up if going slow
@@ -1021,8 +1041,8 @@ SetVisibilityByPassages ();
 
 	if (r_dowarp)
 		D_WarpScreen ();
-
-	V_SetContentsColor (r_viewleaf->contents);
+	else if (r_dodynres)
+		D_ScaleScreen ();
 
 	if (r_timegraph.value)
 		R_TimeGraph ();
@@ -1039,9 +1059,15 @@ SetVisibilityByPassages ();
 	if (r_reportsurfout.value && r_outofsurfaces)
 		Con_Printf ("Short %d surfaces\n", r_outofsurfaces);
 
+	if (r_reportsurfcache.value && d_surfmisses)
+		Con_Printf ("%3i cache misses (%i deferred) %5.2f ms building\n",
+					d_surfmisses, d_surfdeferred, d_surfbuildtime * 1000);
+
 	if (r_reportedgeout.value && r_outofedges)
 		Con_Printf ("Short roughly %d edges\n", r_outofedges * 2 / 3);
 
+	r_viewtime = Sys_FloatTime () - viewtime;
+
 // back to high floating-point precision
 	Sys_HighFPPrecision ();
 }
@@ -73,6 +73,8 @@ void R_TimeRefresh_f (void)
 	int			startangle;
 	vrect_t		vr;
 
+	R_SyncView ();
+
 	startangle = r_refdef.viewangles[1];
 	
 	start = Sys_FloatTime ();
@@ -359,6 +361,94 @@ void R_SetUpFrustumIndexes (void)
 }
 
 
+/*
+===============
+R_SetDynamicScale
+
+With r_dynres set the view is drawn into r_dynresbuffer at r_dynscale of the
+screen size and D_ScaleScreen stretches it to the screen, under the status
+bar and console.  The frame time is taken as the view's time, which goes
+with the pixel count, plus everything else, which doesn't; the scale is set
+so that the next frame comes out at r_dynrestarget ms, eased in and rounded
+to 1/32 so the view isn't set up again every frame.
+===============
+*/
+#define DYNRES_STEP		(1.0/32)
+
+void R_SetDynamicScale (void)
+{
+	static double	lasttime;
+	static int		buffersize;
+	double			time, frametime, othertime, target;
+	float			scale, min;
+	qboolean		dynres;
+
+	time = Sys_FloatTime ();
+	frametime = time - lasttime;
+	lasttime = time;
+
+	dynres = r_dynres.value && !r_dowarp;	// the warp has its own buffer
+	if (dynres != r_dodynres)
+	{
+		r_dodynres = dynres;
+		r_dynscale = 1;
+		r_viewchanged = true;
+	}
+	if (!dynres)
+		return;
+
+	if (buffersize < vid.width * vid.height)
+	{
+		free (r_dynresbuffer);
+		buffersize = vid.width * vid.height;
+		r_dynresbuffer = malloc (buffersize);
+		if (!r_dynresbuffer)
+			Sys_Error ("R_SetDynamicScale: couldn't allocate %i bytes",
+					buffersize);
+	}
+
+	min = r_dynresmin.value;
+	if (min < 0.25)
+		min = 0.25;
+	if (min > 1)
+		min = 1;
+
+	scale = r_dynscale;
+	if (frametime > 0 && frametime < 0.25 && r_viewtime > 0)
+	{
+		target = r_dynrestarget.value / 1000;
+		othertime = frametime - r_viewtime;
+		if (othertime < 0)
+			othertime = 0;
+
+		if (target <= othertime)
+			scale = min;
+		else
+			scale = r_dynscale * sqrt ((target - othertime) / r_viewtime);
+
+		scale = r_dynscale + (scale - r_dynscale) * 0.25;
+		scale = (int)(scale / DYNRES_STEP + 0.5) * DYNRES_STEP;
+	}
+
+	if (scale < min)
+		scale = min;
+	if (scale > 1)
+		scale = 1;
+
+	if (scale != r_dynscale)
+	{
+		r_dynscale = scale;
+		r_viewchanged = true;
+	}
+
+	if (r_dynresstats.value)
+		Con_Printf ("%4.2f scale %ix%i %5.1f ms frame %5.1f ms view\n",
+					r_dynscale, (int)(vid.width * r_dynscale),
+					(int)(vid.height * r_dynscale), frametime * 1000,
+					r_viewtime * 1000);
+}
+
+
 /*
 ===============
 R_SetupFrame
@@ -370,15 +460,6 @@ void R_SetupFrame (void)
 	vrect_t			vrect;
 	float			w, h;
 
-// don't allow cheats in multiplayer
-	if (cl.maxclients > 1)
-	{
-		Cvar_Set ("r_draworder", "0");
-		Cvar_Set ("r_fullbright", "0");
-		Cvar_Set ("r_ambient", "0");
-		Cvar_Set ("r_drawflat", "0");
-	}
-
 	if (r_numsurfs.value)
 	{
 		if ((surface_p - surfaces) > r_maxsurfsseen)
@@ -438,6 +519,8 @@ r_refdef.viewangles[2]=    0;
 	r_dowarpold = r_dowarp;
 	r_dowarp = r_waterwarp.value && (r_viewleaf->contents <= CONTENTS_WATER);
 
+	R_SetDynamicScale ();
+
 	if ((r_dowarp != r_dowarpold) || r_viewchanged || lcd_x.value)
 	{
 		if (r_dowarp)
@@ -480,6 +563,21 @@ r_refdef.viewangles[2]=    0;
 								 ((float)vid.width / (float)vid.height));
 			}
 		}
+		else if (r_dodynres)
+		{
+			w = (int)(vid.width * r_dynscale) & ~3;
+			h = (int)(vid.height * r_dynscale);
+
+			vrect.x = 0;
+			vrect.y = 0;
+			vrect.width = (int)w;
+			vrect.height = (int)h;
+
+			R_ViewChanged (&vrect,
+						   (int)((float)sb_lines * (h/(float)vid.height)),
+						   vid.aspect * (h / w) *
+							 ((float)vid.width / (float)vid.height));
+		}
 		else
 		{
 			vrect.x = 0;
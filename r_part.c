@@ -62,6 +62,10 @@ void R_InitParticles (void)
 
 	particles = (particle_t *)
 			Hunk_AllocName (r_numparticles * sizeof(particle_t), "particles");
+#ifndef GLQUAKE
+	r_frame.particles = (particle_t *)
+			Hunk_AllocName (r_numparticles * sizeof(particle_t), "rparticles");
+#endif
 }
 
 #ifdef QUAKE2
@@ -639,48 +643,19 @@ void R_RocketTrail (vec3_t start, vec3_t end, int type)
 }
 
 
+extern	cvar_t	sv_gravity;
+
 /*
 ===============
-R_DrawParticles
+R_KillParticles
+
+Frees the particles that have died by cl.time
 ===============
 */
-extern	cvar_t	sv_gravity;
-
-void R_DrawParticles (void)
+void R_KillParticles (void)
 {
 	particle_t		*p, *kill;
-	float			grav;
-	int				i;
-	float			time2, time3;
-	float			time1;
-	float			dvel;
-	float			frametime;
-	
-#ifdef GLQUAKE
-	vec3_t			up, right;
-	float			scale;
 
-    GL_Bind(particletexture);
-	glEnable (GL_BLEND);
-	glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
-	glBegin (GL_TRIANGLES);
-
-	VectorScale (vup, 1.5, up);
-	VectorScale (vright, 1.5, right);
-#else
-	D_StartParticles ();
-
-	VectorScale (vright, xscaleshrink, r_pright);
-	VectorScale (vup, yscaleshrink, r_pup);
-	VectorCopy (vpn, r_ppn);
-#endif
-	frametime = cl.time - cl.oldtime;
-	time3 = frametime * 15;
-	time2 = frametime * 10; // 15;
-	time1 = frametime * 5;
-	grav = frametime * sv_gravity.value * 0.05;
-	dvel = 4*frametime;
-	
 	for ( ;; ) 
 	{
 		kill = active_particles;
@@ -708,25 +683,35 @@ void R_DrawParticles (void)
 			}
 			break;
 		}
+	}
+}
 
-#ifdef GLQUAKE
-		// hack a scale up to keep particles from disapearing
-		scale = (p->org[0] - r_origin[0])*vpn[0] + (p->org[1] - r_origin[1])*vpn[1]
-			+ (p->org[2] - r_origin[2])*vpn[2];
-		if (scale < 20)
-			scale = 1;
-		else
-			scale = 1 + scale * 0.004;
-		glColor3ubv ((byte *)&d_8to24table[(int)p->color]);
-		glTexCoord2f (0,0);
-		glVertex3fv (p->org);
-		glTexCoord2f (1,0);
-		glVertex3f (p->org[0] + up[0]*scale, p->org[1] + up[1]*scale, p->org[2] + up[2]*scale);
-		glTexCoord2f (0,1);
-		glVertex3f (p->org[0] + right[0]*scale, p->org[1] + right[1]*scale, p->org[2] + right[2]*scale);
-#else
-		D_DrawParticle (p);
-#endif
+/*
+===============
+R_MoveParticles
+
+Runs the particles on by the client's frame time
+===============
+*/
+void R_MoveParticles (void)
+{
+	particle_t		*p;
+	float			grav;
+	int				i;
+	float			time2, time3;
+	float			time1;
+	float			dvel;
+	float			frametime;
+
+	frametime = cl.time - cl.oldtime;
+	time3 = frametime * 15;
+	time2 = frametime * 10; // 15;
+	time1 = frametime * 5;
+	grav = frametime * sv_gravity.value * 0.05;
+	dvel = 4*frametime;
+	
+	for (p=active_particles ; p ; p=p->next)
+	{
 		p->org[0] += p->vel[0]*frametime;
 		p->org[1] += p->vel[1]*frametime;
 		p->org[2] += p->vel[2]*frametime;
@@ -788,12 +773,87 @@ void R_DrawParticles (void)
 			break;
 		}
 	}
+}
+
+#ifndef GLQUAKE
+/*
+===============
+R_SnapshotParticles
+
+Copies the live particles into r_frame for drawing, then moves them on
+===============
+*/
+void R_SnapshotParticles (void)
+{
+	particle_t		*p;
+
+	R_KillParticles ();
 
+	r_frame.numparticles = 0;
+	for (p=active_particles ; p ; p=p->next)
+		r_frame.particles[r_frame.numparticles++] = *p;
+
+	R_MoveParticles ();
+}
+#endif
+
+/*
+===============
+R_DrawParticles
+===============
+*/
+void R_DrawParticles (void)
+{
+	particle_t		*p;
 #ifdef GLQUAKE
+	vec3_t			up, right;
+	float			scale;
+
+    GL_Bind(particletexture);
+	glEnable (GL_BLEND);
+	glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+	glBegin (GL_TRIANGLES);
+
+	VectorScale (vup, 1.5, up);
+	VectorScale (vright, 1.5, right);
+
+	R_KillParticles ();
+
+	for (p=active_particles ; p ; p=p->next)
+	{
+		// hack a scale up to keep particles from disapearing
+		scale = (p->org[0] - r_origin[0])*vpn[0] + (p->org[1] - r_origin[1])*vpn[1]
+			+ (p->org[2] - r_origin[2])*vpn[2];
+		if (scale < 20)
+			scale = 1;
+		else
+			scale = 1 + scale * 0.004;
+		glColor3ubv ((byte *)&d_8to24table[(int)p->color]);
+		glTexCoord2f (0,0);
+		glVertex3fv (p->org);
+		glTexCoord2f (1,0);
+		glVertex3f (p->org[0] + up[0]*scale, p->org[1] + up[1]*scale, p->org[2] + up[2]*scale);
+		glTexCoord2f (0,1);
+		glVertex3f (p->org[0] + right[0]*scale, p->org[1] + right[1]*scale, p->org[2] + right[2]*scale);
+	}
+
 	glEnd ();
 	glDisable (GL_BLEND);
 	glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
+
+	R_MoveParticles ();
 #else
+	int				i;
+
+	D_StartParticles ();
+
+	VectorScale (vright, xscaleshrink, r_pright);
+	VectorScale (vup, yscaleshrink, r_pup);
+	VectorCopy (vpn, r_ppn);
+
+	for (i=0, p=r_frame.particles ; i<r_frame.numparticles ; i++, p++)
+		D_DrawParticle (p);
+
 	D_EndParticles ();
 #endif
 }
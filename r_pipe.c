@@ -0,0 +1,456 @@
+/*
+Copyright (C) 1996-1997 Id Software, Inc.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+// r_pipe.c -- the client state snapshot the 3D view is drawn from, and the
+// render thread that draws it while the next frame is simulated
+
+#include "quakedef.h"
+#include "r_local.h"
+
+// the render thread needs the vis buffer and the drawers' state to be per
+// thread, which they only are in C builds (D_THREADLOCAL)
+#if defined(USE_PTHREADS) && !id386
+#define	R_PIPELINE	1
+#include <pthread.h>
+#endif
+
+#define	RENDER_STACK	0x400000	// R_RenderView_ keeps the warp buffer
+									//  and the edge lists on the stack
+#define	MAX_DEFERRED	4000		// bytes of console text per view
+
+typedef struct
+{
+	int		frames;			// drawn on the render thread
+	int		inlined;		// drawn on the main thread
+	int		gamewaits;		// screen updates that found the view unfinished
+	int		syncs;			// forced waits to touch renderer state
+	double	gamewait, sync;	// seconds spent in them
+	double	render, idle;	// render thread seconds drawing and waiting
+} pipestats_t;
+
+cvar_t	r_pipeline = {"r_pipeline", "0"};	// draw the view on its own thread
+
+renderframe_t	r_frame;
+
+static pipestats_t	r_pipestats;
+
+static D_THREADLOCAL qboolean	r_onrenderthread;
+
+// Con_Printf text from the render thread, printed by the main thread once
+// the view is finished
+static char	r_deferred[MAX_DEFERRED];
+static int	r_deferredlen;
+static int	r_deferreddropped;	// messages that did not fit in r_deferred
+
+#ifdef R_PIPELINE
+static qboolean	r_threadstarted, r_threadfailed;
+static qboolean	r_viewready;		// snapshot taken, waiting for R_StartView
+static qboolean	r_viewbusy;			// handed to the render thread
+static double	r_viewdone;			// when the render thread last finished
+static int		r_viewframe;		// host_framecount of the last R_StartView
+
+// r_viewbusy, r_viewdone and r_pipestats.render are guarded by r_pipelock
+static pthread_mutex_t	r_pipelock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t	r_pipestart = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t	r_pipedone = PTHREAD_COND_INITIALIZER;
+#endif
+
+
+/*
+===============================================================================
+
+FRAME SNAPSHOT
+
+The renderer draws from r_frame instead of the client state: the entities,
+dynamic lights, light styles and particles of the frame, and the few cl
+fields it looks at.  R_SnapshotView copies them once V_RenderView has set
+up r_refdef, so the client can move on to the next frame while the copy is
+drawn.  r_refdef itself is not copied; only the screen update writes it,
+and that waits for the last view to finish first.
+
+===============================================================================
+*/
+
+/*
+===============
+R_SnapshotView
+===============
+*/
+void R_SnapshotView (void)
+{
+	int			i;
+	entity_t	*ent;
+	mleaf_t		*leaf;
+
+	R_FinishView ();	// the last view may still be drawing from r_frame
+
+// don't allow cheats in multiplayer
+	if (cl.maxclients > 1)
+	{
+		Cvar_Set ("r_draworder", "0");
+		Cvar_Set ("r_fullbright", "0");
+		Cvar_Set ("r_ambient", "0");
+		Cvar_Set ("r_drawflat", "0");
+	}
+
+	r_frame.time = cl.time;
+	r_frame.oldtime = cl.oldtime;
+	r_frame.items = cl.items;
+	r_frame.health = cl.stats[STAT_HEALTH];
+	r_frame.viewent = cl.viewent;
+
+	r_frame.player = NULL;
+	r_frame.numvisedicts = cl_numvisedicts;
+	for (i=0 ; i<cl_numvisedicts ; i++)
+	{
+		ent = &r_frame.entities[i];
+		*ent = *cl_visedicts[i];
+		r_frame.visedicts[i] = ent;
+		if (cl_visedicts[i] == &cl_entities[cl.viewentity])
+			r_frame.player = ent;
+	}
+
+	memcpy (r_frame.dlights, cl_dlights, sizeof(r_frame.dlights));
+	memcpy (r_frame.lightstyles, cl_lightstyle, sizeof(r_frame.lightstyles));
+
+	R_SnapshotParticles ();
+
+// alias models live in the cache, so load any that were thrown out here
+// rather than on the render thread; a use this frame pins them through the
+// next one
+	for (i=0 ; i<r_frame.numvisedicts ; i++)
+		if (r_frame.entities[i].model->type == mod_alias)
+			Mod_Extradata (r_frame.entities[i].model);
+	for (i=0 ; i<cl.num_statics ; i++)
+	{
+		ent = &cl_static_entities[i];
+		if (ent->model && ent->model->type == mod_alias)
+			Mod_Extradata (ent->model);
+	}
+	if (r_frame.viewent.model && r_frame.viewent.model->type == mod_alias)
+		Mod_Extradata (r_frame.viewent.model);
+
+// the contents blend goes with the view it was seen from
+	leaf = Mod_PointInLeaf (r_refdef.vieworg, cl.worldmodel);
+	V_SetContentsColor (leaf->contents);
+}
+
+
+/*
+===============================================================================
+
+RENDER THREAD
+
+With r_pipeline set, V_RenderView only takes the snapshot.  The screen
+update draws the HUD over the view finished during the frame, shows it, and
+then R_StartView hands the new snapshot to the render thread, which draws
+it into the video buffer while the next frame's input, server and client
+run.  The view on screen is one frame old.
+
+The next screen update waits for the view in R_FinishView.  Anything else
+that touches the renderer's state from the main thread, like clearing the
+memory for a new map or taking a screenshot, calls R_SyncView first.
+
+Without pthreads, or with r_pipeline 0, V_RenderView draws the snapshot
+right away, as before.
+
+===============================================================================
+*/
+
+#ifdef R_PIPELINE
+/*
+===============
+R_RenderThread
+===============
+*/
+static void *R_RenderThread (void *unused)
+{
+	double	start, done;
+
+	Frame_InitThread ("render");
+	r_onrenderthread = true;
+
+	pthread_mutex_lock (&r_pipelock);
+	while (1)
+	{
+		while (!r_viewbusy)
+			pthread_cond_wait (&r_pipestart, &r_pipelock);
+		pthread_mutex_unlock (&r_pipelock);
+
+		start = Sys_FloatTime ();
+
+	// R_RenderView's stack check is against the main thread's stack
+		R_PushDlights ();
+		R_RenderView_ ();
+		Frame_Reset ();
+
+		done = Sys_FloatTime ();
+
+		pthread_mutex_lock (&r_pipelock);
+		r_pipestats.render += done - start;
+		r_viewdone = done;
+		r_viewbusy = false;
+		pthread_cond_signal (&r_pipedone);
+	}
+	return NULL;
+}
+
+/*
+===============
+R_CanPipeline
+
+Starts the render thread the first time it is wanted
+===============
+*/
+static qboolean R_CanPipeline (void)
+{
+	pthread_attr_t	attr;
+	pthread_t		thread;
+
+	if (!r_pipeline.value || lcd_x.value || cls.signon != SIGNONS
+	|| r_threadfailed)
+		return false;
+	if (r_threadstarted)
+		return true;
+
+	pthread_attr_init (&attr);
+	pthread_attr_setstacksize (&attr, RENDER_STACK);
+	if (pthread_create (&thread, &attr, R_RenderThread, NULL))
+	{
+		Con_Printf ("couldn't start the render thread\n");
+		r_threadfailed = true;
+	}
+	else
+	{
+		pthread_detach (thread);
+		r_threadstarted = true;
+	}
+	pthread_attr_destroy (&attr);
+
+	return r_threadstarted;
+}
+
+/*
+===============
+R_WaitView
+
+Returns once the render thread is idle, adding any wait to count and time
+===============
+*/
+static void R_WaitView (int *count, double *time)
+{
+	double	start;
+
+	pthread_mutex_lock (&r_pipelock);
+	if (r_viewbusy)
+	{
+		start = Sys_FloatTime ();
+		while (r_viewbusy)
+			pthread_cond_wait (&r_pipedone, &r_pipelock);
+		(*count)++;
+		*time += Sys_FloatTime () - start;
+	}
+	pthread_mutex_unlock (&r_pipelock);
+}
+#endif
+
+/*
+===============
+R_FlushDeferred
+===============
+*/
+static void R_FlushDeferred (void)
+{
+	if (r_deferredlen)
+	{
+		r_deferredlen = 0;
+		Con_Printf ("%s", r_deferred);
+	}
+	if (r_deferreddropped)
+	{
+		Con_Printf ("(%i render thread messages dropped)\n", r_deferreddropped);
+		r_deferreddropped = 0;
+	}
+}
+
+/*
+===============
+R_SubmitView
+
+Snapshots the client state and draws it, or queues it for the render thread
+===============
+*/
+void R_SubmitView (void)
+{
+	R_SnapshotView ();
+
+#ifdef R_PIPELINE
+	if (R_CanPipeline ())
+	{
+		r_viewready = true;
+		return;
+	}
+#endif
+
+	R_PushDlights ();
+	R_RenderView ();
+	r_pipestats.inlined++;
+}
+
+/*
+===============
+R_StartView
+
+Hands a queued snapshot to the render thread.  Called once the screen has
+been updated, so the view can be drawn into the video buffer.
+===============
+*/
+void R_StartView (void)
+{
+#ifdef R_PIPELINE
+	if (!r_viewready)
+		return;
+	r_viewready = false;
+
+	pthread_mutex_lock (&r_pipelock);
+// the render thread sat idle since its last view if that was last frame's
+	if (r_viewframe == host_framecount - 1)
+		r_pipestats.idle += Sys_FloatTime () - r_viewdone;
+	r_viewframe = host_framecount;
+	r_viewbusy = true;
+	r_pipestats.frames++;
+	pthread_cond_signal (&r_pipestart);
+	pthread_mutex_unlock (&r_pipelock);
+#endif
+}
+
+/*
+===============
+R_FinishView
+
+Waits for the view the render thread is drawing, if any
+===============
+*/
+void R_FinishView (void)
+{
+#ifdef R_PIPELINE
+	R_WaitView (&r_pipestats.gamewaits, &r_pipestats.gamewait);
+	r_viewready = false;
+#endif
+	R_FlushDeferred ();
+}
+
+/*
+===============
+R_SyncView
+
+R_FinishView for callers outside the screen update, counted apart
+===============
+*/
+void R_SyncView (void)
+{
+	if (r_onrenderthread)
+		return;		// a Sys_Error while drawing
+
+#ifdef R_PIPELINE
+	R_WaitView (&r_pipestats.syncs, &r_pipestats.sync);
+#endif
+	R_FlushDeferred ();
+}
+
+/*
+===============
+R_OnRenderThread
+===============
+*/
+qboolean R_OnRenderThread (void)
+{
+	return r_onrenderthread;
+}
+
+/*
+===============
+R_DeferPrint
+
+Keeps a message printed on the render thread for the main thread, which
+owns the console.  Returns false on any other thread.
+===============
+*/
+qboolean R_DeferPrint (char *msg)
+{
+	int		len;
+
+	if (!r_onrenderthread)
+		return false;
+
+	len = Q_strlen (msg);
+	if (r_deferredlen + len < MAX_DEFERRED)
+	{
+		memcpy (r_deferred + r_deferredlen, msg, len + 1);
+		r_deferredlen += len;
+	}
+	else
+		r_deferreddropped++;
+	return true;
+}
+
+/*
+===============
+R_PipeStats_f
+
+pipestats [clear]
+===============
+*/
+static void R_PipeStats_f (void)
+{
+	pipestats_t	*s;
+
+	R_SyncView ();		// the render thread adds to r_pipestats.render
+
+	s = &r_pipestats;
+	if (Cmd_Argc () == 2 && !Q_strcmp (Cmd_Argv(1), "clear"))
+	{
+		memset (s, 0, sizeof(*s));
+		return;
+	}
+
+	Con_Printf ("%i views on the render thread, %i on the main thread\n",
+		s->frames, s->inlined);
+	if (s->frames)
+	{
+		Con_Printf ("game waited for render %i times (%.0f%%), %.2f ms average\n",
+			s->gamewaits, 100.0 * s->gamewaits / s->frames,
+			s->gamewaits ? s->gamewait * 1000 / s->gamewaits : 0);
+		Con_Printf ("render drew %.2f ms, waited for game %.2f ms per view\n",
+			s->render * 1000 / s->frames, s->idle * 1000 / s->frames);
+	}
+	if (s->syncs)
+		Con_Printf ("%i forced syncs, %.2f ms\n", s->syncs, s->sync * 1000);
+}
+
+/*
+===============
+R_InitPipeline
+===============
+*/
+void R_InitPipeline (void)
+{
+	Cvar_RegisterVariable (&r_pipeline);
+	Cmd_AddCommand ("pipestats", R_PipeStats_f);
+}
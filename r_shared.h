@@ -40,12 +40,21 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 										//  be farther away than anything in
 										//  the scene
 
+// the span drawers' state is per thread, so D_DrawSurfaces can hand
+// horizontal bands of the view to the job threads.  The assembly span
+// drawers use it as plain globals.
+#if defined(USE_PTHREADS) && !id386
+#define	D_THREADLOCAL	__thread
+#else
+#define	D_THREADLOCAL
+#endif
+
 //===================================================================
 
 extern void	R_DrawLine (polyvert_t *polyvert0, polyvert_t *polyvert1);
 
-extern int		cachewidth;
-extern pixel_t	*cacheblock;
+extern D_THREADLOCAL int		cachewidth;
+extern D_THREADLOCAL pixel_t	*cacheblock;
 extern int		screenwidth;
 
 extern	float	pixelAspect;
@@ -271,7 +271,7 @@ void R_SetSkyFrame (void)
 	s2 = iskyspeed2 / g;
 	temp = SKYSIZE * s1 * s2;
 
-	skytime = cl.time - ((int)(cl.time / temp) * temp);
+	skytime = r_frame.time - ((int)(r_frame.time / temp) * temp);
 	
 
 	r_skymade = 0;
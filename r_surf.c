@@ -22,27 +22,24 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #include "quakedef.h"
 #include "r_local.h"
 
-drawsurf_t	r_drawsurf;
-
-int				lightleft, sourcesstep, blocksize, sourcetstep;
-int				lightdelta, lightdeltastep;
-int				lightright, lightleftstep, lightrightstep, blockdivshift;
-unsigned		blockdivmask;
-void			*prowdestbase;
-unsigned char	*pbasesource;
-int				surfrowbytes;	// used by ASM files
-unsigned		*r_lightptr;
-int				r_stepback;
-int				r_lightwidth;
-int				r_numhblocks, r_numvblocks;
-unsigned char	*r_source, *r_sourcemax;
-
-void R_DrawSurfaceBlock8_mip0 (void);
-void R_DrawSurfaceBlock8_mip1 (void);
-void R_DrawSurfaceBlock8_mip2 (void);
-void R_DrawSurfaceBlock8_mip3 (void);
-
-static void	(*surfmiptable[4])(void) = {
+// R_DrawSurface's state is per thread, so D_RunSurfaceBuilds can build
+// several surfaces at once on the job threads
+D_THREADLOCAL drawsurf_t	r_drawsurf;
+
+D_THREADLOCAL int			lightleft, sourcesstep, blocksize, sourcetstep;
+D_THREADLOCAL int			lightdelta, lightdeltastep;
+D_THREADLOCAL int			lightright, lightleftstep, lightrightstep, blockdivshift;
+D_THREADLOCAL unsigned		blockdivmask;
+D_THREADLOCAL void			*prowdestbase;
+D_THREADLOCAL unsigned char	*pbasesource;
+D_THREADLOCAL int			surfrowbytes;	// used by ASM files
+D_THREADLOCAL unsigned		*r_lightptr;
+D_THREADLOCAL int			r_stepback;
+D_THREADLOCAL int			r_lightwidth;
+D_THREADLOCAL int			r_numhblocks, r_numvblocks;
+D_THREADLOCAL unsigned char	*r_source, *r_sourcemax;
+
+void	(*surfmiptable[4])(void) = {
 	R_DrawSurfaceBlock8_mip0,
 	R_DrawSurfaceBlock8_mip1,
 	R_DrawSurfaceBlock8_mip2,
@@ -51,7 +48,7 @@ static void	(*surfmiptable[4])(void) = {
 
 
 
-unsigned		blocklights[18*18];
+D_THREADLOCAL unsigned	blocklights[18*18];
 
 /*
 ===============
@@ -80,18 +77,18 @@ void R_AddDynamicLights (void)
 		if ( !(surf->dlightbits & (1<<lnum) ) )
 			continue;		// not lit by this light
 
-		rad = cl_dlights[lnum].radius;
-		dist = DotProduct (cl_dlights[lnum].origin, surf->plane->normal) -
+		rad = r_frame.dlights[lnum].radius;
+		dist = DotProduct (r_frame.dlights[lnum].origin, surf->plane->normal) -
 				surf->plane->dist;
 		rad -= fabs(dist);
-		minlight = cl_dlights[lnum].minlight;
+		minlight = r_frame.dlights[lnum].minlight;
 		if (rad < minlight)
 			continue;
 		minlight = rad - minlight;
 
 		for (i=0 ; i<3 ; i++)
 		{
-			impact[i] = cl_dlights[lnum].origin[i] -
+			impact[i] = r_frame.dlights[lnum].origin[i] -
 					surf->plane->normal[i]*dist;
 		}
 
@@ -121,7 +118,7 @@ void R_AddDynamicLights (void)
 					unsigned temp;
 					temp = (rad - dist)*256;
 					i = t*smax + s;
-					if (!cl_dlights[lnum].dark)
+					if (!r_frame.dlights[lnum].dark)
 						blocklights[i] += temp;
 					else
 					{
@@ -224,7 +221,7 @@ texture_t *R_TextureAnimation (texture_t *base)
 	if (!base->anim_total)
 		return base;
 
-	reletive = (int)(cl.time*10) % base->anim_total;
+	reletive = (int)(r_frame.time*10) % base->anim_total;
 
 	count = 0;	
 	while (base->anim_min > reletive || base->anim_max <= reletive)
@@ -598,7 +595,7 @@ void R_GenTurbTile (pixel_t *pbasetex, void *pdest)
 	int		i, j, s, t;
 	byte	*pd;
 	
-	turb = sintable + ((int)(cl.time*SPEED)&(CYCLE-1));
+	turb = sintable + ((int)(r_frame.time*SPEED)&(CYCLE-1));
 	pd = (byte *)pdest;
 
 	for (i=0 ; i<TILE_SIZE ; i++)
@@ -624,7 +621,7 @@ void R_GenTurbTile16 (pixel_t *pbasetex, void *pdest)
 	int				i, j, s, t;
 	unsigned short	*pd;
 
-	turb = sintable + ((int)(cl.time*SPEED)&(CYCLE-1));
+	turb = sintable + ((int)(r_frame.time*SPEED)&(CYCLE-1));
 	pd = (unsigned short *)pdest;
 
 	for (i=0 ; i<TILE_SIZE ; i++)
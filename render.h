@@ -143,6 +143,13 @@ void R_TeleportSplash (vec3_t org);
 
 void R_PushDlights (void);
 
+void R_SubmitView (void);		// snapshots the client state for drawing
+void R_SnapshotView (void);
+void R_StartView (void);		// draws the snapshot on the render thread
+void R_FinishView (void);		// waits for it
+void R_SyncView (void);			// waits for it from outside the screen update
+qboolean R_DeferPrint (char *msg);
+
 
 //
 // surface cache related
@@ -154,5 +161,6 @@ int	D_SurfaceCacheForRes (int width, int height);
 void D_FlushCaches (void);
 void D_DeleteSurfaceCache (void);
 void D_InitCaches (void *buffer, int size);
+void D_SCStats (int *used, int *size, int *blocks);
 void R_SetVrect (vrect_t *pvrect, vrect_t *pvrectin, int lineadj);
 
@@ -0,0 +1,496 @@
+/*
+Copyright (C) 1996-1997 Id Software, Inc.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+// repack.c -- rewrites a pak file in the order the game reads it
+
+// A host tool, built with "make repack".  It takes the file traces written
+// by quake -filetrace (see COM_TraceFile) and lays the pak out as
+//
+//	files read before the first map, in the order they were first read
+//	for each map, in the order the maps were first loaded: the files first
+//		read while it was the current map
+//	files that were never read, in their old order
+//	the directory
+//
+// so loading a map reads forwards through one stretch of the pak.
+//
+//	repack <in.pak> <out.pak> <trace> [<trace> ...]
+//	repack -bench <pak> <trace> [<trace> ...]
+//
+// -bench reads every traced file out of the pak in trace order with a cold
+// page cache and reports the time and the distance seeked, so the old and
+// new paks can be compared on the same disk.  Trace lines are matched to a
+// pak by its file name, so keep the repacked pak's name (pak0.pak) and put
+// it in another directory.
+//
+// The new pak is written to <out.pak>.tmp and renamed over <out.pak> once
+// it is complete, so a failed run leaves the old one alone and in and out
+// can be the same file.
+
+#define _FILE_OFFSET_BITS	64
+#define _XOPEN_SOURCE	600
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/time.h>
+
+#define	MAX_FILES_IN_PACK	2048
+#define	MAX_TRACE			65536
+#define	MAX_LINE			1024
+
+#define	TRACE_PREFIX		"FileTrace: "
+
+// on disk, as in common.c
+typedef struct
+{
+	char	name[56];
+	int		filepos, filelen;
+} dpackfile_t;
+
+typedef struct
+{
+	char	id[4];
+	int		dirofs;
+	int		dirlen;
+} dpackheader_t;
+
+typedef struct
+{
+	double	time;
+	char	map[64];
+	int		file;		// index in the pak directory
+} traceentry_t;
+
+dpackfile_t	pakfiles[MAX_FILES_IN_PACK];
+int			numpakfiles;
+int			pakhandle;
+
+traceentry_t	trace[MAX_TRACE];
+int			numtrace;
+
+int			order[MAX_FILES_IN_PACK];	// new position -> pak directory index
+int			numorder;
+int			placed[MAX_FILES_IN_PACK];
+
+char		tempname[MAX_LINE];		// the pak being written, removed on an error
+
+/*
+=================
+Error
+=================
+*/
+void Error (char *error, ...)
+{
+	va_list		argptr;
+
+	va_start (argptr, error);
+	fprintf (stderr, "repack: ");
+	vfprintf (stderr, error, argptr);
+	fprintf (stderr, "\n");
+	va_end (argptr);
+
+	if (tempname[0])
+		unlink (tempname);
+	exit (1);
+}
+
+/*
+=================
+LittleLong
+
+Pak files are little endian
+=================
+*/
+int LittleLong (int l)
+{
+	unsigned char	*b;
+	static int		test = 1;
+
+	if (*(char *)&test)
+		return l;
+	b = (unsigned char *)&l;
+	return b[0] | (b[1]<<8) | (b[2]<<16) | (b[3]<<24);
+}
+
+/*
+=================
+SafeRead
+=================
+*/
+void SafeRead (int handle, void *buf, int len, long long ofs)
+{
+	if (pread (handle, buf, len, ofs) != len)
+		Error ("read of %i bytes at %lli failed", len, ofs);
+}
+
+/*
+=================
+SafeWrite
+=================
+*/
+void SafeWrite (int handle, void *buf, int len)
+{
+	if (write (handle, buf, len) != len)
+		Error ("write of %i bytes failed", len);
+}
+
+/*
+=================
+LoadPak
+
+Reads the directory of a pak
+=================
+*/
+void LoadPak (char *name)
+{
+	dpackheader_t	header;
+	int				i;
+
+	pakhandle = open (name, O_RDONLY);
+	if (pakhandle == -1)
+		Error ("couldn't open %s", name);
+
+	SafeRead (pakhandle, &header, sizeof(header), 0);
+	if (memcmp (header.id, "PACK", 4))
+		Error ("%s is not a packfile", name);
+	header.dirofs = LittleLong (header.dirofs);
+	header.dirlen = LittleLong (header.dirlen);
+
+	numpakfiles = header.dirlen / sizeof(dpackfile_t);
+	if (numpakfiles > MAX_FILES_IN_PACK)
+		Error ("%s has %i files", name, numpakfiles);
+
+	SafeRead (pakhandle, pakfiles, numpakfiles*sizeof(dpackfile_t), header.dirofs);
+	for (i=0 ; i<numpakfiles ; i++)
+	{
+		pakfiles[i].filepos = LittleLong (pakfiles[i].filepos);
+		pakfiles[i].filelen = LittleLong (pakfiles[i].filelen);
+	}
+}
+
+/*
+=================
+FindPakFile
+=================
+*/
+int FindPakFile (char *name)
+{
+	int		i;
+
+	for (i=0 ; i<numpakfiles ; i++)
+		if (!strcmp (pakfiles[i].name, name))
+			return i;
+	return -1;
+}
+
+/*
+=================
+BaseName
+=================
+*/
+char *BaseName (char *path)
+{
+	char	*s;
+
+	s = strrchr (path, '/');
+	return s ? s+1 : path;
+}
+
+/*
+=================
+LoadTrace
+
+Keeps the lines of a trace that read from the pak being repacked.  Each
+line is time<TAB>map<TAB>path<TAB>name<TAB>bytes, where path is the pak the
+file came out of.
+=================
+*/
+void LoadTrace (char *name, char *pakname)
+{
+	FILE	*f;
+	char	line[MAX_LINE];
+	char	*fields[5], *s;
+	int		i, file;
+
+	f = fopen (name, "r");
+	if (!f)
+		Error ("couldn't open %s", name);
+
+	while (fgets (line, sizeof(line), f))
+	{
+		s = line;
+		if (!strncmp (s, TRACE_PREFIX, strlen(TRACE_PREFIX)))
+			s += strlen(TRACE_PREFIX);
+		s[strcspn (s, "\r\n")] = 0;
+
+		for (i=0 ; i<5 ; i++)
+		{
+			fields[i] = s;
+			s = strchr (s, '\t');
+			if (!s)
+				break;
+			*s++ = 0;
+		}
+		if (i != 4)
+			continue;		// console noise, or a short line
+
+		if (strcmp (BaseName (fields[2]), BaseName (pakname)))
+			continue;		// some other pak, or a loose file
+		file = FindPakFile (fields[3]);
+		if (file == -1)
+			continue;
+
+		if (numtrace == MAX_TRACE)
+			Error ("more than %i trace lines", MAX_TRACE);
+		trace[numtrace].time = atof (fields[0]);
+		strncpy (trace[numtrace].map, fields[1], sizeof(trace[numtrace].map)-1);
+		trace[numtrace].file = file;
+		numtrace++;
+	}
+
+	fclose (f);
+}
+
+/*
+=================
+CompareTrace
+=================
+*/
+int CompareTrace (const void *a, const void *b)
+{
+	const traceentry_t	*ta = a, *tb = b;
+
+	if (ta->time < tb->time)
+		return -1;
+	if (ta->time > tb->time)
+		return 1;
+	return ta - tb;
+}
+
+/*
+=================
+Place
+=================
+*/
+void Place (int file)
+{
+	if (placed[file])
+		return;
+	placed[file] = 1;
+	order[numorder++] = file;
+}
+
+/*
+=================
+BuildOrder
+
+Startup files, then each map's files, then everything that wasn't read
+=================
+*/
+void BuildOrder (void)
+{
+	int		i, j, nummaps;
+	char	*maps[MAX_TRACE];
+
+	qsort (trace, numtrace, sizeof(trace[0]), CompareTrace);
+
+	for (i=0 ; i<numtrace ; i++)
+		if (!trace[i].map[0])
+			Place (trace[i].file);
+
+	nummaps = 0;
+	for (i=0 ; i<numtrace ; i++)
+	{
+		if (!trace[i].map[0])
+			continue;
+		for (j=0 ; j<nummaps ; j++)
+			if (!strcmp (maps[j], trace[i].map))
+				break;
+		if (j == nummaps)
+			maps[nummaps++] = trace[i].map;
+	}
+
+	for (j=0 ; j<nummaps ; j++)
+	{
+		printf ("%s:", maps[j]);
+		for (i=0 ; i<numtrace ; i++)
+			if (!strcmp (maps[j], trace[i].map) && !placed[trace[i].file])
+			{
+				Place (trace[i].file);
+				printf (" %s", pakfiles[trace[i].file].name);
+			}
+		printf ("\n");
+	}
+
+	j = numorder;
+	for (i=0 ; i<numpakfiles ; i++)
+		Place (i);
+	printf ("%i files read, %i never read\n", j, numorder - j);
+}
+
+/*
+=================
+WritePak
+=================
+*/
+void WritePak (char *name)
+{
+	dpackheader_t	header;
+	dpackfile_t		dir[MAX_FILES_IN_PACK];
+	int				i, handle, pos, len;
+	char			*buf;
+
+	if (snprintf (tempname, sizeof(tempname), "%s.tmp", name) >= (int)sizeof(tempname))
+	{
+		tempname[0] = 0;
+		Error ("%s is too long", name);
+	}
+	handle = open (tempname, O_WRONLY|O_CREAT|O_TRUNC, 0666);
+	if (handle == -1)
+	{
+		tempname[0] = 0;
+		Error ("couldn't create %s.tmp", name);
+	}
+
+	pos = sizeof(header);
+	memset (&header, 0, sizeof(header));
+	SafeWrite (handle, &header, sizeof(header));
+
+	for (i=0 ; i<numorder ; i++)
+	{
+		dir[i] = pakfiles[order[i]];
+		len = dir[i].filelen;
+		buf = malloc (len ? len : 1);
+		if (!buf)
+			Error ("out of memory");
+		SafeRead (pakhandle, buf, len, dir[i].filepos);
+		SafeWrite (handle, buf, len);
+		free (buf);
+
+		dir[i].filepos = LittleLong (pos);
+		dir[i].filelen = LittleLong (len);
+		pos += len;
+	}
+
+// the directory goes on the end, where COM_LoadPackFile finds it through
+// the header
+	SafeWrite (handle, dir, numorder*sizeof(dpackfile_t));
+
+	memcpy (header.id, "PACK", 4);
+	header.dirofs = LittleLong (pos);
+	header.dirlen = LittleLong (numorder*sizeof(dpackfile_t));
+	if (lseek (handle, 0, SEEK_SET) != 0)
+		Error ("couldn't seek in %s", name);
+	SafeWrite (handle, &header, sizeof(header));
+	if (fsync (handle) || close (handle))
+		Error ("couldn't write %s", tempname);
+
+// the source pak is still open, so this is safe when it is the same file
+	if (rename (tempname, name))
+		Error ("couldn't rename %s to %s", tempname, name);
+	tempname[0] = 0;
+}
+
+/*
+=================
+Bench
+
+Reads the traced files in trace order from a cold page cache
+=================
+*/
+void Bench (char *name)
+{
+	struct timeval	start, end;
+	double			time;
+	long long		seek, lastend, bytes;
+	int				i, seeks;
+	dpackfile_t		*f;
+	char			*buf;
+
+	fsync (pakhandle);
+	if (posix_fadvise (pakhandle, 0, 0, POSIX_FADV_DONTNEED))
+		printf ("couldn't drop %s from the page cache, the times are warm\n", name);
+
+	seek = 0;
+	seeks = 0;
+	bytes = 0;
+	lastend = sizeof(dpackheader_t);
+	gettimeofday (&start, NULL);
+	for (i=0 ; i<numtrace ; i++)
+	{
+		f = &pakfiles[trace[i].file];
+		if (f->filepos != lastend)
+		{
+			seeks++;
+			seek += f->filepos > lastend ? f->filepos - lastend : lastend - f->filepos;
+		}
+		buf = malloc (f->filelen ? f->filelen : 1);
+		if (!buf)
+			Error ("out of memory");
+		SafeRead (pakhandle, buf, f->filelen, f->filepos);
+		free (buf);
+		lastend = f->filepos + f->filelen;
+		bytes += f->filelen;
+	}
+	gettimeofday (&end, NULL);
+
+	time = (end.tv_sec - start.tv_sec) + (end.tv_usec - start.tv_usec) / 1000000.0;
+	printf ("%s: %i reads, %lli bytes in %.1f ms, %i seeks over %lli bytes\n",
+		name, numtrace, bytes, time*1000, seeks, seek);
+}
+
+/*
+=================
+main
+=================
+*/
+int main (int argc, char **argv)
+{
+	int		i;
+
+	if (argc >= 4 && !strcmp (argv[1], "-bench"))
+	{
+		LoadPak (argv[2]);
+		for (i=3 ; i<argc ; i++)
+			LoadTrace (argv[i], argv[2]);
+		qsort (trace, numtrace, sizeof(trace[0]), CompareTrace);
+		Bench (argv[2]);
+		return 0;
+	}
+
+	if (argc < 4)
+	{
+		fprintf (stderr, "usage: repack <in.pak> <out.pak> <trace> [<trace> ...]\n"
+			"       repack -bench <pak> <trace> [<trace> ...]\n");
+		return 1;
+	}
+
+	LoadPak (argv[1]);
+	for (i=3 ; i<argc ; i++)
+		LoadTrace (argv[i], argv[1]);
+	if (!numtrace)
+		Error ("nothing in the traces was read from %s", argv[1]);
+	BuildOrder ();
+	WritePak (argv[2]);
+	return 0;
+}
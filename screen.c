@@ -638,6 +638,8 @@ void SCR_ScreenShot_f (void)
 // 
 // save the pcx file 
 // 
+	R_SyncView ();		// not while the render thread is drawing into it
+
 	D_EnableBackBufferAccess ();	// enable direct drawing of console to back
 									//  buffer
 
@@ -834,6 +836,10 @@ void SCR_UpdateScreen (void)
 	if (!scr_initialized || !con_initialized)
 		return;				// not initialized yet
 
+// the view handed to the render thread last frame has to be finished before
+// r_refdef or the video buffer are touched
+	R_FinishView ();
+
 	if (scr_viewsize.value != oldscr_viewsize)
 	{
 		oldscr_viewsize = scr_viewsize.value;
@@ -976,6 +982,8 @@ void SCR_UpdateScreen (void)
 	
 		VID_Update (&vrect);
 	}
+
+	R_StartView ();		// draw the new view while the next frame runs
 }
 
 
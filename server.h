@@ -45,6 +45,7 @@ typedef struct
 	double		lastchecktime;
 	
 	char		name[64];			// map name
+	int			protocol;			// sent in the serverinfo, from sv_protocol
 #ifdef QUAKE2
 	char		startspot[64];
 #endif
@@ -55,7 +56,9 @@ typedef struct
 	char		*sound_precache[MAX_SOUNDS];	// NULL terminated
 	char		*lightstyles[MAX_LIGHTSTYLES];
 	int			num_edicts;
-	int			max_edicts;
+	int			max_edicts;			// usable now, grows up to edict_limit
+	int			edict_limit;
+	int			freehead, freetail;	// freed edicts by number, oldest first
 	edict_t		*edicts;			// can NOT be array indexed, because
 									// edict_t is variable sized, but can
 									// be used to reference the world ent
@@ -213,10 +216,35 @@ extern	double		host_time;
 
 extern	edict_t		*sv_player;
 
+//
+// the few edict fields that the scans over every edict look at, copied out
+// into arrays so the scans stay in contiguous memory.  Anything that
+// changes one of them marks the edict dirty, and a dirty edict is copied
+// again when it is next looked at.  QC stores mark every edict they write.
+//
+typedef struct
+{
+	byte	dirty[MAX_EDICTS];
+	byte	free[MAX_EDICTS];
+	byte	movetype[MAX_EDICTS];
+	byte	visible[MAX_EDICTS];		// has a model to send
+	float	nextthink[MAX_EDICTS];
+	byte	num_leafs[MAX_EDICTS];
+	short	leafnums[MAX_EDICTS][MAX_ENT_LEAFS];
+} edicthot_t;
+
+extern	edicthot_t	sv_hot;
+extern	cvar_t		sv_hotedicts;
+extern	cvar_t		sv_protocol;
+
 //===========================================================
 
 void SV_Init (void);
 
+void SV_HotDirty (edict_t *ent);
+void SV_HotClear (void);
+void SV_HotRefresh (int e);
+
 void SV_StartParticle (vec3_t org, vec3_t dir, int color, int count);
 void SV_StartSound (edict_t *entity, int channel, char *sample, int volume,
     float attenuation);
@@ -344,6 +344,26 @@ sfx_t *S_PrecacheSound (char *name)
 	return sfx;
 }
 
+/*
+==================
+S_PrefetchSound
+
+Starts reading a sound that S_PrecacheSound will want
+==================
+*/
+void S_PrefetchSound (char *name)
+{
+	sfx_t	*sfx;
+
+	if (!sound_started || nosound.value || !precache.value)
+		return;
+
+	sfx = S_FindName (name);
+	if (Cache_Check (&sfx->cache))
+		return;
+	COM_LoadFileAsync (va("sound/%s", name));
+}
+
 
 //=============================================================================
 
@@ -46,6 +46,10 @@ void S_TouchSound (char *sample)
 {
 }
 
+void S_PrefetchSound (char *sample)
+{
+}
+
 void S_ClearBuffer (void)
 {
 }
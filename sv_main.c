@@ -26,6 +26,11 @@ server_static_t	svs;
 
 char	localmodels[MAX_MODELS][5];			// inline model names for precache
 
+// 16 lets sounds come from entities past 4095, which stock clients can't read
+cvar_t	sv_protocol = {"sv_protocol", "15"};
+
+void SV_HotBench_f (void);
+
 //============================================================================
 
 /*
@@ -57,6 +62,9 @@ void SV_Init (void)
 	Cvar_RegisterVariable (&sv_idealpitchscale);
 	Cvar_RegisterVariable (&sv_aim);
 	Cvar_RegisterVariable (&sv_nostep);
+	Cvar_RegisterVariable (&sv_hotedicts);
+	Cvar_RegisterVariable (&sv_protocol);
+	Cmd_AddCommand ("hotbench", SV_HotBench_f);
 
 	for (i=0 ; i<MAX_MODELS ; i++)
 		sprintf (localmodels[i], "*%i", i);
@@ -149,9 +157,19 @@ void SV_StartSound (edict_t *entity, int channel, char *sample, int volume,
     
 	ent = NUM_FOR_EDICT(entity);
 
-	channel = (ent<<3) | channel;
-
 	field_mask = 0;
+	if (ent >= 4096)
+	{	// doesn't fit with the channel
+		if (sv.protocol != PROTOCOL_LARGEENTITY)
+		{
+			Con_DPrintf ("SV_StartSound: entity %i needs sv_protocol %i\n",
+				ent, PROTOCOL_LARGEENTITY);
+			return;
+		}
+		field_mask |= SND_LARGEENTITY;
+	}
+	else
+		channel = (ent<<3) | channel;
 	if (volume != DEFAULT_SOUND_PACKET_VOLUME)
 		field_mask |= SND_VOLUME;
 	if (attenuation != DEFAULT_SOUND_PACKET_ATTENUATION)
@@ -164,7 +182,13 @@ void SV_StartSound (edict_t *entity, int channel, char *sample, int volume,
 		MSG_WriteByte (&sv.datagram, volume);
 	if (field_mask & SND_ATTENUATION)
 		MSG_WriteByte (&sv.datagram, attenuation*64);
-	MSG_WriteShort (&sv.datagram, channel);
+	if (field_mask & SND_LARGEENTITY)
+	{
+		MSG_WriteShort (&sv.datagram, ent);
+		MSG_WriteByte (&sv.datagram, channel);
+	}
+	else
+		MSG_WriteShort (&sv.datagram, channel);
 	MSG_WriteByte (&sv.datagram, sound_num);
 	for (i=0 ; i<3 ; i++)
 		MSG_WriteCoord (&sv.datagram, entity->v.origin[i]+0.5*(entity->v.mins[i]+entity->v.maxs[i]));
@@ -196,7 +220,7 @@ void SV_SendServerinfo (client_t *client)
 	MSG_WriteString (&client->message,message);
 
 	MSG_WriteByte (&client->message, svc_serverinfo);
-	MSG_WriteLong (&client->message, PROTOCOL_VERSION);
+	MSG_WriteLong (&client->message, sv.protocol);
 	MSG_WriteByte (&client->message, svs.maxclients);
 
 	if (!coop.value && deathmatch.value)
@@ -361,13 +385,10 @@ crosses a waterline.
 =============================================================================
 */
 
-int		fatbytes;
-byte	fatpvs[MAX_MAP_LEAFS/8];
+unsigned long	fatpvs[MAX_MAP_LEAFS/8/sizeof(unsigned long)];
 
 void SV_AddToFatPVS (vec3_t org, mnode_t *node)
 {
-	int		i;
-	byte	*pvs;
 	mplane_t	*plane;
 	float	d;
 
@@ -377,11 +398,7 @@ void SV_AddToFatPVS (vec3_t org, mnode_t *node)
 		if (node->contents < 0)
 		{
 			if (node->contents != CONTENTS_SOLID)
-			{
-				pvs = Mod_LeafPVS ( (mleaf_t *)node, sv.worldmodel);
-				for (i=0 ; i<fatbytes ; i++)
-					fatpvs[i] |= pvs[i];
-			}
+				Mod_AddLeafPVS ( (mleaf_t *)node, sv.worldmodel, fatpvs);
 			return;
 		}
 	
@@ -409,15 +426,169 @@ given point.
 */
 byte *SV_FatPVS (vec3_t org)
 {
-	fatbytes = (sv.worldmodel->numleafs+31)>>3;
-	Q_memset (fatpvs, 0, fatbytes);
+	Q_memset (fatpvs, 0, sizeof(fatpvs));
 	SV_AddToFatPVS (org, sv.worldmodel->nodes);
-	return fatpvs;
+	return (byte *)fatpvs;
 }
 
 //=============================================================================
 
 
+/*
+=============================================================================
+
+HOT EDICT FIELDS
+
+=============================================================================
+*/
+
+edicthot_t	sv_hot;
+
+cvar_t	sv_hotedicts = {"sv_hotedicts", "1"};	// scan sv_hot instead of the edicts
+
+/*
+=============
+SV_HotDirty
+
+Called after changing anything sv_hot mirrors from C.  Savegames fill in
+edicts past sv.num_edicts, so it isn't checked against that.
+=============
+*/
+void SV_HotDirty (edict_t *ent)
+{
+	int		e;
+
+	e = ((byte *)ent - (byte *)sv.edicts) / pr_edict_size;
+	if (e < 0 || e >= sv.max_edicts)
+		Sys_Error ("SV_HotDirty: bad pointer");
+	sv_hot.dirty[e] = 1;
+}
+
+/*
+=============
+SV_HotClear
+
+A new server has nothing in sv_hot that can be trusted
+=============
+*/
+void SV_HotClear (void)
+{
+	memset (sv_hot.dirty, 1, sizeof(sv_hot.dirty));
+}
+
+/*
+=============
+SV_HotRefresh
+=============
+*/
+void SV_HotRefresh (int e)
+{
+	edict_t	*ent;
+
+	ent = EDICT_NUM(e);
+	sv_hot.dirty[e] = 0;
+	sv_hot.free[e] = ent->free;
+	sv_hot.movetype[e] = (int)ent->v.movetype;
+	sv_hot.nextthink[e] = ent->v.nextthink;
+	sv_hot.visible[e] = ent->v.modelindex && pr_strings[ent->v.model];
+	sv_hot.num_leafs[e] = ent->num_leafs;
+	memcpy (sv_hot.leafnums[e], ent->leafnums, ent->num_leafs*sizeof(short));
+}
+
+#define	HOTBENCH_FLUSH	0x1000000	// more than any cache
+
+/*
+=============
+SV_HotBench_f
+
+hotbench [passes] : times the PVS cull from SV_WriteEntitiesToClient and
+the idle check from SV_Physics over every edict, reading the edicts and then
+sv_hot.  A big buffer is written between passes so each one starts from a
+cold cache, as it would after a frame's worth of other work.
+=============
+*/
+void SV_HotBench_f (void)
+{
+	int			passes, pass, mode, e, i, count, sent, idle;
+	double		start, time[2];
+	byte		*pvs;
+	edict_t		*ent, *clent;
+	vec3_t		org;
+	double		thinkby;
+	byte		*flush;
+
+	if (!sv.active)
+	{
+		Con_Printf ("no server running\n");
+		return;
+	}
+	passes = Cmd_Argc () > 1 ? Q_atoi (Cmd_Argv(1)) : 100;
+	if (passes < 1)
+		passes = 1;
+
+	clent = svs.clients[0].active ? svs.clients[0].edict : sv.edicts;
+	VectorAdd (clent->v.origin, clent->v.view_ofs, org);
+	pvs = SV_FatPVS (org);
+	thinkby = sv.time + host_frametime;
+
+	for (e=0 ; e<sv.num_edicts ; e++)
+		SV_HotRefresh (e);
+	flush = malloc (HOTBENCH_FLUSH);
+	if (!flush)
+		Sys_Error ("SV_HotBench_f: out of memory");
+
+	sent = idle = 0;
+	for (mode=0 ; mode<2 ; mode++)
+	{
+		time[mode] = 0;
+		for (pass=0 ; pass<passes ; pass++)
+		{
+			memset (flush, pass, HOTBENCH_FLUSH);
+
+			start = Sys_FloatTime ();
+			sent = idle = 0;
+			ent = NEXT_EDICT(sv.edicts);
+			for (e=1 ; e<sv.num_edicts ; e++, ent = NEXT_EDICT(ent))
+			{
+				if (mode == 0)
+				{
+					if (ent->free || (ent->v.movetype == MOVETYPE_NONE
+					&& (ent->v.nextthink <= 0 || ent->v.nextthink > thinkby)))
+						idle++;
+					if (!ent->v.modelindex || !pr_strings[ent->v.model])
+						continue;
+					count = ent->num_leafs;
+					for (i=0 ; i<count ; i++)
+						if (pvs[ent->leafnums[i] >> 3] & (1 << (ent->leafnums[i]&7)))
+							break;
+				}
+				else
+				{
+					if (sv_hot.free[e] || (sv_hot.movetype[e] == MOVETYPE_NONE
+					&& (sv_hot.nextthink[e] <= 0 || sv_hot.nextthink[e] > thinkby)))
+						idle++;
+					if (!sv_hot.visible[e])
+						continue;
+					count = sv_hot.num_leafs[e];
+					for (i=0 ; i<count ; i++)
+						if (pvs[sv_hot.leafnums[e][i] >> 3] & (1 << (sv_hot.leafnums[e][i]&7)))
+							break;
+				}
+				if (i < count)
+					sent++;
+			}
+			time[mode] += Sys_FloatTime () - start;
+		}
+	}
+
+	free (flush);
+
+	Con_Printf ("%i edicts of %i bytes, %i idle, %i in the pvs\n",
+		sv.num_edicts, pr_edict_size, idle, sent);
+	Con_Printf ("edicts %.1f us, sv_hot %.1f us per pass\n",
+		time[0]*1000000/passes, time[1]*1000000/passes);
+}
+
 /*
 =============
 SV_WriteEntitiesToClient
@@ -427,6 +598,7 @@ SV_WriteEntitiesToClient
 void SV_WriteEntitiesToClient (edict_t	*clent, sizebuf_t *msg)
 {
 	int		e, i;
+	qboolean	hot;
 	int		bits;
 	byte	*pvs;
 	vec3_t	org;
@@ -438,9 +610,24 @@ void SV_WriteEntitiesToClient (edict_t	*clent, sizebuf_t *msg)
 	pvs = SV_FatPVS (org);
 
 // send over all entities (excpet the client) that touch the pvs
+	hot = sv_hotedicts.value;
 	ent = NEXT_EDICT(sv.edicts);
 	for (e=1 ; e<sv.num_edicts ; e++, ent = NEXT_EDICT(ent))
 	{
+	// cull from sv_hot first, so edicts that aren't sent aren't touched
+		if (hot && ent != clent)
+		{
+			if (sv_hot.dirty[e])
+				SV_HotRefresh (e);
+			if (!sv_hot.visible[e])
+				continue;
+			for (i=0 ; i < sv_hot.num_leafs[e] ; i++)
+				if (pvs[sv_hot.leafnums[e][i] >> 3] & (1 << (sv_hot.leafnums[e][i]&7) ))
+					break;
+			if (i == sv_hot.num_leafs[e])
+				continue;
+		}
+
 #ifdef QUAKE2
 		// don't send if flagged for NODRAW and there are no lighting effects
 		if (ent->v.effects == EF_NODRAW)
@@ -1087,18 +1274,24 @@ void SV_SpawnServer (char *server)
 	memset (&sv, 0, sizeof(sv));
 
 	strcpy (sv.name, server);
+	if ((int)sv_protocol.value == PROTOCOL_LARGEENTITY)
+		sv.protocol = PROTOCOL_LARGEENTITY;
+	else
+		sv.protocol = PROTOCOL_VERSION;
 #ifdef QUAKE2
 	if (startspot)
 		strcpy(sv.startspot, startspot);
 #endif
 
+// start reading the world while the progs are set up
+	Mod_Prefetch (va("maps/%s.bsp", server));
+
 // load progs to get entity field count
 	PR_LoadProgs ();
 
 // allocate server memory
-	sv.max_edicts = MAX_EDICTS;
-	
-	sv.edicts = Hunk_AllocName (sv.max_edicts*pr_edict_size, "edicts");
+	ED_InitMemory ();
+	SV_HotClear ();
 
 	sv.datagram.maxsize = sizeof(sv.datagram_buf);
 	sv.datagram.cursize = 0;
@@ -1127,6 +1320,7 @@ void SV_SpawnServer (char *server)
 	
 	strcpy (sv.name, server);
 	sprintf (sv.modelname,"maps/%s.bsp", server);
+	COM_TraceMap (sv.modelname);
 	sv.worldmodel = Mod_ForName (sv.modelname, false);
 	if (!sv.worldmodel)
 	{
@@ -1161,6 +1355,7 @@ void SV_SpawnServer (char *server)
 	ent->v.modelindex = 1;		// world model
 	ent->v.solid = SOLID_BSP;
 	ent->v.movetype = MOVETYPE_PUSH;
+	SV_HotDirty (ent);
 
 	if (coop.value)
 		pr_global_struct->coop = coop.value;
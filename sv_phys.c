@@ -60,21 +60,35 @@ SV_CheckAllEnts
 */
 void SV_CheckAllEnts (void)
 {
-	int			e;
+	int			e, movetype;
 	edict_t		*check;
+	qboolean	hot;
 
 // see if any solid entities are inside the final position
+	hot = sv_hotedicts.value;
 	check = NEXT_EDICT(sv.edicts);
 	for (e=1 ; e<sv.num_edicts ; e++, check = NEXT_EDICT(check))
 	{
-		if (check->free)
-			continue;
-		if (check->v.movetype == MOVETYPE_PUSH
-		|| check->v.movetype == MOVETYPE_NONE
+		if (hot)
+		{
+			if (sv_hot.dirty[e])
+				SV_HotRefresh (e);
+			if (sv_hot.free[e])
+				continue;
+			movetype = sv_hot.movetype[e];
+		}
+		else
+		{
+			if (check->free)
+				continue;
+			movetype = check->v.movetype;
+		}
+		if (movetype == MOVETYPE_PUSH
+		|| movetype == MOVETYPE_NONE
 #ifdef QUAKE2
-		|| check->v.movetype == MOVETYPE_FOLLOW
+		|| movetype == MOVETYPE_FOLLOW
 #endif
-		|| check->v.movetype == MOVETYPE_NOCLIP)
+		|| movetype == MOVETYPE_NOCLIP)
 			continue;
 
 		if (SV_TestEntityPosition (check))
@@ -136,6 +150,7 @@ qboolean SV_RunThink (edict_t *ent)
 								// it is possible to start that way
 								// by a trigger with a local time.
 	ent->v.nextthink = 0;
+	SV_HotDirty (ent);
 	pr_global_struct->time = thinktime;
 	pr_global_struct->self = EDICT_TO_PROG(ent);
 	pr_global_struct->other = EDICT_TO_PROG(sv.edicts);
@@ -430,6 +445,11 @@ trace_t SV_PushEntity (edict_t *ent, vec3_t push)
 }					
 
 
+// what a push has moved, for putting back if it is blocked.  Too big for the
+// stack now that there can be MAX_EDICTS, and pushes don't nest.
+edict_t		*moved_edict[MAX_EDICTS];
+vec3_t		moved_from[MAX_EDICTS];
+
 /*
 ============
 SV_PushMove
@@ -443,8 +463,6 @@ void SV_PushMove (edict_t *pusher, float movetime)
 	vec3_t		mins, maxs, move;
 	vec3_t		entorig, pushorig;
 	int			num_moved;
-	edict_t		*moved_edict[MAX_EDICTS];
-	vec3_t		moved_from[MAX_EDICTS];
 
 	if (!pusher->v.velocity[0] && !pusher->v.velocity[1] && !pusher->v.velocity[2])
 	{
@@ -570,8 +588,6 @@ void SV_PushRotate (edict_t *pusher, float movetime)
 	vec3_t		move, a, amove;
 	vec3_t		entorig, pushorig;
 	int			num_moved;
-	edict_t		*moved_edict[MAX_EDICTS];
-	vec3_t		moved_from[MAX_EDICTS];
 	vec3_t		org, org2;
 	vec3_t		forward, right, up;
 
@@ -732,6 +748,7 @@ void SV_Physics_Pusher (edict_t *ent)
 	if (thinktime > oldltime && thinktime <= ent->v.ltime)
 	{
 		ent->v.nextthink = 0;
+		SV_HotDirty (ent);
 		pr_global_struct->time = sv.time;
 		pr_global_struct->self = EDICT_TO_PROG(ent);
 		pr_global_struct->other = EDICT_TO_PROG(sv.edicts);
@@ -1508,6 +1525,8 @@ void SV_Physics (void)
 {
 	int		i;
 	edict_t	*ent;
+	qboolean	hot;
+	double	thinkby;
 
 // let the progs know that a new frame has started
 	pr_global_struct->self = EDICT_TO_PROG(sv.edicts);
@@ -1520,9 +1539,24 @@ void SV_Physics (void)
 //
 // treat each object in turn
 //
+	hot = sv_hotedicts.value && !pr_global_struct->force_retouch;
+	thinkby = sv.time + host_frametime;
 	ent = sv.edicts;
 	for (i=0 ; i<sv.num_edicts ; i++, ent = NEXT_EDICT(ent))
 	{
+	// skip the edicts SV_Physics_None would do nothing for without
+	// touching them
+		if (hot && i > svs.maxclients)
+		{
+			if (sv_hot.dirty[i])
+				SV_HotRefresh (i);
+			if (sv_hot.free[i])
+				continue;
+			if (sv_hot.movetype[i] == MOVETYPE_NONE
+			&& (sv_hot.nextthink[i] <= 0 || sv_hot.nextthink[i] > thinkby))
+				continue;
+		}
+
 		if (ent->free)
 			continue;
 
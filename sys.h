@@ -33,9 +33,21 @@ void Sys_FileClose (int handle);
 void Sys_FileSeek (int handle, int position);
 int Sys_FileRead (int handle, void *dest, int count);
 int Sys_FileWrite (int handle, void *data, int count);
+void *Sys_FileMap (int handle, int size);
+// returns the first size bytes of the file mapped into memory, or NULL if
+// the platform can't map files.  The mapping is never released.
 int	Sys_FileTime (char *path);
 void Sys_mkdir (char *path);
 
+//
+// hunk memory
+//
+void *Sys_HunkReserve (int size);
+// returns size bytes of zeroed address space that only takes up memory
+// once it is touched, or NULL if the platform can't reserve memory
+void Sys_HunkRelease (void *ptr, int size);
+// zeroes part of the hunk, giving the whole pages in it back to the system
+
 //
 // memory protection
 //
@@ -665,6 +665,41 @@ int Sys_FileRead (int handle, void *dest, int count)
    return read (handle, dest, count);
 }
 
+/*
+================
+Sys_FileMap
+
+Memory mapped pak files are not supported here
+================
+*/
+void *Sys_FileMap (int handle, int size)
+{
+	return NULL;
+}
+
+/*
+================
+Sys_HunkReserve
+
+The hunk is a plain block of memory here
+================
+*/
+void *Sys_HunkReserve (int size)
+{
+	return NULL;
+}
+
+/*
+================
+Sys_HunkRelease
+================
+*/
+void Sys_HunkRelease (void *ptr, int size)
+{
+	memset (ptr, 0, size);
+}
+
+
 int Sys_FileWrite (int handle, void *data, int count)
 {
 	return write (handle, data, count);
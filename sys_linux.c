@@ -239,6 +239,71 @@ int Sys_FileRead (int handle, void *dest, int count)
 {
     return read (handle, dest, count);
 }
+/*
+================
+Sys_FileMap
+
+The pages are shared through the page cache with every other process
+mapping the same file.  The mapping is read only, so a stray write into a
+mapped lump faults instead of quietly getting a private copy of the page.
+================
+*/
+void *Sys_FileMap (int handle, int size)
+{
+	void	*base;
+
+	base = mmap (NULL, size, PROT_READ, MAP_PRIVATE, handle, 0);
+	if (base == MAP_FAILED)
+		return NULL;
+	return base;
+}
+
+
+/*
+================
+Sys_HunkReserve
+
+The pages aren't backed by memory or swap until they are touched, so the
+hunk can be reserved far bigger than any map needs
+================
+*/
+void *Sys_HunkReserve (int size)
+{
+	void	*base;
+
+	base = mmap (NULL, size, PROT_READ|PROT_WRITE,
+		MAP_PRIVATE|MAP_ANONYMOUS|MAP_NORESERVE, -1, 0);
+	if (base == MAP_FAILED)
+		return NULL;
+	return base;
+}
+
+/*
+================
+Sys_HunkRelease
+
+The whole pages go back to the system and read as zero when next touched,
+the partial pages at the ends are cleared
+================
+*/
+void Sys_HunkRelease (void *ptr, int size)
+{
+	byte	*start, *end, *p;
+	long	pagesize;
+
+	p = ptr;
+	pagesize = sysconf (_SC_PAGESIZE);
+	start = (byte *)(((long)p + pagesize - 1) & ~(pagesize - 1));
+	end = (byte *)(((long)p + size) & ~(pagesize - 1));
+	if (end <= start || madvise (start, end - start, MADV_DONTNEED))
+	{
+		memset (p, 0, size);
+		return;
+	}
+	memset (p, 0, start - p);
+	memset (end, 0, p + size - end);
+}
+
 
 void Sys_DebugLog(char *file, char *fmt, ...)
 {
@@ -371,16 +436,17 @@ int main (int c, char **v)
 	parms.argc = com_argc;
 	parms.argv = com_argv;
 
-#ifdef GLQUAKE
-	parms.memsize = 16*1024*1024;
-#else
-	parms.memsize = 8*1024*1024;
-#endif
-
 	j = COM_CheckParm("-mem");
 	if (j)
 		parms.memsize = (int) (Q_atof(com_argv[j+1]) * 1024 * 1024);
-	parms.membase = malloc (parms.memsize);
+	else
+	{
+	// only the pages the hunk touches take up memory, so reserve plenty
+		parms.memsize = HUNK_RESERVE;
+	}
+	parms.membase = Sys_HunkReserve (parms.memsize);
+	if (!parms.membase)
+		parms.membase = malloc (parms.memsize);
 
 	parms.basedir = basedir;
 // caching is disabled by default, use -cachedir to enable
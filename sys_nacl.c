@@ -16,7 +16,7 @@
 //#include <sys/shm.h>
 #include <sys/stat.h>
 #include <sys/wait.h>
-//#include <sys/mman.h>
+#include <sys/mman.h>
 #endif
 
 #include "quakedef.h"
@@ -168,6 +168,68 @@ int Sys_FileRead (int handle, void *dst, int count)
 	return read(handle, dst, count);
 }
 
+/*
+================
+Sys_FileMap
+
+Memory mapped pak files are not supported here
+================
+*/
+void *Sys_FileMap (int handle, int size)
+{
+	return NULL;
+}
+
+#define	NACL_MAP_PAGESIZE	0x10000	// mmap works in 64k units
+
+/*
+================
+Sys_HunkReserve
+
+Untouched pages of an anonymous mapping don't take up memory
+================
+*/
+void *Sys_HunkReserve (int size)
+{
+	void	*base;
+
+	base = mmap (NULL, size, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+	if (base == MAP_FAILED)
+		return NULL;
+	return base;
+}
+
+/*
+================
+Sys_HunkRelease
+
+There's no madvise, so the whole 64k allocation units in the range are
+mapped over with fresh zero pages and the rest is cleared
+================
+*/
+void Sys_HunkRelease (void *ptr, int size)
+{
+	byte	*start, *end, *p;
+	void	*remap;
+
+	p = ptr;
+	start = (byte *)(((long)p + NACL_MAP_PAGESIZE - 1) & ~(NACL_MAP_PAGESIZE - 1));
+	end = (byte *)(((long)p + size) & ~(NACL_MAP_PAGESIZE - 1));
+	if (end > start)
+	{
+		remap = mmap (start, end - start, PROT_READ|PROT_WRITE,
+			MAP_PRIVATE|MAP_ANONYMOUS|MAP_FIXED, -1, 0);
+		if (remap == start)
+		{
+			memset (p, 0, start - p);
+			memset (end, 0, p + size - end);
+			return;
+		}
+	}
+	memset (p, 0, size);
+}
+
+
 int Sys_FileWrite (int handle, void *src, int count)
 {
 	// Saves in a pretend file in memory.
@@ -294,8 +356,13 @@ extern int quake_main (int c, char **v)
 //	signal(SIGFPE, floating_point_exception_handler);
 	signal(SIGFPE, SIG_IGN);
 
-	parms.memsize = 32*1024*1024;
-	parms.membase = malloc (parms.memsize);
+	parms.memsize = HUNK_RESERVE;
+	parms.membase = Sys_HunkReserve (parms.memsize);
+	if (!parms.membase)
+	{
+		parms.memsize = 32*1024*1024;
+		parms.membase = malloc (parms.memsize);
+	}
 	parms.basedir = basedir;
 	parms.cachedir = cachedir;
 
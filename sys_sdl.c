@@ -231,6 +231,41 @@ int Sys_FileRead (int handle, void *dst, int count)
 		
 }
 
+/*
+================
+Sys_FileMap
+
+Memory mapped pak files are not supported here
+================
+*/
+void *Sys_FileMap (int handle, int size)
+{
+	return NULL;
+}
+
+/*
+================
+Sys_HunkReserve
+
+The hunk is a plain block of memory here
+================
+*/
+void *Sys_HunkReserve (int size)
+{
+	return NULL;
+}
+
+/*
+================
+Sys_HunkRelease
+================
+*/
+void Sys_HunkRelease (void *ptr, int size)
+{
+	memset (ptr, 0, size);
+}
+
+
 int Sys_FileWrite (int handle, void *src, int count)
 {
 	char *data;
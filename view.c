@@ -78,6 +78,10 @@ Used by view and sv_user
 */
 vec3_t	forward, right, up;
 
+// where the view is heard from, since r_origin and vpn may belong to a view
+// still being drawn
+vec3_t	v_listenorigin, v_listenforward, v_listenright, v_listenup;
+
 float V_CalcRoll (vec3_t angles, vec3_t velocity)
 {
 	float	sign;
@@ -1015,7 +1019,21 @@ void V_RenderView (void)
 			V_CalcRefdef ();
 	}
 
+	VectorCopy (r_refdef.vieworg, v_listenorigin);
+	AngleVectors (r_refdef.viewangles, v_listenforward, v_listenright,
+				  v_listenup);
+
+#ifdef GLQUAKE
 	R_PushDlights ();
+#else
+	if (!lcd_x.value)
+		R_SubmitView ();	// drawn now, or on the render thread
+	else
+	{
+		R_SnapshotView ();
+		R_PushDlights ();
+	}
+#endif
 
 	if (lcd_x.value)
 	{
@@ -1048,10 +1066,12 @@ void V_RenderView (void)
 		vid.rowbytes >>= 1;
 		vid.aspect *= 2;
 	}
+#ifdef GLQUAKE
 	else
 	{
 		R_RenderView ();
 	}
+#endif
 
 #ifndef GLQUAKE
 	if (crosshair.value)
@@ -27,6 +27,8 @@ extern float v_blend[4];
 
 extern cvar_t lcd_x;
 
+extern vec3_t	v_listenorigin, v_listenforward, v_listenright, v_listenup;
+
 
 void V_Init (void);
 void V_RenderView (void);
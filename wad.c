@@ -72,7 +72,11 @@ void W_LoadWadFile (char *filename)
 	unsigned		i;
 	int				infotableofs;
 	
-	wad_base = COM_LoadHunkFile (filename);
+	wad_base = NULL;
+	if (!bigendien)		// the pics are swapped in place
+		wad_base = COM_MapFile (filename);
+	if (!wad_base)
+		wad_base = COM_LoadHunkFile (filename);
 	if (!wad_base)
 		Sys_Error ("W_LoadWadFile: couldn't load %s", filename);
 
@@ -86,14 +90,18 @@ void W_LoadWadFile (char *filename)
 		
 	wad_numlumps = LittleLong(header->numlumps);
 	infotableofs = LittleLong(header->infotableofs);
-	wad_lumps = (lumpinfo_t *)(wad_base + infotableofs);
+
+// the directory is cleaned up in a hunk copy, so a mapped file is never
+// written to
+	wad_lumps = Hunk_AllocName (wad_numlumps * sizeof(lumpinfo_t), "wadinfo");
+	memcpy (wad_lumps, wad_base + infotableofs, wad_numlumps * sizeof(lumpinfo_t));
 	
 	for (i=0, lump_p = wad_lumps ; i<wad_numlumps ; i++,lump_p++)
 	{
 		lump_p->filepos = LittleLong(lump_p->filepos);
 		lump_p->size = LittleLong(lump_p->size);
 		W_CleanupName (lump_p->name, lump_p->name);
-		if (lump_p->type == TYP_QPIC)
+		if (lump_p->type == TYP_QPIC && bigendien)
 			SwapPic ( (qpic_t *)(wad_base + lump_p->filepos));
 	}
 }
@@ -440,6 +440,7 @@ void SV_LinkEdict (edict_t *ent, qboolean touch_triggers)
 	ent->num_leafs = 0;
 	if (ent->v.modelindex)
 		SV_FindTouchedLeafs (ent, sv.worldmodel->nodes);
+	SV_HotDirty (ent);
 
 	if (ent->v.solid == SOLID_NOT)
 		return;
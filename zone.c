@@ -21,17 +21,24 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 #include "quakedef.h"
 
+#ifdef USE_PTHREADS
+#include <pthread.h>
+#endif
+
 #define	DYNAMIC_SIZE	0xc000
 
 #define	ZONEID	0x1d4a11
+#define	SLABID	0x1d4a12
 #define MINFRAGMENT	64
 
+// the id is the second to last int of both headers, so Z_Free can tell a
+// block from a slab chunk
 typedef struct memblock_s
 {
 	int		size;           // including the header and possibly tiny fragments
 	int     tag;            // a tag of 0 is a free block
-	int     id;        		// should be ZONEID
 	struct memblock_s       *next, *prev;
+	int     id;        		// should be ZONEID
 	int		pad;			// pad to 64 bit boundary
 } memblock_t;
 
@@ -42,12 +49,39 @@ typedef struct
 	memblock_t	*rover;
 } memzone_t;
 
+typedef struct
+{
+	int				id;			// should be SLABID
+	unsigned short	slabofs;	// back to the slab_t
+	short			tag;		// 0 when free
+} slabchunk_t;
+
+typedef struct slab_s
+{
+	struct slab_s	*next, *prev;	// slabs of the class with free chunks
+	int				sizeclass;
+	int				numfree;
+	slabchunk_t		*freelist;		// linked through the first word of the data
+	int				pad;
+} slab_t;
+
+typedef struct
+{
+	int		allocs, frees;
+	int		bytes, peakbytes;		// asked for, not counting headers
+} zonetag_t;
+
 
 /*
 ==============================================================================
 
 						ZONE MEMORY ALLOCATION
 
+Small allocations come out of slabs: zone blocks cut into SLAB_CHUNKS equal
+chunks, with a list per size class of the slabs that have free chunks, so
+they are allocated and freed without searching.  Bigger ones get a block of
+their own from the rover.
+
 There is never any space between memblocks, and there will never be two
 contiguous free memblocks.
 
@@ -58,9 +92,29 @@ all big things are allocated on the hunk.
 ==============================================================================
 */
 
+#define	SLAB_CHUNKS		16
+#define	SLAB_TAG		0x7fff		// zone blocks holding slabs
+#define	NUM_SIZECLASSES	7
+#define	MAX_SLAB_SIZE	128
+
+#define	MAX_ZONE_TAGS	8			// higher tags are counted in the last
+
+int			slab_sizes[NUM_SIZECLASSES] = {16, 24, 32, 48, 64, 96, 128};
+byte		slab_class[MAX_SLAB_SIZE/8 + 1];	// by (size+7)/8
+slab_t		slab_lists[NUM_SIZECLASSES];		// partial slabs, circular
+slab_t		*slab_spare[NUM_SIZECLASSES];		// an empty slab kept on the list
+
+zonetag_t	zone_tags[MAX_ZONE_TAGS];
+int			zone_calls;
+qboolean	zone_noslabs;		// for zonebench
+
+cvar_t		zone_check = {"zone_check", "0"};	// check the heap every n calls
+
 memzone_t	*mainzone;
 
 void Z_ClearZone (memzone_t *zone, int size);
+void *Z_BlockMalloc (int size, int tag);
+void Z_BlockFree (memblock_t *block);
 
 
 /*
@@ -71,9 +125,11 @@ Z_ClearZone
 void Z_ClearZone (memzone_t *zone, int size)
 {
 	memblock_t	*block;
+	int			i, c;
 	
 // set the entire zone to one free block
 
+	zone->size = size;
 	zone->blocklist.next = zone->blocklist.prev = block =
 		(memblock_t *)( (byte *)zone + sizeof(memzone_t) );
 	zone->blocklist.tag = 1;	// in use block
@@ -85,6 +141,178 @@ void Z_ClearZone (memzone_t *zone, int size)
 	block->tag = 0;			// free block
 	block->id = ZONEID;
 	block->size = size - sizeof(memzone_t);
+
+// no slabs yet
+	for (i=0, c=0 ; i<=MAX_SLAB_SIZE/8 ; i++)
+	{
+		while (slab_sizes[c] < i*8)
+			c++;
+		slab_class[i] = c;
+	}
+	for (i=0 ; i<NUM_SIZECLASSES ; i++)
+	{
+		slab_lists[i].next = slab_lists[i].prev = &slab_lists[i];
+		slab_spare[i] = NULL;
+	}
+}
+
+
+/*
+========================
+Z_SampleCheck
+
+The heap is checked every zone_check calls when debugging
+========================
+*/
+void Z_SampleCheck (void)
+{
+	if (!zone_check.value)
+		return;
+	if (++zone_calls < zone_check.value)
+		return;
+	zone_calls = 0;
+	Z_CheckHeap ();
+}
+
+
+/*
+========================
+Z_CountTag
+========================
+*/
+zonetag_t *Z_CountTag (int tag)
+{
+	if (tag < 0 || tag >= MAX_ZONE_TAGS)
+		tag = MAX_ZONE_TAGS - 1;
+	return &zone_tags[tag];
+}
+
+
+/*
+========================
+Z_ChunkSize
+========================
+*/
+int Z_ChunkSize (int sizeclass)
+{
+	return sizeof(slabchunk_t) + slab_sizes[sizeclass];
+}
+
+
+/*
+========================
+Z_NewSlab
+
+Cuts a zone block into free chunks of the class
+========================
+*/
+slab_t *Z_NewSlab (int sizeclass)
+{
+	slab_t		*slab;
+	slabchunk_t	*chunk;
+	int			i, chunksize;
+
+	chunksize = Z_ChunkSize (sizeclass);
+	slab = Z_BlockMalloc (sizeof(slab_t) + SLAB_CHUNKS*chunksize, SLAB_TAG);
+	if (!slab)
+		return NULL;
+
+	slab->sizeclass = sizeclass;
+	slab->numfree = SLAB_CHUNKS;
+	slab->freelist = NULL;
+	for (i=SLAB_CHUNKS-1 ; i>=0 ; i--)
+	{
+		chunk = (slabchunk_t *)((byte *)(slab+1) + i*chunksize);
+		chunk->id = SLABID;
+		chunk->slabofs = (byte *)chunk - (byte *)slab;
+		chunk->tag = 0;
+		*(slabchunk_t **)(chunk+1) = slab->freelist;
+		slab->freelist = chunk;
+	}
+
+	slab->next = slab_lists[sizeclass].next;
+	slab->prev = &slab_lists[sizeclass];
+	slab->next->prev = slab;
+	slab->prev->next = slab;
+	return slab;
+}
+
+
+/*
+========================
+Z_SlabMalloc
+========================
+*/
+void *Z_SlabMalloc (int size, int tag)
+{
+	int			sizeclass;
+	slab_t		*slab;
+	slabchunk_t	*chunk;
+
+	sizeclass = slab_class[(size+7)>>3];
+	slab = slab_lists[sizeclass].next;
+	if (slab == &slab_lists[sizeclass])
+	{
+		slab = Z_NewSlab (sizeclass);
+		if (!slab)
+			return NULL;
+	}
+	if (slab == slab_spare[sizeclass])
+		slab_spare[sizeclass] = NULL;
+
+	chunk = slab->freelist;
+	slab->freelist = *(slabchunk_t **)(chunk+1);
+	chunk->tag = tag;
+	if (!--slab->numfree)
+	{	// full, off the list
+		slab->next->prev = slab->prev;
+		slab->prev->next = slab->next;
+	}
+
+	return (void *)(chunk+1);
+}
+
+
+/*
+========================
+Z_SlabFree
+========================
+*/
+void Z_SlabFree (slabchunk_t *chunk)
+{
+	slab_t		*slab;
+	int			sizeclass;
+
+	if (!chunk->tag)
+		Sys_Error ("Z_Free: freed a freed pointer");
+
+	slab = (slab_t *)((byte *)chunk - chunk->slabofs);
+	sizeclass = slab->sizeclass;
+	chunk->tag = 0;
+	*(slabchunk_t **)(chunk+1) = slab->freelist;
+	slab->freelist = chunk;
+
+	if (!slab->numfree++)
+	{	// back on the list
+		slab->next = slab_lists[sizeclass].next;
+		slab->prev = &slab_lists[sizeclass];
+		slab->next->prev = slab;
+		slab->prev->next = slab;
+	}
+
+	if (slab->numfree < SLAB_CHUNKS)
+		return;
+
+// keep one empty slab per class, so a class that allocates and frees the
+// same chunk doesn't keep making and breaking a slab
+	if (!slab_spare[sizeclass])
+	{
+		slab_spare[sizeclass] = slab;
+		return;
+	}
+	slab->next->prev = slab->prev;
+	slab->prev->next = slab->next;
+	Z_BlockFree ((memblock_t *)((byte *)slab - sizeof(memblock_t)));
 }
 
 
@@ -95,17 +323,50 @@ Z_Free
 */
 void Z_Free (void *ptr)
 {
-	memblock_t	*block, *other;
+	memblock_t	*block;
+	zonetag_t	*t;
+	int			id;
 	
 	if (!ptr)
 		Sys_Error ("Z_Free: NULL pointer");
 
-	block = (memblock_t *) ( (byte *)ptr - sizeof(memblock_t));
-	if (block->id != ZONEID)
+	Z_SampleCheck ();
+
+	id = ((int *)ptr)[-2];
+	if (id == SLABID)
+	{
+		slabchunk_t	*chunk;
+
+		chunk = (slabchunk_t *)ptr - 1;
+		t = Z_CountTag (chunk->tag);
+		t->frees++;
+		t->bytes -= slab_sizes[((slab_t *)((byte *)chunk - chunk->slabofs))->sizeclass];
+		Z_SlabFree (chunk);
+		return;
+	}
+	if (id != ZONEID)
 		Sys_Error ("Z_Free: freed a pointer without ZONEID");
+
+	block = (memblock_t *) ( (byte *)ptr - sizeof(memblock_t));
 	if (block->tag == 0)
 		Sys_Error ("Z_Free: freed a freed pointer");
 
+	t = Z_CountTag (block->tag);
+	t->frees++;
+	t->bytes -= block->size - sizeof(memblock_t) - 4;
+	Z_BlockFree (block);
+}
+
+
+/*
+========================
+Z_BlockFree
+========================
+*/
+void Z_BlockFree (memblock_t *block)
+{
+	memblock_t	*other;
+
 	block->tag = 0;		// mark as free
 	
 	other = block->prev;
@@ -140,7 +401,6 @@ void *Z_Malloc (int size)
 {
 	void	*buf;
 	
-Z_CheckHeap ();	// DEBUG
 	buf = Z_TagMalloc (size, 1);
 	if (!buf)
 		Sys_Error ("Z_Malloc: failed on allocation of %i bytes",size);
@@ -151,12 +411,44 @@ Z_CheckHeap ();	// DEBUG
 
 void *Z_TagMalloc (int size, int tag)
 {
-	int		extra;
-	memblock_t	*start, *rover, *new, *base;
+	void		*buf;
+	zonetag_t	*t;
+	int			bytes;
 
 	if (!tag)
 		Sys_Error ("Z_TagMalloc: tried to use a 0 tag");
 
+	Z_SampleCheck ();
+
+	if (size <= MAX_SLAB_SIZE && !zone_noslabs)
+	{
+		buf = Z_SlabMalloc (size, tag);
+		if (buf)
+			bytes = slab_sizes[slab_class[(size+7)>>3]];
+	}
+	else
+	{
+		buf = Z_BlockMalloc (size, tag);
+		if (buf)
+			bytes = ((memblock_t *)buf - 1)->size - sizeof(memblock_t) - 4;
+	}
+	if (!buf)
+		return NULL;
+
+	t = Z_CountTag (tag);
+	t->allocs++;
+	t->bytes += bytes;
+	if (t->bytes > t->peakbytes)
+		t->peakbytes = t->bytes;
+
+	return buf;
+}
+
+void *Z_BlockMalloc (int size, int tag)
+{
+	int		extra;
+	memblock_t	*start, *rover, *new, *base;
+
 //
 // scan through the block list looking for the first free block
 // of sufficient size
@@ -210,29 +502,58 @@ void *Z_TagMalloc (int size, int tag)
 
 /*
 ========================
-Z_Print
+Z_Stats_f
+
+zonestats : the zone by tag, the slabs, and how broken up the free space is
 ========================
 */
-void Z_Print (memzone_t *zone)
+void Z_Stats_f (void)
 {
 	memblock_t	*block;
-	
-	Con_Printf ("zone size: %i  location: %p\n",mainzone->size,mainzone);
-	
-	for (block = zone->blocklist.next ; ; block = block->next)
+	slab_t		*slab;
+	zonetag_t	*t;
+	int			i, used, free, freeblocks, largest, slabs, slabbytes;
+	int			classslabs[NUM_SIZECLASSES], classfree[NUM_SIZECLASSES];
+
+	used = free = freeblocks = largest = slabs = slabbytes = 0;
+	memset (classslabs, 0, sizeof(classslabs));
+	memset (classfree, 0, sizeof(classfree));
+	for (block = mainzone->blocklist.next ; block != &mainzone->blocklist ; block = block->next)
 	{
-		Con_Printf ("block:%p    size:%7i    tag:%3i\n",
-			block, block->size, block->tag);
-		
-		if (block->next == &zone->blocklist)
-			break;			// all blocks have been hit	
-		if ( (byte *)block + block->size != (byte *)block->next)
-			Con_Printf ("ERROR: block size does not touch the next block\n");
-		if ( block->next->prev != block)
-			Con_Printf ("ERROR: next block doesn't have proper back link\n");
-		if (!block->tag && !block->next->tag)
-			Con_Printf ("ERROR: two consecutive free blocks\n");
+		if (!block->tag)
+		{
+			free += block->size;
+			freeblocks++;
+			if (block->size > largest)
+				largest = block->size;
+			continue;
+		}
+		used += block->size;
+		if (block->tag == SLAB_TAG)
+		{
+			slab = (slab_t *)(block+1);
+			slabs++;
+			slabbytes += block->size;
+			classslabs[slab->sizeclass]++;
+			classfree[slab->sizeclass] += slab->numfree;
+		}
 	}
+
+	Con_Printf ("zone: %i bytes, %i used, %i free in %i blocks\n",
+		mainzone->size, used, free, freeblocks);
+	Con_Printf ("largest free block %i, %i%% of the free space is fragmented\n",
+		largest, free ? 100 - largest*100/free : 0);
+	Con_Printf ("%i slabs in %i bytes:\n", slabs, slabbytes);
+	for (i=0 ; i<NUM_SIZECLASSES ; i++)
+		if (classslabs[i])
+			Con_Printf ("%4i bytes: %3i slabs, %4i of %4i chunks used\n", slab_sizes[i],
+				classslabs[i], classslabs[i]*SLAB_CHUNKS - classfree[i],
+				classslabs[i]*SLAB_CHUNKS);
+	for (i=0, t=zone_tags ; i<MAX_ZONE_TAGS ; i++, t++)
+		if (t->allocs)
+			Con_Printf ("tag %i%s: %i allocs, %i frees, %i bytes, %i peak\n", i,
+				i == MAX_ZONE_TAGS-1 ? "+" : "", t->allocs, t->frees, t->bytes,
+				t->peakbytes);
 }
 
 
@@ -244,9 +565,26 @@ Z_CheckHeap
 void Z_CheckHeap (void)
 {
 	memblock_t	*block;
+	slab_t		*slab;
+	slabchunk_t	*chunk;
+	int			i, numfree;
 	
 	for (block = mainzone->blocklist.next ; ; block = block->next)
 	{
+		if (block->tag == SLAB_TAG)
+		{
+			slab = (slab_t *)(block+1);
+			for (numfree=0, chunk=slab->freelist ; chunk ; chunk=*(slabchunk_t **)(chunk+1))
+			{
+				if (chunk->id != SLABID || chunk->tag
+				|| (byte *)chunk - (byte *)slab != chunk->slabofs)
+					Sys_Error ("Z_CheckHeap: bad free chunk in slab\n");
+				if (++numfree > SLAB_CHUNKS)
+					break;
+			}
+			if (numfree != slab->numfree)
+				Sys_Error ("Z_CheckHeap: slab free count is wrong\n");
+		}
 		if (block->next == &mainzone->blocklist)
 			break;			// all blocks have been hit	
 		if ( (byte *)block + block->size != (byte *)block->next)
@@ -255,7 +593,85 @@ void Z_CheckHeap (void)
 			Sys_Error ("Z_CheckHeap: next block doesn't have proper back link\n");
 		if (!block->tag && !block->next->tag)
 			Sys_Error ("Z_CheckHeap: two consecutive free blocks\n");
+		if (block->tag && *(int *)((byte *)block + block->size - 4) != ZONEID)
+			Sys_Error ("Z_CheckHeap: memory trashed at the end of a block\n");
 	}
+
+	for (i=0 ; i<NUM_SIZECLASSES ; i++)
+		for (slab = slab_lists[i].next ; slab != &slab_lists[i] ; slab = slab->next)
+			if (slab->sizeclass != i || !slab->numfree || slab->next->prev != slab)
+				Sys_Error ("Z_CheckHeap: bad slab list\n");
+}
+
+
+/*
+========================
+Z_Bench_f
+
+zonebench [rounds] [live] : times the console and progs string churn of
+aliases, cvar sets and command buffers with the old allocator and the slabs.
+The more strings are live, the longer the rover has to search.
+========================
+*/
+#define	MAX_BENCH_LIVE	1024
+
+void Z_Bench_f (void)
+{
+	void		*live[MAX_BENCH_LIVE];
+	int			rounds, numlive, pass, i, j, size, failed;
+	unsigned	seed;
+	double		start, time[3];
+	float		savecheck;
+
+	rounds = Cmd_Argc () > 1 ? Q_atoi (Cmd_Argv(1)) : 100000;
+	numlive = Cmd_Argc () > 2 ? Q_atoi (Cmd_Argv(2)) : 256;
+	if (numlive < 1 || numlive > MAX_BENCH_LIVE)
+		numlive = MAX_BENCH_LIVE;
+	savecheck = zone_check.value;
+
+	// 0: every call checks the heap and goes to the rover, as it used to
+	// 1: the rover without the checks
+	// 2: slabs for the small ones
+	for (pass=0 ; pass<3 ; pass++)
+	{
+		zone_check.value = pass == 0;
+		zone_noslabs = pass < 2;
+		memset (live, 0, sizeof(live));
+		seed = 1;
+		failed = 0;
+
+		start = Sys_FloatTime ();
+		for (i=0 ; i<rounds ; i++)
+		{
+			seed = seed * 1103515245 + 12345;
+			j = (seed >> 16) % numlive;
+			if (live[j])
+				Z_Free (live[j]);
+
+		// mostly names and short values, now and then a long command line
+			if ((seed >> 8) % 16)
+				size = 4 + (seed >> 4) % 60;
+			else
+				size = 64 + (seed >> 4) % 448;
+			live[j] = Z_TagMalloc (size, MAX_ZONE_TAGS-1);
+			if (!live[j])
+				failed++;
+		}
+		time[pass] = Sys_FloatTime () - start;
+
+		if (pass == 2)
+			Z_Stats_f ();
+		for (j=0 ; j<numlive ; j++)
+			if (live[j])
+				Z_Free (live[j]);
+		if (failed)
+			Con_Printf ("%i allocations failed\n", failed);
+	}
+
+	zone_check.value = savecheck;
+	zone_noslabs = false;
+	Con_Printf ("%i rounds, %i live: checked rover %.1f ms, rover %.1f ms, slabs %.1f ms\n",
+		rounds, numlive, time[0]*1000, time[1]*1000, time[2]*1000);
 }
 
 //============================================================================
@@ -269,6 +685,8 @@ typedef struct
 	char	name[8];
 } hunk_t;
 
+#define	HUNK_RELEASE_MIN	0x10000	// freed ranges smaller than this are just cleared
+
 byte	*hunk_base;
 int		hunk_size;
 
@@ -431,6 +849,44 @@ void *Hunk_Alloc (int size)
 	return Hunk_AllocName (size, "unknown");
 }
 
+/*
+===================
+Hunk_Release
+
+Clears freed hunk memory.  Big ranges, like a map's worth, are handed back
+to the system so the memory the game takes up follows what it is using.
+===================
+*/
+void Hunk_Release (byte *p, int size)
+{
+	if (size >= HUNK_RELEASE_MIN)
+		Sys_HunkRelease (p, size);
+	else
+		memset (p, 0, size);
+}
+
+/*
+===================
+Hunk_Reserve
+
+Address space outside the hunk for an array that has to grow in place, like
+the edicts.  It reads as zero until it is written, and Hunk_Release clears
+it and gives the pages back.  Where the system can't reserve, it is all
+allocated up front.
+===================
+*/
+void *Hunk_Reserve (int size, char *name)
+{
+	void	*p;
+
+	p = Sys_HunkReserve (size);
+	if (!p)
+		p = calloc (1, size);
+	if (!p)
+		Sys_Error ("Hunk_Reserve: failed on %i bytes for %s", size, name);
+	return p;
+}
+
 int	Hunk_LowMark (void)
 {
 	return hunk_low_used;
@@ -440,10 +896,67 @@ void Hunk_FreeToLowMark (int mark)
 {
 	if (mark < 0 || mark > hunk_low_used)
 		Sys_Error ("Hunk_FreeToLowMark: bad mark %i", mark);
-	memset (hunk_base + mark, 0, hunk_low_used - mark);
+	Hunk_Release (hunk_base + mark, hunk_low_used - mark);
 	hunk_low_used = mark;
 }
 
+/*
+===================
+Hunk_LowPointer
+
+The start of what has been allocated on the low hunk since mark, so the
+blocks can be saved as an image for Hunk_LoadImage
+===================
+*/
+void *Hunk_LowPointer (int mark)
+{
+	if (mark < 0 || mark > hunk_low_used)
+		Sys_Error ("Hunk_LowPointer: bad mark %i", mark);
+	return hunk_base + mark;
+}
+
+/*
+===================
+Hunk_LoadImage
+
+Reads size bytes saved from Hunk_LowPointer back onto the low hunk, block
+headers and all, so the hunk is laid out as it was when they were saved.
+Returns NULL, with nothing allocated, if the blocks don't check out.
+===================
+*/
+void *Hunk_LoadImage (int handle, int size)
+{
+	hunk_t	*h;
+	int		mark;
+
+	if (size < sizeof(hunk_t) || (size & 15))
+		return NULL;
+	if (hunk_size - hunk_low_used - hunk_high_used < size)
+		return NULL;
+
+	mark = hunk_low_used;
+	h = (hunk_t *)(hunk_base + mark);
+	hunk_low_used += size;
+
+	if (Sys_FileRead (handle, h, size) != size)
+	{
+		Hunk_FreeToLowMark (mark);
+		return NULL;
+	}
+
+	for ( ; (byte *)h != hunk_base + hunk_low_used ; h = (hunk_t *)((byte *)h+h->size))
+	{
+		if (h->sentinal != HUNK_SENTINAL || h->size < sizeof(hunk_t)
+		|| (h->size & 15) || h->size > hunk_low_used - ((byte *)h - hunk_base))
+		{
+			Hunk_FreeToLowMark (mark);
+			return NULL;
+		}
+	}
+
+	return hunk_base + mark;
+}
+
 int	Hunk_HighMark (void)
 {
 	if (hunk_tempactive)
@@ -464,7 +977,7 @@ void Hunk_FreeToHighMark (int mark)
 	}
 	if (mark < 0 || mark > hunk_high_used)
 		Sys_Error ("Hunk_FreeToHighMark: bad mark %i", mark);
-	memset (hunk_base + hunk_size - hunk_high_used, 0, hunk_high_used - mark);
+	Hunk_Release (hunk_base + hunk_size - hunk_high_used, hunk_high_used - mark);
 	hunk_high_used = mark;
 }
 
@@ -540,18 +1053,540 @@ void *Hunk_TempAlloc (int size)
 	return buf;
 }
 
+/*
+===============================================================================
+
+FRAME MEMORY
+
+Each thread has an arena that temporaries like va() strings and command
+arguments are bumped out of, without locks or frees.  The main thread's is
+reset at the end of every host frame and a worker's whenever it runs out of
+jobs, so anything from Frame_Alloc lasts until then.  An arena keeps the
+blocks it has grown to, so the memory it hands out stays valid even after a
+reset, the way the old static buffers did.
+
+Threads that never reset, like the sound callback, wrap around to the start
+of their arena when it fills instead of growing.
+
+===============================================================================
+*/
+
+#define	ARENA_BLOCK		0x10000
+
+typedef struct arenablock_s
+{
+	struct arenablock_s	*next;
+	int					size;		// of the data, which follows the header
+} arenablock_t;
+
+#define	ARENA_HEADER	((sizeof(arenablock_t)+15)&~15)
+
+typedef struct arena_s
+{
+	char			name[16];
+	qboolean		scoped;			// reset by its thread
+	arenablock_t	*blocks, *current;
+	int				used;			// in current
+	int				total;			// bytes in all the blocks
+	int				frameused;		// since the last reset
+	int				peak;
+	int				resets;
+	struct arena_s	*next;
+} arena_t;
+
+arena_t		*frame_arenas;
+arena_t		frame_main = {"main", true};
+
+#ifdef USE_PTHREADS
+pthread_key_t	frame_key;
+pthread_once_t	frame_once = PTHREAD_ONCE_INIT;
+pthread_mutex_t	frame_lock = PTHREAD_MUTEX_INITIALIZER;	// for the arena list
+#endif
+
+/*
+============
+Frame_NewBlock
+============
+*/
+arenablock_t *Frame_NewBlock (arena_t *a, int size)
+{
+	arenablock_t	*b;
+
+	if (size < ARENA_BLOCK)
+		size = ARENA_BLOCK;
+	b = malloc (ARENA_HEADER + size);
+	if (!b)
+		Sys_Error ("Frame_Alloc: failed on %i bytes", size);
+	b->size = size;
+	a->total += size;
+	return b;
+}
+
+/*
+============
+Frame_AddArena
+============
+*/
+void Frame_AddArena (arena_t *a)
+{
+#ifdef USE_PTHREADS
+	pthread_mutex_lock (&frame_lock);
+#endif
+	a->next = frame_arenas;
+	frame_arenas = a;
+#ifdef USE_PTHREADS
+	pthread_mutex_unlock (&frame_lock);
+#endif
+}
+
+#ifdef USE_PTHREADS
+/*
+============
+Frame_CreateKey
+
+The thread that first asks for an arena is the main thread
+============
+*/
+void Frame_CreateKey (void)
+{
+	pthread_key_create (&frame_key, NULL);
+	pthread_setspecific (frame_key, &frame_main);
+	Frame_AddArena (&frame_main);
+}
+#endif
+
+/*
+============
+Frame_NewArena
+============
+*/
+arena_t *Frame_NewArena (char *name, qboolean scoped)
+{
+	arena_t	*a;
+
+	a = malloc (sizeof(*a));
+	if (!a)
+		Sys_Error ("Frame_NewArena: out of memory");
+	memset (a, 0, sizeof(*a));
+	Q_strncpy (a->name, name, sizeof(a->name)-1);
+	a->scoped = scoped;
+	Frame_AddArena (a);
+	return a;
+}
+
+/*
+============
+Frame_Arena
+
+The calling thread's arena
+============
+*/
+arena_t *Frame_Arena (void)
+{
+#ifdef USE_PTHREADS
+	arena_t	*a;
+
+	pthread_once (&frame_once, Frame_CreateKey);
+	a = pthread_getspecific (frame_key);
+	if (!a)
+	{
+		a = Frame_NewArena ("thread", false);
+		pthread_setspecific (frame_key, a);
+	}
+	return a;
+#else
+	if (!frame_arenas)
+		Frame_AddArena (&frame_main);
+	return &frame_main;
+#endif
+}
+
+/*
+============
+Frame_InitThread
+
+Gives a new thread an arena that it will reset itself
+============
+*/
+void Frame_InitThread (char *name)
+{
+#ifdef USE_PTHREADS
+	pthread_once (&frame_once, Frame_CreateKey);
+	pthread_setspecific (frame_key, Frame_NewArena (name, true));
+#endif
+}
+
+/*
+============
+Frame_Alloc
+
+Returns 8 byte aligned memory that lasts until the thread's next
+Frame_Reset.  It is not cleared.
+============
+*/
+void *Frame_Alloc (int size)
+{
+	arena_t			*a;
+	arenablock_t	*b;
+	void			*p;
+
+	a = Frame_Arena ();
+	size = (size + 7) & ~7;
+
+	if (!a->current || a->used + size > a->current->size)
+	{
+	// move on to the next block big enough, wrapping around if the arena
+	// never gets reset, and add one if there isn't one
+		for (b = a->current ? a->current->next : a->blocks ; b ; b = b->next)
+			if (b->size >= size)
+				break;
+		if (!b && !a->scoped)
+		{
+			for (b = a->blocks ; b && b != a->current ; b = b->next)
+				if (b->size >= size)
+					break;
+			a->frameused = 0;		// high-water is per lap
+		}
+		if (!b || b == a->current)
+		{
+			b = Frame_NewBlock (a, size);
+			if (a->current)
+			{
+				b->next = a->current->next;
+				a->current->next = b;
+			}
+			else
+			{
+				b->next = a->blocks;
+				a->blocks = b;
+			}
+		}
+		a->current = b;
+		a->used = 0;
+	}
+
+	p = (byte *)a->current + ARENA_HEADER + a->used;
+	a->used += size;
+	a->frameused += size;
+	if (a->frameused > a->peak)
+		a->peak = a->frameused;
+	return p;
+}
+
+/*
+============
+Frame_Reset
+
+Everything the thread got from Frame_Alloc can be reused
+============
+*/
+void Frame_Reset (void)
+{
+	arena_t	*a;
+
+	a = Frame_Arena ();
+	a->current = a->blocks;
+	a->used = 0;
+	a->frameused = 0;
+	a->resets++;
+}
+
+/*
+============
+Frame_Init
+
+Claims the main arena for the thread that starts the engine, before any
+workers exist
+============
+*/
+void Frame_Init (void)
+{
+	Frame_Arena ();
+}
+
+/*
+============
+Frame_Stats_f
+============
+*/
+void Frame_Stats_f (void)
+{
+	arena_t	*a;
+
+	for (a = frame_arenas ; a ; a = a->next)
+		Con_Printf ("%-8s %6i KB, %6i KB high-water, %i resets%s\n", a->name,
+			a->total / 1024, a->peak / 1024, a->resets,
+			a->scoped ? "" : " (wraps)");
+}
+
+/*
+===============================================================================
+
+CACHE MEMORY
+
+Cached objects are malloced, and kept on a list with the most recently used
+at the head.  When the cache would go over cachesize kilobytes the oldest
+objects are thrown out, and their users' data set to NULL so the next
+Cache_Check misses and the owner loads them again.  Anything used this
+frame or last is pinned, because its pointer may still be in use by the
+renderer or the sound callback, so the cache can go over its budget when
+everything in it is in use.
+
+The sound callback runs on its own thread and loads sounds through the
+cache, so it's locked.
+
+===============================================================================
+*/
+
+#define	CACHE_VICTIMS	8		// oldest objects looked at for the biggest to throw out
+#define	MAX_CACHE_NAMES	1024
+
+typedef struct cache_system_s
+{
+	int						size;		// including the header
+	cache_user_t			*user;
+	char					name[16];
+	int						lastframe;	// host_framecount when last used
+	struct cache_system_s	*prev, *next;	// LRU list, most recent first
+} cache_system_t;
+
+// the data follows the header, 16 byte aligned from the malloc
+#define	CACHE_HEADER	((sizeof(cache_system_t)+15)&~15)
+
+typedef struct
+{
+	char	name[16];
+	int		bytes;			// in the cache now
+	int		loads;
+	int		evictions;
+} cachename_t;
+
+cvar_t	cachesize = {"cachesize", "16384"};	// kilobytes
+
+cache_system_t	cache_head;		// the list is circular through here
+int				cache_used;		// bytes, headers included
+int				cache_peak;
+int				cache_count;
+
+int				cache_hits, cache_misses, cache_allocs;
+int				cache_evictions, cache_evictedbytes, cache_overbudget;
+
+cachename_t		cache_names[MAX_CACHE_NAMES];
+int				cache_numnames;
+
+#ifdef USE_PTHREADS
+pthread_mutex_t	cache_lock = PTHREAD_MUTEX_INITIALIZER;
+#define	CACHE_LOCK()	pthread_mutex_lock (&cache_lock)
+#define	CACHE_UNLOCK()	pthread_mutex_unlock (&cache_lock)
+#else
+#define	CACHE_LOCK()
+#define	CACHE_UNLOCK()
+#endif
+
+/*
+============
+Cache_Name
+
+The accounting for a name, or NULL if the table is full
+============
+*/
+cachename_t *Cache_Name (char *name)
+{
+	int				i;
+	cachename_t		*cn;
+
+	for (i=0, cn=cache_names ; i<cache_numnames ; i++, cn++)
+		if (!strncmp (cn->name, name, sizeof(cn->name)-1))
+			return cn;
+	if (cache_numnames == MAX_CACHE_NAMES)
+		return NULL;
+	cache_numnames++;
+	Q_strncpy (cn->name, name, sizeof(cn->name)-1);
+	return cn;
+}
+
+/*
+============
+Cache_Unlink
+============
+*/
+void Cache_Unlink (cache_system_t *cs)
+{
+	cs->prev->next = cs->next;
+	cs->next->prev = cs->prev;
+}
+
+/*
+============
+Cache_LinkHead
+============
+*/
+void Cache_LinkHead (cache_system_t *cs)
+{
+	cs->next = cache_head.next;
+	cs->prev = &cache_head;
+	cache_head.next->prev = cs;
+	cache_head.next = cs;
+}
+
+/*
+============
+Cache_Release
+
+Frees an object and tells its user it's gone
+============
+*/
+void Cache_Release (cache_system_t *cs)
+{
+	cachename_t		*cn;
+
+	cn = Cache_Name (cs->name);
+	if (cn)
+		cn->bytes -= cs->size;
+	Cache_Unlink (cs);
+	cache_used -= cs->size;
+	cache_count--;
+	cs->user->data = NULL;
+	free (cs);
+}
+
+/*
+============
+Cache_Evict
+
+Throws out the biggest of the oldest objects that aren't pinned, returns
+false if there aren't any
+============
+*/
+qboolean Cache_Evict (void)
+{
+	cache_system_t	*cs, *victim;
+	cachename_t		*cn;
+	int				i;
+
+	victim = NULL;
+	for (i=0, cs=cache_head.prev ; cs != &cache_head && i<CACHE_VICTIMS ; cs=cs->prev)
+	{
+		if (cs->lastframe >= host_framecount - 1)
+			continue;	// pinned
+		if (!victim || cs->size > victim->size)
+			victim = cs;
+		i++;
+	}
+	if (!victim)
+		return false;
+
+	cn = Cache_Name (victim->name);
+	if (cn)
+		cn->evictions++;
+	cache_evictions++;
+	cache_evictedbytes += victim->size;
+	Cache_Release (victim);
+	return true;
+}
+
+/*
+============
+Cache_Trim
+
+Evicts until size more bytes fit in the budget
+============
+*/
+void Cache_Trim (int size)
+{
+	while (cache_used + size > cachesize.value * 1024)
+		if (!Cache_Evict ())
+		{
+			cache_overbudget++;
+			break;
+		}
+}
+
+/*
+============
+Cache_Flush
+
+Throws out everything that isn't pinned
+============
+*/
+void Cache_Flush (void)
+{
+	CACHE_LOCK ();
+	while (Cache_Evict ())
+		;
+	CACHE_UNLOCK ();
+}
+
+/*
+============
+Cache_Stats_f
+
+cachestats [names|clear]
+============
+*/
+void Cache_Stats_f (void)
+{
+	int				i;
+	cachename_t		*cn;
+
+	if (Cmd_Argc () == 2 && !Q_strcmp (Cmd_Argv(1), "clear"))
+	{
+		CACHE_LOCK ();
+		cache_hits = cache_misses = cache_allocs = 0;
+		cache_evictions = cache_evictedbytes = cache_overbudget = 0;
+		cache_peak = cache_used;
+		for (i=0, cn=cache_names ; i<cache_numnames ; i++, cn++)
+			cn->loads = cn->evictions = 0;
+		CACHE_UNLOCK ();
+		return;
+	}
+
+	CACHE_LOCK ();
+	if (Cmd_Argc () == 2 && !Q_strcmp (Cmd_Argv(1), "names"))
+	{
+		for (i=0, cn=cache_names ; i<cache_numnames ; i++, cn++)
+			if (cn->bytes || cn->evictions)
+				Con_Printf ("%-16s %8i bytes %4i loads %4i evicted\n", cn->name,
+					cn->bytes, cn->loads, cn->evictions);
+	}
+	Con_Printf ("cache: %i objects, %i of %i KB used, %i KB peak\n", cache_count,
+		cache_used / 1024, (int)cachesize.value, cache_peak / 1024);
+	Con_Printf ("%i hits, %i misses, %i allocs, %i evicted (%i KB), %i over budget\n",
+		cache_hits, cache_misses, cache_allocs, cache_evictions,
+		cache_evictedbytes / 1024, cache_overbudget);
+	CACHE_UNLOCK ();
+}
+
+/*
+============
+Cache_Init
+============
+*/
+void Cache_Init (void)
+{
+	cache_head.next = cache_head.prev = &cache_head;
+
+	Cvar_RegisterVariable (&cachesize);
+	Cmd_AddCommand ("flush", Cache_Flush);
+	Cmd_AddCommand ("cachestats", Cache_Stats_f);
+}
+
 /*
 ==============
 Cache_Free
 
-Frees the memory.
+Frees the memory and sets the user's data to NULL
 ==============
 */
 void Cache_Free (cache_user_t *c)
 {
-	free(c->data);
-}
+	if (!c->data)
+		Sys_Error ("Cache_Free: not allocated");
 
+	CACHE_LOCK ();
+	Cache_Release ((cache_system_t *)((byte *)c->data - CACHE_HEADER));
+	CACHE_UNLOCK ();
+}
 
 
 /*
@@ -561,7 +1596,27 @@ Cache_Check
 */
 void *Cache_Check (cache_user_t *c)
 {
-	return c->data;
+	cache_system_t	*cs;
+	void			*data;
+
+	CACHE_LOCK ();
+	data = c->data;
+	if (!data)
+	{
+		cache_misses++;
+		CACHE_UNLOCK ();
+		return NULL;
+	}
+
+// move to the head of the LRU list and pin it for this frame
+	cs = (cache_system_t *)((byte *)data - CACHE_HEADER);
+	Cache_Unlink (cs);
+	Cache_LinkHead (cs);
+	cs->lastframe = host_framecount;
+	cache_hits++;
+	CACHE_UNLOCK ();
+
+	return data;
 }
 
 
@@ -572,16 +1627,373 @@ Cache_Alloc
 */
 void *Cache_Alloc (cache_user_t *c, int size, char *name)
 {
+	cache_system_t	*cs;
+	cachename_t		*cn;
+
 	if (c->data)
 		Sys_Error ("Cache_Alloc: allready allocated");
 	
 	if (size <= 0)
 		Sys_Error ("Cache_Alloc: size %i", size);
 
-        // Basically, make the cache not really a cache...  we always allow
-        // allocations, and we never throw anything away.
-        c->data = malloc(size);
-        return c->data;
+	size = CACHE_HEADER + ((size+15)&~15);
+
+	CACHE_LOCK ();
+	Cache_Trim (size);
+
+	cs = malloc (size);
+	if (!cs)
+		Sys_Error ("Cache_Alloc: failed on %i bytes", size);
+	memset (cs, 0, size);
+	cs->size = size;
+	cs->user = c;
+	Q_strncpy (cs->name, name, sizeof(cs->name)-1);
+	cs->lastframe = host_framecount;
+	Cache_LinkHead (cs);
+
+	cache_used += size;
+	if (cache_used > cache_peak)
+		cache_peak = cache_used;
+	cache_count++;
+	cache_allocs++;
+	cn = Cache_Name (cs->name);
+	if (cn)
+	{
+		cn->bytes += size;
+		cn->loads++;
+	}
+
+	c->data = (byte *)cs + CACHE_HEADER;
+	CACHE_UNLOCK ();
+
+	return c->data;
+}
+
+/*
+===============================================================================
+
+MEMORY TELEMETRY
+
+Every mem_interval frames the hunk, zone, cache, frame arenas, surface cache
+and edicts are sampled.  memstats prints the last sample along with the peaks
+and how much each has grown since the first one, which is what shows a slow
+leak over a map rotation.  memlog writes every sample to a file as a line of
+JSON or CSV.
+
+===============================================================================
+*/
+
+typedef struct
+{
+	int		frame;
+	double	time;
+	int		hunklow, hunkhigh, hunkfree;
+	int		zoneused, zonefree, zonelargest;
+	int		zonetags[MAX_ZONE_TAGS];	// bytes
+	int		cacheused, cachecount;
+	int		framebytes;					// all the arenas' blocks
+	int		surfused, surfsize, surfblocks;
+	int		edicts, freeedicts;
+} memsample_t;
+
+cvar_t	mem_interval = {"mem_interval", "60"};	// frames, 0 stops sampling
+
+memsample_t	mem_last, mem_first, mem_peak;
+int			mem_samples;
+
+FILE		*mem_log;
+qboolean	mem_logcsv;
+
+/*
+============
+Memory_Sample
+============
+*/
+void Memory_Sample (memsample_t *s)
+{
+	memblock_t	*block;
+	arena_t		*a;
+	edict_t		*e;
+	int			i;
+
+	memset (s, 0, sizeof(*s));
+	s->frame = host_framecount;
+	s->time = Sys_FloatTime ();
+
+	s->hunklow = hunk_low_used;
+	s->hunkhigh = hunk_high_used;
+	s->hunkfree = hunk_size - hunk_low_used - hunk_high_used;
+
+	for (block = mainzone->blocklist.next ; block != &mainzone->blocklist ; block = block->next)
+	{
+		if (block->tag)
+			s->zoneused += block->size;
+		else
+		{
+			s->zonefree += block->size;
+			if (block->size > s->zonelargest)
+				s->zonelargest = block->size;
+		}
+	}
+	for (i=0 ; i<MAX_ZONE_TAGS ; i++)
+		s->zonetags[i] = zone_tags[i].bytes;
+
+	CACHE_LOCK ();
+	s->cacheused = cache_used;
+	s->cachecount = cache_count;
+	CACHE_UNLOCK ();
+
+#ifdef USE_PTHREADS
+	pthread_mutex_lock (&frame_lock);
+#endif
+	for (a = frame_arenas ; a ; a = a->next)
+		s->framebytes += a->total;
+#ifdef USE_PTHREADS
+	pthread_mutex_unlock (&frame_lock);
+#endif
+
+#ifndef GLQUAKE
+	R_SyncView ();		// the render thread allocates from the surface cache
+	D_SCStats (&s->surfused, &s->surfsize, &s->surfblocks);
+#endif
+
+	if (sv.active)
+	{
+		s->edicts = sv.num_edicts;
+		for (i=0 ; i<sv.num_edicts ; i++)
+		{
+			e = EDICT_NUM(i);
+			if (e->free)
+				s->freeedicts++;
+		}
+	}
+}
+
+/*
+============
+Memory_Peak
+============
+*/
+#define	PEAK(field)	if (s->field > p->field) p->field = s->field
+
+void Memory_Peak (memsample_t *p, memsample_t *s)
+{
+	int		i;
+
+	PEAK(hunklow);
+	PEAK(hunkhigh);
+	PEAK(hunkfree);
+	PEAK(zoneused);
+	PEAK(zonefree);
+	PEAK(zonelargest);
+	for (i=0 ; i<MAX_ZONE_TAGS ; i++)
+		PEAK(zonetags[i]);
+	PEAK(cacheused);
+	PEAK(cachecount);
+	PEAK(framebytes);
+	PEAK(surfused);
+	PEAK(surfsize);
+	PEAK(surfblocks);
+	PEAK(edicts);
+	PEAK(freeedicts);
+}
+
+#undef PEAK
+
+/*
+============
+Memory_WriteJSON
+============
+*/
+void Memory_WriteJSON (FILE *f, memsample_t *s)
+{
+	int				i;
+	cachename_t		*cn;
+	char			*sep;
+
+	fprintf (f, "{\"frame\":%i,\"time\":%.3f,\"map\":\"%s\"", s->frame, s->time, sv.name);
+	fprintf (f, ",\"hunk\":{\"low\":%i,\"high\":%i,\"free\":%i}",
+		s->hunklow, s->hunkhigh, s->hunkfree);
+	fprintf (f, ",\"zone\":{\"used\":%i,\"free\":%i,\"largest\":%i,\"tags\":[",
+		s->zoneused, s->zonefree, s->zonelargest);
+	for (i=0 ; i<MAX_ZONE_TAGS ; i++)
+		fprintf (f, i ? ",%i" : "%i", s->zonetags[i]);
+	fprintf (f, "]},\"cache\":{\"used\":%i,\"objects\":%i,\"names\":{",
+		s->cacheused, s->cachecount);
+	sep = "";
+	CACHE_LOCK ();
+	for (i=0, cn=cache_names ; i<cache_numnames ; i++, cn++)
+		if (cn->bytes)
+		{
+			fprintf (f, "%s\"%s\":%i", sep, cn->name, cn->bytes);
+			sep = ",";
+		}
+	CACHE_UNLOCK ();
+	fprintf (f, "}},\"frame_arenas\":%i", s->framebytes);
+	fprintf (f, ",\"surfcache\":{\"used\":%i,\"size\":%i,\"blocks\":%i}",
+		s->surfused, s->surfsize, s->surfblocks);
+	fprintf (f, ",\"edicts\":{\"used\":%i,\"free\":%i}}\n", s->edicts, s->freeedicts);
+}
+
+/*
+============
+Memory_WriteCSV
+
+Only the totals; the cache names don't fit in columns
+============
+*/
+void Memory_WriteCSV (FILE *f, memsample_t *s)
+{
+	int		i;
+
+	fprintf (f, "%i,%.3f,%s,%i,%i,%i,%i,%i,%i", s->frame, s->time, sv.name,
+		s->hunklow, s->hunkhigh, s->hunkfree,
+		s->zoneused, s->zonefree, s->zonelargest);
+	for (i=0 ; i<MAX_ZONE_TAGS ; i++)
+		fprintf (f, ",%i", s->zonetags[i]);
+	fprintf (f, ",%i,%i,%i,%i,%i,%i,%i,%i\n", s->cacheused, s->cachecount,
+		s->framebytes, s->surfused, s->surfsize, s->surfblocks,
+		s->edicts, s->freeedicts);
+}
+
+/*
+============
+Memory_TakeSample
+============
+*/
+void Memory_TakeSample (void)
+{
+	Memory_Sample (&mem_last);
+	if (!mem_samples)
+		mem_first = mem_last;
+	mem_samples++;
+	Memory_Peak (&mem_peak, &mem_last);
+
+	if (mem_log)
+	{
+		if (mem_logcsv)
+			Memory_WriteCSV (mem_log, &mem_last);
+		else
+			Memory_WriteJSON (mem_log, &mem_last);
+		fflush (mem_log);
+	}
+}
+
+/*
+============
+Memory_Frame
+
+Called at the end of every host frame
+============
+*/
+void Memory_Frame (void)
+{
+	int		interval;
+
+	interval = (int)mem_interval.value;
+	if (interval > 0 && !(host_framecount % interval))
+		Memory_TakeSample ();
+}
+
+/*
+============
+Memory_Stats_f
+
+memstats [clear]
+============
+*/
+void Memory_Stats_f (void)
+{
+	memsample_t	*s, *p, *f;
+	int			i;
+
+	if (Cmd_Argc () == 2 && !Q_strcmp (Cmd_Argv(1), "clear"))
+	{
+		mem_samples = 0;
+		memset (&mem_peak, 0, sizeof(mem_peak));
+		return;
+	}
+
+	Memory_TakeSample ();
+	s = &mem_last;
+	p = &mem_peak;
+	f = &mem_first;
+
+	Con_Printf ("%i samples over %.0f seconds, now / peak / growth in KB\n",
+		mem_samples, s->time - f->time);
+	Con_Printf ("hunk low  %6i %6i %+6i\n", s->hunklow/1024, p->hunklow/1024,
+		(s->hunklow - f->hunklow)/1024);
+	Con_Printf ("hunk high %6i %6i %+6i\n", s->hunkhigh/1024, p->hunkhigh/1024,
+		(s->hunkhigh - f->hunkhigh)/1024);
+	Con_Printf ("zone      %6i %6i %+6i\n", s->zoneused/1024, p->zoneused/1024,
+		(s->zoneused - f->zoneused)/1024);
+	Con_Printf ("cache     %6i %6i %+6i\n", s->cacheused/1024, p->cacheused/1024,
+		(s->cacheused - f->cacheused)/1024);
+	Con_Printf ("arenas    %6i %6i %+6i\n", s->framebytes/1024, p->framebytes/1024,
+		(s->framebytes - f->framebytes)/1024);
+	Con_Printf ("surfcache %6i %6i %+6i of %i\n", s->surfused/1024, p->surfused/1024,
+		(s->surfused - f->surfused)/1024, s->surfsize/1024);
+	for (i=0 ; i<MAX_ZONE_TAGS ; i++)
+		if (s->zonetags[i] || p->zonetags[i])
+			Con_Printf ("zone tag %i%s: %i bytes, %i peak, %+i\n", i,
+				i == MAX_ZONE_TAGS-1 ? "+" : "", s->zonetags[i], p->zonetags[i],
+				s->zonetags[i] - f->zonetags[i]);
+	Con_Printf ("edicts %i, %i free, %i peak\n", s->edicts, s->freeedicts, p->edicts);
+}
+
+/*
+============
+Memory_Log_f
+
+memlog <file> [csv] : logs every sample to the file in the game directory
+memlog : stops
+============
+*/
+void Memory_Log_f (void)
+{
+	char	name[MAX_OSPATH];
+	int		i, len;
+
+	if (mem_log)
+	{
+		fclose (mem_log);
+		mem_log = NULL;
+		Con_Printf ("memlog closed\n");
+	}
+	if (Cmd_Argc () < 2)
+		return;
+
+	if (strstr (Cmd_Argv(1), ".."))
+	{
+		Con_Printf ("Relative pathnames are not allowed.\n");
+		return;
+	}
+	mem_logcsv = Cmd_Argc () > 2 && !Q_strcmp (Cmd_Argv(2), "csv");
+	len = snprintf (name, sizeof(name), "%s/%s", com_gamedir, Cmd_Argv(1));
+	if (len < 0 || len + 5 >= sizeof(name))	// room for the extension
+	{
+		Con_Printf ("memlog: %s is too long.\n", Cmd_Argv(1));
+		return;
+	}
+	COM_DefaultExtension (name, mem_logcsv ? ".csv" : ".json");
+	mem_log = fopen (name, "w");
+	if (!mem_log)
+	{
+		Con_Printf ("ERROR: couldn't open %s.\n", name);
+		return;
+	}
+
+	if (mem_logcsv)
+	{
+		fprintf (mem_log, "frame,time,map,hunk_low,hunk_high,hunk_free,"
+			"zone_used,zone_free,zone_largest");
+		for (i=0 ; i<MAX_ZONE_TAGS ; i++)
+			fprintf (mem_log, ",zone_tag%i", i);
+		fprintf (mem_log, ",cache_used,cache_objects,frame_arenas,"
+			"surfcache_used,surfcache_size,surfcache_blocks,edicts,edicts_free\n");
+	}
+	Con_Printf ("logging memory every %i frames to %s\n",
+		(int)mem_interval.value, name);
 }
 
 //============================================================================
@@ -612,5 +2024,18 @@ void Memory_Init (void *buf, int size)
 	}
 	mainzone = Hunk_AllocName (zonesize, "zone" );
 	Z_ClearZone (mainzone, zonesize);
+
+	Cvar_RegisterVariable (&zone_check);
+	Cmd_AddCommand ("zonestats", Z_Stats_f);
+	Cmd_AddCommand ("zonebench", Z_Bench_f);
+	Cmd_AddCommand ("framestats", Frame_Stats_f);
+
+	Frame_Init ();
+
+	Cache_Init ();
+
+	Cvar_RegisterVariable (&mem_interval);
+	Cmd_AddCommand ("memstats", Memory_Stats_f);
+	Cmd_AddCommand ("memlog", Memory_Log_f);
 }
 
@@ -40,8 +40,9 @@ strings from command input.  There is only about 48K for it, allocated at
 the very bottom of the hunk.
 
 Cache_??? Cache memory is for objects that can be dynamically loaded and
-can usefully stay persistant between levels.  The size of the cache
-fluctuates from level to level.
+can usefully stay persistant between levels.  It is malloced, up to the
+cachesize cvar in kilobytes, and the least recently used objects are thrown
+out to stay under it.
 
 To allocate a cachable object
 
@@ -84,14 +85,13 @@ Zone block
 */
 
 void Memory_Init (void *buf, int size);
+void Memory_Frame (void);	// samples for memstats and memlog
 
 void Z_Free (void *ptr);
 void *Z_Malloc (int size);			// returns 0 filled memory
 void *Z_TagMalloc (int size, int tag);
 
-void Z_DumpHeap (void);
-void Z_CheckHeap (void);
-int Z_FreeMemory (void);
+void Z_CheckHeap (void);		// every zone_check calls when it is set
 
 void *Hunk_Alloc (int size);		// returns 0 filled memory
 void *Hunk_AllocName (int size, char *name);
@@ -100,14 +100,25 @@ void *Hunk_HighAllocName (int size, char *name);
 
 int	Hunk_LowMark (void);
 void Hunk_FreeToLowMark (int mark);
+void *Hunk_LowPointer (int mark);
+void *Hunk_LoadImage (int handle, int size);
 
 int	Hunk_HighMark (void);
 void Hunk_FreeToHighMark (int mark);
 
 void *Hunk_TempAlloc (int size);
 
+void *Hunk_Reserve (int size, char *name);	// reads as zero until written
+void Hunk_Release (byte *p, int size);		// clears, giving big ranges back
+
 void Hunk_Check (void);
 
+void *Frame_Alloc (int size);
+// temporary memory that lasts until the end of the host frame, or for worker
+// threads until they run out of jobs
+void Frame_Reset (void);
+void Frame_InitThread (char *name);
+
 typedef struct cache_user_s
 {
 	void	*data;
@@ -118,10 +129,14 @@ void *Cache_Check (cache_user_t *c);
 // if present, otherwise returns NULL
 
 void Cache_Free (cache_user_t *c);
+// frees the data and sets it to NULL
 
 void *Cache_Alloc (cache_user_t *c, int size, char *name);
-// Returns NULL if all purgable data was tossed and there still
-// wasn't enough room.
+// Never fails; goes over the budget if everything in the cache was used
+// this frame or last.
+
+void Cache_Init (void);
+void Cache_Flush (void);
 
 
 